@@ -0,0 +1,209 @@
+/* geojson, Copyright (c) 2013-2020 Yuriy Yakimenko
+ *
+ * Permission to use, copy, modify, distribute, and sell this software and its
+ * documentation for any purpose is hereby granted without fee, provided that
+ * the above copyright notice appear in all copies and that both that
+ * copyright notice and this permission notice appear in supporting
+ * documentation.  No representations are made about the suitability of this
+ * software for any purpose.  It is provided "as is" without express or
+ * implied warranty.
+ */
+
+#include "ConvexPolygon.h"
+#include "Parallel.h"
+
+#include <algorithm>
+
+using namespace std;
+
+static inline double dot (const MapObject & a, const MapObject & b)
+{
+	return a.X() * b.X() + a.Y() * b.Y() + a.Z() * b.Z();
+}
+
+ConvexPolygon::ConvexPolygon () : center(0, 0, 1), innerCos(2), outerCos(2)
+{
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+// vertices where polygon goes straight on are dropped, all other turns must be to the same
+// side, and vertices must be seen from vertex 0 in order, within less than half turn
+// (otherwise it winds more than once).
+//////////////////////////////////////////////////////////////////////////////////////////
+
+bool ConvexPolygon::build (const vector<MapObject> & polygon)
+{
+	vertices.clear();
+	edges.clear();
+	diagonals.clear();
+
+	innerCos = outerCos = 2;
+
+	vector<MapObject> ring;
+
+	for (auto & pt : polygon)
+	{
+		if (ring.empty() || !(ring.back() == pt)) ring.push_back (pt);
+	}
+
+	while (ring.size() > 1 && ring.back() == ring.front()) ring.pop_back();
+
+	size_t n = ring.size();
+
+	if (n < 3)
+	{
+		return false;
+	}
+
+	vector<int> turns (n);
+
+	int direction = 0;
+
+	for (size_t i = 0; i < n; i++)
+	{
+		turns[i] = MapObject::orientation (ring[(i + n - 1) % n], ring[i], ring[(i + 1) % n]);
+
+		if (turns[i] == 0) continue;
+
+		if (direction == 0) direction = turns[i];
+
+		if (turns[i] != direction)
+		{
+			return false;
+		}
+	}
+
+	if (direction == 0)
+	{
+		return false;
+	}
+
+	for (size_t i = 0; i < n; i++)
+	{
+		if (turns[i] != 0) vertices.push_back (ring[i]);
+	}
+
+	if (direction < 0)
+	{
+		reverse (vertices.begin(), vertices.end());
+	}
+
+	n = vertices.size();
+
+	for (size_t i = 2; i < n; i++)
+	{
+		if (MapObject::orientation (vertices[0], vertices[i - 1], vertices[i]) <= 0)
+		{
+			vertices.clear();
+			return false;
+		}
+	}
+
+	double x = 0, y = 0, z = 0;
+
+	for (auto & v : vertices)
+	{
+		x += v.X(); y += v.Y(); z += v.Z();
+	}
+
+	double length = sqrt (x * x + y * y + z * z);
+
+	if (length < 1e-9)
+	{
+		vertices.clear();
+		return false;
+	}
+
+	center = MapObject (x / length, y / length, z / length);
+
+	for (size_t i = 0; i < n; i++)
+	{
+		edges.push_back (MapObject::crossProduct (vertices[i], vertices[(i + 1) % n]));
+	}
+
+	for (size_t i = 1; i < n; i++)
+	{
+		diagonals.push_back (MapObject::crossProduct (vertices[0], vertices[i]));
+	}
+
+	// distance from center to the nearest edge circle (its sine), and to the farthest vertex.
+
+	double nearest = 1, farthest = 1;
+
+	for (size_t i = 0; i < n; i++)
+	{
+		nearest = min (nearest, dot (center, edges[i]));
+		farthest = min (farthest, dot (center, vertices[i]));
+	}
+
+	if (nearest <= 0 || farthest <= 0)
+	{
+		vertices.clear();
+		edges.clear();
+		diagonals.clear();
+		return false;
+	}
+
+	// small margins, so that points near the circles are left to exact test.
+
+	innerCos = sqrt (1 - nearest * nearest) + 1e-12;
+	outerCos = farthest - 1e-12;
+
+	return true;
+}
+
+bool ConvexPolygon::contains (const MapObject & pt) const
+{
+	if (vertices.empty())
+	{
+		return false;
+	}
+
+	double c = dot (center, pt);
+
+	if (c > innerCos) return true;
+	if (c < outerCos) return false;
+
+	// DIAGONALS[j] goes from vertex 0 to vertex j + 1, first and last are edges.
+
+	size_t low = 0, high = diagonals.size() - 1;
+
+	if (dot (diagonals[low], pt) < 0 || dot (diagonals[high], pt) > 0)
+	{
+		return false;
+	}
+
+	while (high - low > 1)
+	{
+		size_t middle = (low + high) / 2;
+
+		if (dot (diagonals[middle], pt) >= 0)
+		{
+			low = middle;
+		}
+		else
+		{
+			high = middle;
+		}
+	}
+
+	// triangle of vertices 0, low + 1, low + 2.
+
+	return dot (edges[low + 1], pt) >= 0;
+}
+
+void ConvexPolygon::contains (const vector<pair<double,double> > & points, vector<char> & inside,
+				const int threads) const
+{
+	inside.assign (points.size(), 0);
+
+	Parallel::forEachPart ((long) points.size(), Parallel::threadCount (threads), [&] (int, long begin, long end)
+	{
+		for (long i = begin; i < end; i++)
+		{
+			MapObject pt (TLatLong (points[i].second, points[i].first));
+
+			inside[i] = contains (pt) ? 1 : 0;
+		}
+	});
+}
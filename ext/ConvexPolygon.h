@@ -0,0 +1,54 @@
+/* geojson, Copyright (c) 2013-2020 Yuriy Yakimenko
+ *
+ * Permission to use, copy, modify, distribute, and sell this software and its
+ * documentation for any purpose is hereby granted without fee, provided that
+ * the above copyright notice appear in all copies and that both that
+ * copyright notice and this permission notice appear in supporting
+ * documentation.  No representations are made about the suitability of this
+ * software for any purpose.  It is provided "as is" without express or
+ * implied warranty.
+ */
+
+#pragma once
+
+#include <vector>
+#include "MapObject.h"
+
+//////////////////////////////////////////////////////////////////////////////////////////
+// Convex polygon (smaller than hemisphere, like area output) prepared for testing many
+// points against it.
+//
+// Each edge is great circle, its normal points inside of polygon, so point is left of the
+// edge when dot product with the normal is not negative. Diagonals from the first vertex
+// split polygon into triangles (fan); point is in the triangle of the diagonals it is
+// between, found by binary search, and then inside only when left of that one edge.
+// Test is O(log h) dot products for polygon of h vertices. Circles around the center of
+// polygon (inside of it, and containing it) decide most points with one dot product.
+//////////////////////////////////////////////////////////////////////////////////////////
+
+class ConvexPolygon
+{
+private:
+	std::vector<MapObject> vertices;   // counterclockwise, no repeated ones.
+	std::vector<MapObject> edges;      // normal of edge from vertex I to I + 1.
+	std::vector<MapObject> diagonals;  // normal of great circle from vertex 0 to vertex I.
+
+	MapObject center;
+	double innerCos;                   // points closer to center are inside,
+	double outerCos;                   // points farther are outside.
+
+public:
+	ConvexPolygon ();
+
+	// POLYGON in any direction. False when it is not convex polygon (or is too large).
+	bool build (const std::vector<MapObject> & polygon);
+
+	size_t size () const { return vertices.size(); }
+
+	// points on the edges are inside.
+	bool contains (const MapObject & pt) const;
+
+	// INSIDE[i] is 1 when POINTS[i] <longitude,latitude> is inside, on THREADS threads.
+	void contains (const std::vector<std::pair<double,double> > & points, std::vector<char> & inside,
+		const int threads) const;
+};
@@ -0,0 +1,199 @@
+/* geojson, Copyright (c) 2013-2020 Yuriy Yakimenko
+ *
+ * Permission to use, copy, modify, distribute, and sell this software and its
+ * documentation for any purpose is hereby granted without fee, provided that
+ * the above copyright notice appear in all copies and that both that
+ * copyright notice and this permission notice appear in supporting
+ * documentation.  No representations are made about the suitability of this
+ * software for any purpose.  It is provided "as is" without express or 
+ * implied warranty.
+ */
+
+#include "CoordinateStream.h"
+
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+CoordinateStream::CoordinateStream () : file(nullptr), mapped(nullptr), mappedSize(0),
+	position(0), released(0)
+{
+	buffer[0] = 0;
+}
+
+CoordinateStream::~CoordinateStream ()
+{
+	close();
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+bool CoordinateStream::open (const char * filename)
+{
+	close();
+
+	if (strcmp (filename, "-") == 0)
+	{
+		file = stdin;
+		return true;
+	}
+
+	int fd = ::open (filename, O_RDONLY);
+
+	if (fd < 0)
+	{
+		return false;
+	}
+
+	struct stat st;
+
+	if (fstat (fd, &st) == 0 && S_ISREG (st.st_mode) && st.st_size > 0)
+	{
+		void * ptr = mmap (nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+		if (ptr != MAP_FAILED)
+		{
+			::close (fd);
+
+			mapped = (const char *) ptr;
+			mappedSize = st.st_size;
+
+			madvise (ptr, mappedSize, MADV_SEQUENTIAL);
+			return true;
+		}
+	}
+
+	// pipes, empty files etc. are read as usual.
+
+	file = fdopen (fd, "r");
+
+	if (!file)
+	{
+		::close (fd);
+		return false;
+	}
+
+	return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+void CoordinateStream::close ()
+{
+	if (mapped)
+	{
+		munmap ((void *) mapped, mappedSize);
+	}
+
+	if (file && file != stdin)
+	{
+		fclose (file);
+	}
+
+	file = nullptr;
+	mapped = nullptr;
+	mappedSize = position = released = 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+bool CoordinateStream::nextLine (const char *& line, size_t & length)
+{
+	if (mapped)
+	{
+		if (position >= mappedSize)
+		{
+			return false;
+		}
+
+		const char * start = mapped + position;
+		const char * end = (const char *) memchr (start, '\n', mappedSize - position);
+
+		if (!end)
+		{
+			end = mapped + mappedSize;
+		}
+
+		position = end - mapped + 1;
+
+		// line is copied, file does not have to end with zero.
+
+		length = end - start;
+
+		if (length > sizeof(buffer) - 1)
+		{
+			length = sizeof(buffer) - 1;
+		}
+
+		memcpy (buffer, start, length);
+
+		// pages we are done with are given back to the system, so memory use does not grow
+		// with size of the file.
+
+		const size_t chunk = 64 << 20;
+
+		if (position - released > chunk)
+		{
+			size_t page = sysconf (_SC_PAGESIZE);
+			size_t upto = (position / page) * page;
+
+			madvise ((void *) (mapped + released), upto - released, MADV_DONTNEED);
+			released = upto;
+		}
+	}
+	else
+	{
+		if (!file || !fgets (buffer, sizeof(buffer), file))
+		{
+			return false;
+		}
+
+		length = strlen (buffer);
+
+		// rest of very long line is skipped.
+
+		if (length > 0 && buffer[length - 1] != '\n' && !feof (file))
+		{
+			int c;
+			while ((c = fgetc (file)) != EOF && c != '\n') { }
+		}
+	}
+
+	while (length > 0 && (buffer[length - 1] == '\n' || buffer[length - 1] == '\r'))
+	{
+		length--;
+	}
+
+	buffer[length] = 0;
+	line = buffer;
+
+	return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+bool CoordinateStream::readBlock (vector<pair<double,double> > & block, const size_t maxCount)
+{
+	const char * line;
+	size_t length;
+	bool added = false;
+
+	while (block.size() < maxCount && nextLine (line, length))
+	{
+		if (line[0] == '#') continue;
+
+		double longitude = 0, latitude = 0;
+
+		if (sscanf (line, "%lf,%lf", &longitude, &latitude) == 2 && (longitude != 0 || latitude != 0))
+		{
+			block.push_back (make_pair (longitude, latitude));
+			added = true;
+		}
+	}
+
+	return added;
+}
@@ -0,0 +1,46 @@
+/* geojson, Copyright (c) 2013-2020 Yuriy Yakimenko
+ *
+ * Permission to use, copy, modify, distribute, and sell this software and its
+ * documentation for any purpose is hereby granted without fee, provided that
+ * the above copyright notice appear in all copies and that both that
+ * copyright notice and this permission notice appear in supporting
+ * documentation.  No representations are made about the suitability of this
+ * software for any purpose.  It is provided "as is" without express or 
+ * implied warranty.
+ */
+
+#pragma once
+
+#include <cstdio>
+#include <vector>
+
+//////////////////////////////////////////////////////////////////////////////////////////
+// Reads input file line by line without loading all of it: regular files are mapped into
+// memory (pages already read are released), "-" means standard input.
+// Same format as everywhere else: "longitude,latitude" lines, lines starting with # skipped.
+//////////////////////////////////////////////////////////////////////////////////////////
+
+class CoordinateStream
+{
+private:
+	FILE * file;
+	const char * mapped;
+	size_t mappedSize;
+	size_t position;
+	size_t released;
+	char buffer[256];
+
+public:
+	CoordinateStream ();
+	~CoordinateStream ();
+
+	bool open (const char * filename);
+	void close ();
+
+	// next line without end of line characters, valid until next call. Returns false at the end.
+	bool nextLine (const char *& line, size_t & length);
+
+	// appends coordinates to BLOCK until it has MAXCOUNT of them. Returns false when nothing
+	// was added, i.e. input is over.
+	bool readBlock (std::vector<std::pair<double,double> > & block, const size_t maxCount);
+};
@@ -0,0 +1,876 @@
+/* geojson, Copyright (c) 2013-2020 Yuriy Yakimenko
+ *
+ * Permission to use, copy, modify, distribute, and sell this software and its
+ * documentation for any purpose is hereby granted without fee, provided that
+ * the above copyright notice appear in all copies and that both that
+ * copyright notice and this permission notice appear in supporting
+ * documentation.  No representations are made about the suitability of this
+ * software for any purpose.  It is provided "as is" without express or
+ * implied warranty.
+ */
+
+#include "Corridor.h"
+#include "GeoUtils.h"
+#include "KdTree.h"
+#include "Parallel.h"
+#include "SegmentIndex.h"
+
+#include <algorithm>
+
+using namespace std;
+
+static inline double dot (const MapObject & a, const MapObject & b)
+{
+	return a.X() * b.X() + a.Y() * b.Y() + a.Z() * b.Z();
+}
+
+static inline double dot (const double a[3], const MapObject & b)
+{
+	return a[0] * b.X() + a[1] * b.Y() + a[2] * b.Z();
+}
+
+static inline bool lessXYZ (const MapObject & a, const MapObject & b)
+{
+	if (a.X() != b.X()) return a.X() < b.X();
+	if (a.Y() != b.Y()) return a.Y() < b.Y();
+
+	return a.Z() < b.Z();
+}
+
+// unit vector of A - (A.B) B (direction from B towards A).
+
+static void tangent (const MapObject & a, const MapObject & b, double t[3])
+{
+	double d = dot (a, b);
+
+	t[0] = a.X() - d * b.X();
+	t[1] = a.Y() - d * b.Y();
+	t[2] = a.Z() - d * b.Z();
+
+	double n = sqrt (t[0] * t[0] + t[1] * t[1] + t[2] * t[2]);
+
+	for (int k = 0; k < 3; k++) t[k] /= n;
+}
+
+// directions F1, F2 at C (F2 is 90 degrees counterclockwise from F1).
+
+static void frameAt (const MapObject & c, double f1[3], double f2[3])
+{
+	double ax = (fabs (c.Z()) < 0.9) ? 0 : 1;
+	double az = 1 - ax;
+
+	f1[0] = - az * c.Y();
+	f1[1] = az * c.X() - ax * c.Z();
+	f1[2] = ax * c.Y();
+
+	double n = sqrt (f1[0] * f1[0] + f1[1] * f1[1] + f1[2] * f1[2]);
+
+	for (int k = 0; k < 3; k++) f1[k] /= n;
+
+	f2[0] = c.Y() * f1[2] - c.Z() * f1[1];
+	f2[1] = c.Z() * f1[0] - c.X() * f1[2];
+	f2[2] = c.X() * f1[1] - c.Y() * f1[0];
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+// piece of outline, point at S (FROM <= S <= TO) is
+//     cos r (c0 cos (alpha S) + c1 sin (alpha S)) + sin r (d0 cos (beta S) + d1 sin (beta S)):
+// offset of segment (c0 its start, c1 direction there, alpha its length, d0 its normal
+// towards outside, beta 0), or arc around vertex (c0 the vertex, alpha 0, d0 and d1
+// directions from it, beta angle of the arc).
+//////////////////////////////////////////////////////////////////////////////////////////
+
+struct Curve
+{
+	double c0[3], c1[3], d0[3], d1[3];
+	double alpha, beta;
+	double from, to;
+	int steps;          // arc samples are FROM, TO and STEPS - 1 points between them.
+	int vertexA, vertexB;  // segment of offset, or vertex of outward arc (B is -1).
+	int loop;
+};
+
+static MapObject curvePoint (const Curve & c, const double cr, const double sr, const double s)
+{
+	double ca = cos (c.alpha * s), sa = sin (c.alpha * s);
+	double cb = cos (c.beta * s), sb = sin (c.beta * s);
+
+	return MapObject (cr * (c.c0[0] * ca + c.c1[0] * sa) + sr * (c.d0[0] * cb + c.d1[0] * sb),
+		cr * (c.c0[1] * ca + c.c1[1] * sa) + sr * (c.d0[1] * cb + c.d1[1] * sb),
+		cr * (c.c0[2] * ca + c.c1[2] * sa) + sr * (c.d0[2] * cb + c.d1[2] * sb));
+}
+
+struct Sample
+{
+	int curve;
+	double s;
+	bool covered, emit;
+};
+
+// piece of output between two crossings (or whole outline, with no crossings).
+
+struct Run
+{
+	long start, end;     // crossings, -1 for none.
+	int loop;
+	vector<MapObject> points;
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////
+// Polylines are joined into one graph first: equal points are one vertex and repeated
+// segments one edge, so routes sharing stops and streets are not outlined twice over the
+// same place. Outlines are then faces of the graph: from edge U -> V (on its right side)
+// outline continues with the next edge around V counterclockwise from V -> U. Single
+// polyline has one outline around it, closed loop of streets another one inside it.
+//////////////////////////////////////////////////////////////////////////////////////////
+
+bool Corridor::build (const vector<vector<MapObject> > & polylines, const double radius,
+			const int vertCount, vector<vector<vector<MapObject> > > & polygons, const int threads)
+{
+	polygons.clear();
+
+	if (radius <= 0 || radius >= M_PI / 2 || vertCount < 3)
+	{
+		return false;
+	}
+
+	double cr = cos (radius), sr = sin (radius);
+	double step = 2 * M_PI / vertCount;
+
+	// vertices.
+
+	vector<pair<int,int> > order;
+
+	for (int line = 0; line < (int) polylines.size(); line++)
+	{
+		for (int i = 0; i < (int) polylines[line].size(); i++)
+		{
+			order.push_back (make_pair (line, i));
+		}
+	}
+
+	sort (order.begin(), order.end(), [&] (const pair<int,int> & p, const pair<int,int> & q)
+	{
+		return lessXYZ (polylines[p.first][p.second], polylines[q.first][q.second]);
+	});
+
+	vector<MapObject> vertices;
+	vector<vector<int> > ids (polylines.size());
+
+	for (size_t line = 0; line < polylines.size(); line++)
+	{
+		ids[line].resize (polylines[line].size());
+	}
+
+	for (auto & p : order)
+	{
+		const MapObject & pt = polylines[p.first][p.second];
+
+		if (vertices.empty() || !(vertices.back() == pt))
+		{
+			vertices.push_back (pt);
+		}
+
+		ids[p.first][p.second] = (int) vertices.size() - 1;
+	}
+
+	// edges, with the same points skipped as in SegmentIndex.
+
+	SegmentIndex index;
+	vector<pair<int,int> > edges;
+
+	for (size_t line = 0; line < polylines.size(); line++)
+	{
+		index.addPolyline ((int) line, polylines[line]);
+
+		for (size_t i = 1; i < ids[line].size(); i++)
+		{
+			int u = ids[line][i - 1], v = ids[line][i];
+
+			if (u == v || dot (vertices[u], vertices[v]) < -0.999999)
+			{
+				continue;
+			}
+
+			edges.push_back (make_pair (min (u, v), max (u, v)));
+		}
+	}
+
+	if (edges.empty())
+	{
+		return false;
+	}
+
+	index.build();
+
+	sort (edges.begin(), edges.end());
+	edges.erase (unique (edges.begin(), edges.end()), edges.end());
+
+	// half edges: 2E is first -> second of edge E, 2E + 1 the opposite. Those leaving
+	// each vertex are sorted counterclockwise.
+
+	long halfCount = 2 * (long) edges.size();
+
+	vector<int> tail (halfCount), head (halfCount);
+	vector<double> angles (halfCount);
+
+	for (size_t e = 0; e < edges.size(); e++)
+	{
+		tail[2 * e] = head[2 * e + 1] = edges[e].first;
+		head[2 * e] = tail[2 * e + 1] = edges[e].second;
+	}
+
+	vector<long> first (vertices.size() + 1, 0);
+
+	for (long h = 0; h < halfCount; h++) first[tail[h] + 1]++;
+	for (size_t v = 0; v < vertices.size(); v++) first[v + 1] += first[v];
+
+	vector<long> around (halfCount), position (halfCount);
+	vector<long> filled (first.begin(), first.end() - 1);
+
+	for (long h = 0; h < halfCount; h++)
+	{
+		const MapObject & v = vertices[tail[h]];
+		const MapObject & w = vertices[head[h]];
+
+		double f1[3], f2[3];
+		frameAt (v, f1, f2);
+
+		angles[h] = atan2 (dot (f2, w), dot (f1, w));
+		around[filled[tail[h]]++] = h;
+	}
+
+	for (size_t v = 0; v < vertices.size(); v++)
+	{
+		sort (around.begin() + first[v], around.begin() + first[v + 1],
+			[&] (long p, long q) { return angles[p] < angles[q]; });
+
+		for (long k = first[v]; k < first[v + 1]; k++) position[around[k]] = k;
+	}
+
+	auto next = [&] (const long h)
+	{
+		long twin = h ^ 1;
+		int v = head[h];
+
+		long k = position[twin] + 1;
+
+		return around[(k < first[v + 1]) ? k : first[v]];
+	};
+
+	// normal of each half edge (towards its right, where outline is), length and direction.
+
+	vector<MapObject> normals;
+	vector<double> lengths (halfCount);
+
+	for (long h = 0; h < halfCount; h++)
+	{
+		const MapObject & a = vertices[tail[h]];
+		const MapObject & b = vertices[head[h]];
+
+		normals.push_back (MapObject::crossProduct (b, a));
+
+		double c[3] = { a.Y() * b.Z() - a.Z() * b.Y(), a.Z() * b.X() - a.X() * b.Z(), a.X() * b.Y() - a.Y() * b.X() };
+
+		lengths[h] = atan2 (sqrt (c[0] * c[0] + c[1] * c[1] + c[2] * c[2]), dot (a, b));
+	}
+
+	// joins: after each half edge H, angle of arc around its head when outline turns
+	// outwards. When inwards, offset of H ends where it meets offset of the next one, or
+	// when they do not meet (short segments), they are joined by arc going back (clockwise)
+	// which is inside of them, but makes outline continuous.
+
+	vector<double> arcs (halfCount, 0), starts (halfCount, 0), ends (halfCount, 1);
+
+	for (long h = 0; h < halfCount; h++)
+	{
+		long g = next (h);
+
+		double gap = angles[g] - angles[h ^ 1];
+
+		if (g == (h ^ 1)) gap = 2 * M_PI;
+		else if (gap < 0) gap += 2 * M_PI;
+
+		arcs[h] = gap - M_PI;
+
+		if (gap >= M_PI)
+		{
+			continue;
+		}
+
+		// point X at distance r from both great circles: X = a (N1 + N2) + c V.
+
+		const MapObject & v = vertices[head[h]];
+		const MapObject & n1 = normals[h];
+		const MapObject & n2 = normals[g];
+
+		double k = 1 + dot (n1, n2);
+
+		if (k < 1e-12) continue;
+
+		double a = sr / k;
+		double c2 = 1 - 2 * sr * a;
+
+		if (c2 <= 0) continue;
+
+		double c = sqrt (c2);
+
+		MapObject x (a * (n1.X() + n2.X()) + c * v.X(), a * (n1.Y() + n2.Y()) + c * v.Y(),
+			a * (n1.Z() + n2.Z()) + c * v.Z());
+
+		// how far along each segment it is (its foot on the great circle is X - sin r N).
+
+		const MapObject & u = vertices[tail[h]];
+		const MapObject & w = vertices[head[g]];
+
+		double t1[3], t2[3];
+
+		tangent (v, u, t1);
+		tangent (w, v, t2);
+
+		MapObject foot1 (x.X() - sr * n1.X(), x.Y() - sr * n1.Y(), x.Z() - sr * n1.Z());
+		MapObject foot2 (x.X() - sr * n2.X(), x.Y() - sr * n2.Y(), x.Z() - sr * n2.Z());
+
+		double along1 = atan2 (dot (t1, foot1), dot (u, foot1));
+		double along2 = atan2 (dot (t2, foot2), dot (v, foot2));
+
+		if (along1 < 0 || along1 > lengths[h] || along2 < 0 || along2 > lengths[g])
+		{
+			continue;
+		}
+
+		arcs[h] = 0;
+		ends[h] = along1 / lengths[h];
+		starts[g] = along2 / lengths[g];
+	}
+
+	// outlines (loops of half edges) and their curves.
+
+	double tolerance = radius * (1 - cos (step / 2));
+	double emitLength = sqrt (8 * tolerance / tan (radius));
+
+	vector<Curve> curves;
+	vector<int> loopComponent;
+	vector<long> loopCurves (1, 0);
+	vector<bool> visited (halfCount, false);
+
+	// connected parts of the graph.
+
+	vector<int> part (vertices.size());
+
+	for (size_t i = 0; i < part.size(); i++) part[i] = (int) i;
+
+	auto root = [&] (int i)
+	{
+		while (part[i] != i) i = part[i] = part[part[i]];
+		return i;
+	};
+
+	for (auto & e : edges)
+	{
+		part[root (e.first)] = root (e.second);
+	}
+
+	for (long h0 = 0; h0 < halfCount; h0++)
+	{
+		if (visited[h0]) continue;
+
+		int loop = (int) loopComponent.size();
+
+		loopComponent.push_back (root (tail[h0]));
+
+		long h = h0;
+
+		do
+		{
+			visited[h] = true;
+
+			const MapObject & a = vertices[tail[h]];
+			const MapObject & b = vertices[head[h]];
+			const MapObject & n = normals[h];
+
+			// offset of segment, unless joins at both ends cut all of it.
+
+			if (starts[h] < ends[h])
+			{
+				Curve c;
+
+				double t[3];
+				tangent (b, a, t);
+
+				for (int k = 0; k < 3; k++) c.c1[k] = t[k];
+
+				c.c0[0] = a.X(); c.c0[1] = a.Y(); c.c0[2] = a.Z();
+				c.d0[0] = n.X(); c.d0[1] = n.Y(); c.d0[2] = n.Z();
+				c.d1[0] = c.d1[1] = c.d1[2] = 0;
+
+				c.alpha = lengths[h];
+				c.beta = 0;
+				c.from = starts[h];
+				c.to = ends[h];
+				c.steps = 0;
+				c.vertexA = tail[h];
+				c.vertexB = head[h];
+				c.loop = loop;
+
+				curves.push_back (c);
+			}
+
+			if (arcs[h] != 0)
+			{
+				Curve c;
+
+				c.c0[0] = b.X(); c.c0[1] = b.Y(); c.c0[2] = b.Z();
+				c.c1[0] = c.c1[1] = c.c1[2] = 0;
+				c.d0[0] = n.X(); c.d0[1] = n.Y(); c.d0[2] = n.Z();
+
+				// b x n, 90 degrees counterclockwise from N around B.
+
+				c.d1[0] = b.Y() * n.Z() - b.Z() * n.Y();
+				c.d1[1] = b.Z() * n.X() - b.X() * n.Z();
+				c.d1[2] = b.X() * n.Y() - b.Y() * n.X();
+
+				c.alpha = 0;
+				c.beta = arcs[h];
+				c.from = 0;
+				c.to = 1;
+				c.steps = (int) max (1.0, ceil (fabs (arcs[h]) / step));
+				c.vertexA = (arcs[h] > 0) ? head[h] : -1;
+				c.vertexB = -1;
+				c.loop = loop;
+
+				curves.push_back (c);
+			}
+
+			h = next (h);
+		}
+		while (h != h0);
+
+		loopCurves.push_back ((long) curves.size());
+	}
+
+	// samples, and which of them are inside: closer than radius to some segment other than
+	// that of their curve (to any segment, for arc going back). Offset is walked by distance
+	// to the nearest one less radius (no point nearer than that can be inside), but at least
+	// by arc step, so that outline going through corridor of other segment is noticed.
+	// Output has ends of offsets, and their points where they bend away from straight line
+	// by tolerance.
+
+	double limitMiles = radius * (1 - 1e-7) * MapObject::EARTH_RADIUS;
+	double minStep = step * sr;
+
+	auto distance = [&] (const Curve & c, const MapObject & p, const double maxMiles)
+	{
+		SegmentIndex::Match match;
+
+		if (c.vertexA < 0)
+		{
+			return index.nearest (p, maxMiles, match) ? match.distanceMiles : -1.0;
+		}
+
+		const MapObject * b = (c.vertexB >= 0) ? &vertices[c.vertexB] : nullptr;
+
+		return index.nearestOther (p, maxMiles, vertices[c.vertexA], b, match) ? match.distanceMiles : -1.0;
+	};
+
+	auto covered = [&] (const Curve & c, const MapObject & p)
+	{
+		double d = distance (c, p, limitMiles);
+
+		return d >= 0 && d < limitMiles;
+	};
+
+	int threadCount = Parallel::threadCount (threads);
+
+	vector<vector<Sample> > partSamples (threadCount);
+
+	Parallel::forEachPart ((long) curves.size(), threadCount, [&] (int part, long begin, long end)
+	{
+		vector<Sample> & output = partSamples[part];
+
+		for (long i = begin; i < end; i++)
+		{
+			const Curve & c = curves[i];
+
+			if (c.steps > 0)
+			{
+				for (int k = 0; k <= c.steps; k++)
+				{
+					double s = c.from + (c.to - c.from) * k / c.steps;
+
+					output.push_back (Sample { (int) i, s, covered (c, curvePoint (c, cr, sr, s)), true });
+				}
+
+				continue;
+			}
+
+			double speed = c.alpha * cr;
+			double length = speed * (c.to - c.from);
+
+			double at = 0;
+			long lastMark = 0;
+
+			while (true)
+			{
+				double s = (at < length) ? c.from + at / speed : c.to;
+
+				double d = distance (c, curvePoint (c, cr, sr, s), (radius + length - at + minStep) * MapObject::EARTH_RADIUS);
+
+				long mark = (long) floor (2 * at / emitLength);
+
+				output.push_back (Sample { (int) i, s, d >= 0 && d < limitMiles, at == 0 || at >= length || mark != lastMark });
+
+				if (at >= length) break;
+
+				lastMark = mark;
+
+				double skip = (d < 0) ? length : fabs (d / MapObject::EARTH_RADIUS - radius);
+
+				at = min (length, at + min (emitLength / 2, max (minStep, skip)));
+			}
+		}
+	});
+
+	vector<Sample> samples;
+	vector<long> loopSamples (loopCurves.size(), 0);
+
+	for (auto & output : partSamples)
+	{
+		for (auto & sample : output)
+		{
+			samples.push_back (sample);
+			loopSamples[curves[sample.curve].loop + 1]++;
+		}
+
+		vector<Sample> ().swap (output);
+	}
+
+	for (size_t loop = 1; loop < loopSamples.size(); loop++) loopSamples[loop] += loopSamples[loop - 1];
+
+	// crossings: between inside and outside sample of the same curve, found by bisection
+	// (curves meet at their ends, so the outside one is taken between two of them).
+
+	vector<long> transitions;     // sample before each crossing.
+
+	for (size_t loop = 0; loop + 1 < loopSamples.size(); loop++)
+	{
+		for (long i = loopSamples[loop]; i < loopSamples[loop + 1]; i++)
+		{
+			long j = (i + 1 < loopSamples[loop + 1]) ? i + 1 : loopSamples[loop];
+
+			if (samples[i].covered != samples[j].covered) transitions.push_back (i);
+		}
+	}
+
+	vector<MapObject> crossings (transitions.size(), MapObject (0, 0, 1));
+
+	Parallel::forEachPart ((long) transitions.size(), threadCount, [&] (int, long begin, long end)
+	{
+		for (long t = begin; t < end; t++)
+		{
+			long i = transitions[t];
+			int loop = curves[samples[i].curve].loop;
+			long j = (i + 1 < loopSamples[loop + 1]) ? i + 1 : loopSamples[loop];
+
+			const Sample & in = samples[i].covered ? samples[i] : samples[j];
+			const Sample & out = samples[i].covered ? samples[j] : samples[i];
+
+			const Curve & c = curves[out.curve];
+
+			if (in.curve != out.curve)
+			{
+				crossings[t] = curvePoint (c, cr, sr, out.s);
+				continue;
+			}
+
+			double low = out.s, high = in.s;
+
+			// to 1e-7 of radius along the curve.
+
+			double speed = c.alpha * cr + c.beta * sr;
+
+			while (fabs (high - low) * speed > 1e-7 * radius)
+			{
+				double middle = (low + high) / 2;
+
+				if (covered (c, curvePoint (c, cr, sr, middle))) high = middle;
+				else low = middle;
+			}
+
+			crossings[t] = curvePoint (c, cr, sr, low);
+		}
+	});
+
+	// crossings in pairs: where one outline goes in, another one comes out, at the same
+	// point. When that one comes out and goes in again too shortly to be noticed between its
+	// samples, outline going in there is paired with the one coming out where it went in
+	// (not farther than two steps). The same points are paired first.
+
+	auto goesIn = [&] (const long t) { return !samples[transitions[t]].covered; };
+
+	vector<pair<double,double> > startPoints;
+	vector<long> startCrossings;
+
+	for (long t = 0; t < (long) transitions.size(); t++)
+	{
+		if (goesIn (t)) continue;
+
+		TLatLong ll = crossings[t].GetLatLong();
+
+		startPoints.push_back (make_pair (ll.Longitude(), ll.Latitude()));
+		startCrossings.push_back (t);
+	}
+
+	vector<long> partner (transitions.size(), -1);
+	vector<bool> paired (transitions.size(), false);
+
+	if (!startCrossings.empty())
+	{
+		KdTree tree;
+		tree.build (startPoints);
+
+		vector<KdTree::Result> found;
+		vector<bool> taken (startCrossings.size(), false);
+
+		for (double maxDistance : { 1e-5 * radius, 2 * minStep })
+		{
+			for (long t = 0; t < (long) transitions.size(); t++)
+			{
+				if (!goesIn (t) || paired[t]) continue;
+
+				tree.within (crossings[t], maxDistance * MapObject::EARTH_RADIUS, found);
+
+				for (auto & f : found)
+				{
+					if (taken[f.second]) continue;
+
+					taken[f.second] = true;
+					partner[t] = startCrossings[f.second];
+					paired[t] = paired[partner[t]] = true;
+					break;
+				}
+			}
+		}
+	}
+
+	// runs of outside samples, from crossing where outline comes out to the one where it
+	// goes in (or whole outline). Outline which goes in and out again where no other one
+	// comes out and in (too shortly to be noticed between its samples) is taken as staying
+	// out, and the same the other way.
+
+	vector<Run> runs;
+	vector<int> runStarting (transitions.size(), -1);
+
+	size_t transition = 0;
+
+	for (size_t loop = 0; loop + 1 < loopSamples.size(); loop++)
+	{
+		long begin = loopSamples[loop], end = loopSamples[loop + 1];
+
+		size_t firstTransition = transition;
+
+		while (transition < transitions.size() && transitions[transition] < end) transition++;
+
+		size_t count = transition - firstTransition;
+
+		auto emit = [&] (Run & run, const long i)
+		{
+			if (samples[i].emit)
+			{
+				run.points.push_back (curvePoint (curves[samples[i].curve], cr, sr, samples[i].s));
+			}
+		};
+
+		// crossings left, starting with paired one.
+
+		vector<long> left;
+
+		size_t at = firstTransition;
+
+		while (at < transition && !paired[at]) at++;
+
+		for (size_t k = 0; k < count; k++)
+		{
+			long t = (long) ((at < transition) ? firstTransition + (at - firstTransition + k) % count : firstTransition + k);
+
+			if (!paired[t] && !left.empty() && !paired[left.back()]) left.pop_back();
+			else left.push_back (t);
+		}
+
+		if (left.empty())
+		{
+			long outside = 0;
+
+			for (long i = begin; i < end; i++) outside += samples[i].covered ? 0 : 1;
+
+			if (begin == end || 2 * outside < end - begin) continue;
+
+			runs.push_back (Run { -1, -1, (int) loop, vector<MapObject> () });
+
+			for (long i = begin; i < end; i++) emit (runs.back(), i);
+
+			continue;
+		}
+
+		for (size_t k = 0; k < left.size(); k++)
+		{
+			long t = left[k];
+
+			if (goesIn (t)) continue;
+
+			long u = left[(k + 1) % left.size()];
+
+			runStarting[t] = (int) runs.size();
+			runs.push_back (Run { t, u, (int) loop, vector<MapObject> (1, crossings[t]) });
+
+			for (long i = transitions[t] + 1; ; i++)
+			{
+				if (i == end) i = begin;
+
+				emit (runs.back(), i);
+
+				if (i == transitions[u]) break;
+			}
+		}
+	}
+
+	// each run goes on with the one which comes out where it goes in.
+
+	vector<int> nextRun (runs.size(), -1);
+
+	for (size_t r = 0; r < runs.size(); r++)
+	{
+		if (runs[r].end >= 0 && partner[runs[r].end] >= 0)
+		{
+			nextRun[r] = runStarting[partner[runs[r].end]];
+		}
+	}
+
+	// rings; parts of the graph which meet in a ring are one part.
+
+	vector<vector<MapObject> > rings;
+	vector<int> ringLoop;
+	vector<double> areas;
+	vector<bool> used (runs.size(), false);
+
+	double minChord2 = (1e-6 * radius) * (1e-6 * radius);
+
+	auto add = [&] (vector<MapObject> & ring, const MapObject & p)
+	{
+		if (ring.empty()) { ring.push_back (p); return; }
+
+		const MapObject & q = ring.back();
+
+		double dx = p.X() - q.X(), dy = p.Y() - q.Y(), dz = p.Z() - q.Z();
+
+		if (dx * dx + dy * dy + dz * dz > minChord2) ring.push_back (p);
+	};
+
+	for (size_t r0 = 0; r0 < runs.size(); r0++)
+	{
+		if (used[r0]) continue;
+
+		vector<MapObject> ring;
+
+		for (int r = (int) r0; r >= 0 && !used[r]; r = nextRun[r])
+		{
+			used[r] = true;
+
+			for (auto & p : runs[r].points) add (ring, p);
+
+			part[root (loopComponent[runs[r].loop])] = root (loopComponent[runs[r0].loop]);
+		}
+
+		while (ring.size() > 1)
+		{
+			vector<MapObject> closing (1, ring.back());
+
+			add (closing, ring.front());
+
+			if (closing.size() > 1) break;
+
+			ring.pop_back();
+		}
+
+		if (ring.size() < 3)
+		{
+			continue;
+		}
+
+		// ring narrower than the error of circles made of VERTCOUNT points is a sliver, where
+		// outlines of routes just touch (like ones twice the radius apart).
+
+		double area = GeoUtils::ringArea (ring);
+		double perimeter = 0;
+
+		for (size_t i = 0; i < ring.size(); i++)
+		{
+			const MapObject & p = ring[i];
+			const MapObject & q = ring[(i + 1) % ring.size()];
+
+			double dx = p.X() - q.X(), dy = p.Y() - q.Y(), dz = p.Z() - q.Z();
+
+			perimeter += sqrt (dx * dx + dy * dy + dz * dz);
+		}
+
+		if (fabs (area) <= perimeter * radius * (1 - cos (step / 2)))
+		{
+			continue;
+		}
+
+		rings.push_back (ring);
+		ringLoop.push_back (runs[r0].loop);
+		areas.push_back (area);
+	}
+
+	// outer rings and holes, like in SphericalDelaunay::circlesUnion.
+
+	vector<int> outer;
+	vector<int> partOuter (vertices.size(), -1);
+	vector<int> partOuters (vertices.size(), 0);
+
+	for (size_t r = 0; r < rings.size(); r++)
+	{
+		if (areas[r] > 0)
+		{
+			int p = root (loopComponent[ringLoop[r]]);
+
+			partOuter[p] = (int) outer.size();
+			partOuters[p]++;
+
+			outer.push_back ((int) r);
+			polygons.push_back (vector<vector<MapObject> > (1, rings[r]));
+		}
+	}
+
+	for (size_t r = 0; r < rings.size(); r++)
+	{
+		if (areas[r] > 0) continue;
+
+		int p = root (loopComponent[ringLoop[r]]);
+
+		if (partOuters[p] == 1)
+		{
+			polygons[partOuter[p]].push_back (rings[r]);
+			continue;
+		}
+
+		int best = -1;
+
+		for (size_t o = 0; o < outer.size(); o++)
+		{
+			if (GeoUtils::ringContains (rings[outer[o]], rings[r].front()) &&
+				(best < 0 || areas[outer[o]] < areas[outer[best]]))
+			{
+				best = (int) o;
+			}
+		}
+
+		if (best >= 0)
+		{
+			polygons[best].push_back (rings[r]);
+		}
+	}
+
+	return true;
+}
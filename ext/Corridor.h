@@ -0,0 +1,38 @@
+/* geojson, Copyright (c) 2013-2020 Yuriy Yakimenko
+ *
+ * Permission to use, copy, modify, distribute, and sell this software and its
+ * documentation for any purpose is hereby granted without fee, provided that
+ * the above copyright notice appear in all copies and that both that
+ * copyright notice and this permission notice appear in supporting
+ * documentation.  No representations are made about the suitability of this
+ * software for any purpose.  It is provided "as is" without express or
+ * implied warranty.
+ */
+
+#pragma once
+
+#include <vector>
+#include "MapObject.h"
+
+//////////////////////////////////////////////////////////////////////////////////////////
+// Area within given distance of polylines (routes), with holes where routes make loops.
+//
+// Outline of one polyline goes along its right side forward and back along its left side
+// (counterclockwise): each segment is offset by the radius to its side, and where outline
+// turns outwards, it goes around the vertex on circle of the radius (caps at the ends are
+// half circles). Outline points closer than radius to any segment (found in SegmentIndex,
+// O(log n) each) are inside of area and dropped, so what is left of all outlines is the
+// boundary. Where outline goes inside, the point is found by bisection, and each such
+// point is where another outline comes out, so pieces are joined there into rings.
+//////////////////////////////////////////////////////////////////////////////////////////
+
+class Corridor
+{
+public:
+	// area within RADIUS (angle) of POLYLINES (polylines of one point are skipped), with
+	// VERTCOUNT points per full circle. Each polygon is outer ring (counterclockwise) and
+	// its holes (clockwise). False when there is no polyline.
+	static bool build (const std::vector<std::vector<MapObject> > & polylines, const double radius,
+		const int vertCount, std::vector<std::vector<std::vector<MapObject> > > & polygons,
+		const int threads = 1);
+};
@@ -0,0 +1,38 @@
+/* geojson, Copyright (c) 2013-2020 Yuriy Yakimenko
+ *
+ * Permission to use, copy, modify, distribute, and sell this software and its
+ * documentation for any purpose is hereby granted without fee, provided that
+ * the above copyright notice appear in all copies and that both that
+ * copyright notice and this permission notice appear in supporting
+ * documentation.  No representations are made about the suitability of this
+ * software for any purpose.  It is provided "as is" without express or 
+ * implied warranty.
+ */
+
+#pragma once
+
+#include <chrono>
+
+// point in time after which long loops stop and return what they have. Loops check it
+// themselves (every so many iterations), so it is not exact.
+
+class Deadline
+{
+private:
+	bool active;
+	std::chrono::steady_clock::time_point end;
+
+public:
+	// no deadline, never expires.
+	Deadline () : active(false) { }
+
+	explicit Deadline (const long milliseconds) : active(true),
+		end (std::chrono::steady_clock::now() + std::chrono::milliseconds (milliseconds)) { }
+
+	bool isActive () const { return active; }
+
+	bool expired () const
+	{
+		return active && std::chrono::steady_clock::now() >= end;
+	}
+};
@@ -0,0 +1,1475 @@
+/* geojson, Copyright (c) 2013-2020 Yuriy Yakimenko
+ *
+ * Permission to use, copy, modify, distribute, and sell this software and its
+ * documentation for any purpose is hereby granted without fee, provided that
+ * the above copyright notice appear in all copies and that both that
+ * copyright notice and this permission notice appear in supporting
+ * documentation.  No representations are made about the suitability of this
+ * software for any purpose.  It is provided "as is" without express or
+ * implied warranty.
+ */
+
+#include "Delaunay.h"
+#include "GeoUtils.h"
+
+#include <algorithm>
+
+using namespace std;
+
+SphericalDelaunay::SphericalDelaunay () : inside(0, 0, 0), lastFace(-1), stamp(0), skipped(0)
+{
+}
+
+// same as MapObject::orientation, but around point O instead of center of the earth.
+
+static double turn (const MapObject & o, const MapObject & a, const MapObject & b, const MapObject & q)
+{
+	double ax = a.X() - o.X(), ay = a.Y() - o.Y(), az = a.Z() - o.Z();
+	double bx = b.X() - o.X(), by = b.Y() - o.Y(), bz = b.Z() - o.Z();
+	double qx = q.X() - o.X(), qy = q.Y() - o.Y(), qz = q.Z() - o.Z();
+
+	return qx * (ay * bz - az * by) + qy * (az * bx - ax * bz) + qz * (ax * by - ay * bx);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+// side of the plane of face where point Q is. Stereographic projection maps the sphere to
+// the plane and circles on it to circles, so Q is above the plane of face exactly when its
+// projection is inside the circle through projections of vertices. That test is exact,
+// while unit vectors of points within centimeters are rounded more than the sphere curves
+// between them.
+//////////////////////////////////////////////////////////////////////////////////////////
+
+int SphericalDelaunay::orient (const int face, const int q) const
+{
+	const Face & f = faces[face];
+
+	return MapObject::inCircle (planar[f.v[0]], planar[f.v[1]], planar[f.v[2]], planar[q]);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+// projection is from the point opposite to center C, chosen away from all points: average
+// of them, or one of the axes when they are all over the sphere.
+//////////////////////////////////////////////////////////////////////////////////////////
+
+void SphericalDelaunay::project ()
+{
+	double x = 0, y = 0, z = 0;
+
+	for (const auto & p : points)
+	{
+		x += p.X(); y += p.Y(); z += p.Z();
+	}
+
+	double length = sqrt (x * x + y * y + z * z);
+
+	vector<MapObject> centers = { MapObject (1, 0, 0), MapObject (-1, 0, 0), MapObject (0, 1, 0),
+		MapObject (0, -1, 0), MapObject (0, 0, 1), MapObject (0, 0, -1) };
+
+	if (length > 0)
+	{
+		centers.push_back (MapObject (x / length, y / length, z / length));
+	}
+
+	int best = 0;
+	double bestClosest = -1;
+
+	for (int k = 0; k < (int) centers.size(); k++)
+	{
+		double closest = 2;
+
+		for (const auto & p : points)
+		{
+			closest = min (closest, 1 + p.X() * centers[k].X() + p.Y() * centers[k].Y() + p.Z() * centers[k].Z());
+		}
+
+		if (closest > bestClosest)
+		{
+			bestClosest = closest;
+			best = k;
+		}
+	}
+
+	const MapObject & c = centers[best];
+
+	// U and V make right-handed basis with C, axis for U is the one least parallel to C.
+
+	MapObject axis = (fabs (c.X()) < 0.5) ? MapObject (1, 0, 0) : MapObject (0, 1, 0);
+
+	MapObject u = MapObject::crossProduct (axis, c);
+	MapObject v = MapObject::crossProduct (c, u);
+
+	planar.clear();
+
+	for (const auto & p : points)
+	{
+		double d = 1 + p.X() * c.X() + p.Y() * c.Y() + p.Z() * c.Z();
+
+		planar.push_back (make_pair ((p.X() * u.X() + p.Y() * u.Y() + p.Z() * u.Z()) / d,
+			(p.X() * v.X() + p.Y() * v.Y() + p.Z() * v.Z()) / d));
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+// face hit by the ray from INSIDE towards Q: walk to the neighbor across edge which has Q
+// on its outer side. Q is outside of hull (all points are on the sphere), so that face is
+// visible from Q. Returns -1 when walk does not end (numerical trouble).
+//////////////////////////////////////////////////////////////////////////////////////////
+
+int SphericalDelaunay::locate (const MapObject & q)
+{
+	int face = lastFace;
+
+	size_t limit = faces.size() + 16;
+
+	for (size_t step = 0; step < limit; step++)
+	{
+		const Face & f = faces[face];
+
+		int next = -1;
+
+		for (int k = 0; k < 3 && next < 0; k++)
+		{
+			int i = (k + step) % 3;
+
+			if (turn (inside, points[f.v[(i + 1) % 3]], points[f.v[(i + 2) % 3]], q) < 0)
+			{
+				next = f.next[i];
+			}
+		}
+
+		if (next < 0)
+		{
+			return face;
+		}
+
+		face = next;
+	}
+
+	return -1;
+}
+
+int SphericalDelaunay::newFace (const int a, const int b, const int c)
+{
+	int index;
+
+	if (freeFaces.empty())
+	{
+		index = (int) faces.size();
+		faces.push_back (Face());
+	}
+	else
+	{
+		index = freeFaces.back();
+		freeFaces.pop_back();
+	}
+
+	Face & f = faces[index];
+
+	f.v[0] = a; f.v[1] = b; f.v[2] = c;
+	f.next[0] = f.next[1] = f.next[2] = -1;
+	f.alive = true;
+	f.stamp = 0;
+
+	vertexFace[a] = vertexFace[b] = vertexFace[c] = index;
+
+	return index;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+// faces visible from the point (or seeing it edge on) make a disk; they are replaced by
+// faces joining the point to the boundary of that disk. When, because of rounding, they
+// do not make a disk, the point is skipped.
+//////////////////////////////////////////////////////////////////////////////////////////
+
+bool SphericalDelaunay::insert (const int index)
+{
+	const MapObject & q = points[index];
+
+	int start = locate (q);
+
+	if (start < 0 || orient (start, index) < 0)
+	{
+		start = -1;
+
+		for (int i = 0; i < (int) faces.size() && start < 0; i++)
+		{
+			if (faces[i].alive && orient (i, index) > 0) start = i;
+		}
+
+		if (start < 0)
+		{
+			return false;
+		}
+	}
+
+	stamp++;
+
+	visible.assign (1, start);
+	faces[start].stamp = stamp;
+
+	for (size_t i = 0; i < visible.size(); i++)
+	{
+		const Face & f = faces[visible[i]];
+
+		for (int k = 0; k < 3; k++)
+		{
+			int n = f.next[k];
+
+			if (faces[n].stamp != stamp && orient (n, index) >= 0)
+			{
+				faces[n].stamp = stamp;
+				visible.push_back (n);
+			}
+		}
+	}
+
+	// boundary edges (A, B) with face outside, in the direction of visible face. Each vertex
+	// of visible faces must start exactly one of them, and disk of V faces has V + 2 of them.
+
+	horizon.clear();
+	corners.clear();
+
+	for (int face : visible)
+	{
+		const Face & f = faces[face];
+
+		for (int k = 0; k < 3; k++)
+		{
+			corners.push_back (f.v[k]);
+
+			int n = f.next[k];
+
+			if (faces[n].stamp != stamp)
+			{
+				horizon.push_back (Edge { f.v[(k + 1) % 3], f.v[(k + 2) % 3], n, face });
+			}
+		}
+	}
+
+	sort (corners.begin(), corners.end());
+	corners.erase (unique (corners.begin(), corners.end()), corners.end());
+
+	if (corners.size() != horizon.size() || horizon.size() != visible.size() + 2)
+	{
+		return false;
+	}
+
+	starts.clear();
+
+	for (auto & e : horizon) starts.push_back (e.a);
+
+	sort (starts.begin(), starts.end());
+
+	if (adjacent_find (starts.begin(), starts.end()) != starts.end())
+	{
+		return false;
+	}
+
+	for (int face : visible)
+	{
+		faces[face].alive = false;
+		freeFaces.push_back (face);
+	}
+
+	// new face (A, B, Q) for every edge; faces at vertex A are found through STARTING and ENDING.
+
+	starting.clear();   // <vertex, face>
+	ending.clear();
+
+	for (auto & e : horizon)
+	{
+		int face = newFace (e.a, e.b, index);
+
+		faces[face].next[2] = e.outside;
+
+		Face & out = faces[e.outside];
+
+		for (int k = 0; k < 3; k++)
+		{
+			if (out.v[(k + 1) % 3] == e.b && out.v[(k + 2) % 3] == e.a) out.next[k] = face;
+		}
+
+		starting.push_back (make_pair (e.a, face));
+		ending.push_back (make_pair (e.b, face));
+	}
+
+	sort (starting.begin(), starting.end());
+	sort (ending.begin(), ending.end());
+
+	for (auto & s : starting)
+	{
+		Face & f = faces[s.second];
+
+		// across edge (B, Q) is face starting at B, across (Q, A) face ending at A.
+
+		f.next[0] = lower_bound (starting.begin(), starting.end(), make_pair (f.v[1], -1))->second;
+		f.next[1] = lower_bound (ending.begin(), ending.end(), make_pair (f.v[0], -1))->second;
+	}
+
+	lastFace = starting.front().second;
+
+	return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+// distance along Hilbert curve over 65536 x 65536 grid of longitude and latitude.
+//////////////////////////////////////////////////////////////////////////////////////////
+
+static unsigned long long hilbertIndex (const pair<double,double> & coord)
+{
+	unsigned x = (unsigned) min (65535.0, max (0.0, (coord.first + 180) / 360 * 65536));
+	unsigned y = (unsigned) min (65535.0, max (0.0, (coord.second + 90) / 180 * 65536));
+
+	unsigned long long d = 0;
+
+	for (unsigned s = 32768; s > 0; s /= 2)
+	{
+		unsigned rx = (x & s) > 0;
+		unsigned ry = (y & s) > 0;
+
+		d += (unsigned long long) s * s * ((3 * rx) ^ ry);
+
+		if (ry == 0)
+		{
+			if (rx == 1)
+			{
+				x = 65535 - x;
+				y = 65535 - y;
+			}
+
+			swap (x, y);
+		}
+	}
+
+	return d;
+}
+
+bool SphericalDelaunay::build (const vector<pair<double,double> > & input)
+{
+	points.clear();
+	planar.clear();
+	order.clear();
+	faces.clear();
+	freeFaces.clear();
+	vertexFace.clear();
+	skipped = 0;
+
+	vector<pair<unsigned long long, int> > keys;
+
+	for (int i = 0; i < (int) input.size(); i++)
+	{
+		keys.push_back (make_pair (hilbertIndex (input[i]), i));
+	}
+
+	sort (keys.begin(), keys.end());
+
+	// drop duplicates (they have the same key, so they are next to each other within a run).
+
+	for (size_t i = 0; i < keys.size(); i++)
+	{
+		const pair<double,double> & c = input[keys[i].second];
+
+		bool duplicate = false;
+
+		for (size_t j = i; j > 0 && keys[j - 1].first == keys[i].first && !duplicate; j--)
+		{
+			duplicate = (input[keys[j - 1].second] == c);
+		}
+
+		if (!duplicate)
+		{
+			points.push_back (MapObject (TLatLong (c.second, c.first)));
+			order.push_back (keys[i].second);
+		}
+	}
+
+	int n = (int) points.size();
+
+	vertexFace.assign (n, -1);
+
+	if (n < 4)
+	{
+		return false;
+	}
+
+	project ();
+
+	// first tetrahedron: first three points and first one not on their circle.
+
+	int fourth = -1;
+	int sign = 0;
+
+	for (int i = 3; i < n && fourth < 0; i++)
+	{
+		sign = MapObject::inCircle (planar[0], planar[1], planar[2], planar[i]);
+
+		if (sign != 0) fourth = i;
+	}
+
+	if (fourth < 0)
+	{
+		return false;
+	}
+
+	swap (points[3], points[fourth]);
+	swap (planar[3], planar[fourth]);
+	swap (order[3], order[fourth]);
+
+	inside = MapObject ((points[0].X() + points[1].X() + points[2].X() + points[3].X()) / 4,
+		(points[0].Y() + points[1].Y() + points[2].Y() + points[3].Y()) / 4,
+		(points[0].Z() + points[1].Z() + points[2].Z() + points[3].Z()) / 4);
+
+	// with point 3 below face (0, 1, 2), faces counterclockwise from outside are:
+
+	int tetra[4][3] = { { 0, 1, 2 }, { 0, 3, 1 }, { 1, 3, 2 }, { 0, 2, 3 } };
+
+	if (sign > 0)
+	{
+		for (auto & t : tetra) swap (t[1], t[2]);
+	}
+
+	for (auto & t : tetra)
+	{
+		newFace (t[0], t[1], t[2]);
+	}
+
+	// neighbor across edge (A, B) has edge (B, A).
+
+	for (int f = 0; f < 4; f++)
+	{
+		for (int k = 0; k < 3; k++)
+		{
+			int a = faces[f].v[(k + 1) % 3], b = faces[f].v[(k + 2) % 3];
+
+			for (int g = 0; g < 4; g++)
+			{
+				for (int j = 0; j < 3; j++)
+				{
+					if (faces[g].v[(j + 1) % 3] == b && faces[g].v[(j + 2) % 3] == a)
+					{
+						faces[f].next[k] = g;
+					}
+				}
+			}
+		}
+	}
+
+	lastFace = 0;
+
+	for (int i = 4; i < n; i++)
+	{
+		if (!insert (i))
+		{
+			vertexFace[i] = -1;
+			skipped++;
+		}
+	}
+
+	return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+bool SphericalDelaunay::isInner (const int face) const
+{
+	const Face & f = faces[face];
+
+	return MapObject::orientation (points[f.v[0]], points[f.v[1]], points[f.v[2]]) > 0;
+}
+
+MapObject SphericalDelaunay::circumcenter (const int face) const
+{
+	const Face & f = faces[face];
+
+	const MapObject & a = points[f.v[0]];
+	const MapObject & b = points[f.v[1]];
+	const MapObject & c = points[f.v[2]];
+
+	double bx = b.X() - a.X(), by = b.Y() - a.Y(), bz = b.Z() - a.Z();
+	double cx = c.X() - a.X(), cy = c.Y() - a.Y(), cz = c.Z() - a.Z();
+
+	double nx = by * cz - bz * cy;
+	double ny = bz * cx - bx * cz;
+	double nz = bx * cy - by * cx;
+
+	double norm = sqrt (nx * nx + ny * ny + nz * nz);
+
+	return MapObject (nx / norm, ny / norm, nz / norm);
+}
+
+double SphericalDelaunay::circumradius (const int face) const
+{
+	return circumcenter (face).GetAngle (points[faces[face].v[0]]);
+}
+
+bool SphericalDelaunay::coversSphere () const
+{
+	for (int i = 0; i < (int) faces.size(); i++)
+	{
+		if (!faces[i].alive) continue;
+
+		// circle of face must be clearly smaller than hemisphere: for points on one great
+		// circle, side of the center of the earth is only rounding noise.
+
+		if (!(circumcenter (i).GetAngleCos (points[faces[i].v[0]]) > 1e-9)) return false;
+	}
+
+	return !faces.empty();
+}
+
+void SphericalDelaunay::triangles (vector<vector<int> > & output) const
+{
+	output.clear();
+
+	for (int i = 0; i < (int) faces.size(); i++)
+	{
+		if (faces[i].alive && isInner (i))
+		{
+			output.push_back (vector<int> (faces[i].v, faces[i].v + 3));
+		}
+	}
+}
+
+bool SphericalDelaunay::facesAround (const int i, vector<int> & output) const
+{
+	output.clear();
+
+	int start = vertexFace[i];
+
+	if (start < 0)
+	{
+		return false;
+	}
+
+	int face = start;
+
+	do
+	{
+		output.push_back (face);
+
+		const Face & f = faces[face];
+
+		int k = (f.v[0] == i) ? 0 : (f.v[1] == i) ? 1 : 2;
+
+		// face (I, B, C) is followed by face across edge (C, I).
+
+		face = f.next[(k + 1) % 3];
+
+	} while (face != start && output.size() <= faces.size());
+
+	return true;
+}
+
+bool SphericalDelaunay::voronoiCell (const int i, vector<MapObject> & output) const
+{
+	vector<int> around;
+
+	output.clear();
+
+	if (!facesAround (i, around))
+	{
+		return false;
+	}
+
+	for (int face : around)
+	{
+		output.push_back (circumcenter (face));
+	}
+
+	return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+// boundary of kept triangles is traced with them on the left: next edge after (A, B) is
+// found by turning around B through kept triangles. So rings touching at a vertex are
+// traced separately. Triangles connected through edges make one polygon, its ring with
+// positive area around its own center is outer boundary, rings with negative are holes.
+//////////////////////////////////////////////////////////////////////////////////////////
+
+void SphericalDelaunay::alphaShape (const double alpha, vector<vector<vector<int> > > & polygons) const
+{
+	polygons.clear();
+
+	int count = (int) faces.size();
+
+	double alphaCos = cos (alpha);
+
+	vector<bool> kept (count, false);
+
+	for (int f = 0; f < count; f++)
+	{
+		kept[f] = faces[f].alive && isInner (f) &&
+			circumcenter (f).GetAngleCos (points[faces[f].v[0]]) >= alphaCos;
+	}
+
+	// connected parts.
+
+	vector<int> part (count, -1);
+	int parts = 0;
+
+	for (int f = 0; f < count; f++)
+	{
+		if (!kept[f] || part[f] >= 0) continue;
+
+		vector<int> stack (1, f);
+		part[f] = parts;
+
+		while (!stack.empty())
+		{
+			int g = stack.back();
+			stack.pop_back();
+
+			for (int n : faces[g].next)
+			{
+				if (kept[n] && part[n] < 0)
+				{
+					part[n] = parts;
+					stack.push_back (n);
+				}
+			}
+		}
+
+		parts++;
+	}
+
+	vector<vector<vector<int> > > rings (parts);
+	vector<bool> traced (3 * count, false);
+
+	for (int f = 0; f < count; f++)
+	{
+		for (int k = 0; k < 3; k++)
+		{
+			if (!kept[f] || kept[faces[f].next[k]] || traced[3 * f + k]) continue;
+
+			vector<int> ring;
+
+			int face = f, edge = k;
+
+			while (!traced[3 * face + edge])
+			{
+				traced[3 * face + edge] = true;
+
+				int b = faces[face].v[(edge + 2) % 3];
+
+				ring.push_back (faces[face].v[(edge + 1) % 3]);
+
+				// turn around B.
+
+				int j = (edge + 2) % 3;
+
+				while (kept[faces[face].next[(j + 2) % 3]])
+				{
+					face = faces[face].next[(j + 2) % 3];
+
+					const Face & g = faces[face];
+					j = (g.v[0] == b) ? 0 : (g.v[1] == b) ? 1 : 2;
+				}
+
+				edge = (j + 2) % 3;
+			}
+
+			rings[part[f]].push_back (ring);
+		}
+	}
+
+	for (auto & partRings : rings)
+	{
+		vector<vector<int> > polygon (1);
+
+		for (auto & ring : partRings)
+		{
+			vector<MapObject> vertices;
+
+			for (int i : ring) vertices.push_back (points[i]);
+
+			if (GeoUtils::ringArea (vertices) > 0 && polygon.front().empty())
+			{
+				polygon.front() = ring;
+			}
+			else
+			{
+				polygon.push_back (ring);
+			}
+		}
+
+		if (!polygon.front().empty())
+		{
+			polygons.push_back (polygon);
+		}
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+// normals of great circles along edges of convex POLYGON, pointing inside of it (so point
+// is inside when its dot products with all of them are not negative).
+//////////////////////////////////////////////////////////////////////////////////////////
+
+static void edgeNormals (const vector<MapObject> & polygon, vector<MapObject> & normals)
+{
+	normals.clear();
+
+	size_t n = polygon.size();
+
+	// clockwise POLYGON is walked backwards. Its first vertices may repeat.
+
+	size_t second = 1;
+
+	while (second < n && polygon[second] == polygon[0]) second++;
+
+	int direction = 0;
+
+	for (size_t i = second + 1; i < n && direction == 0; i++)
+	{
+		direction = MapObject::orientation (polygon[0], polygon[second], polygon[i]);
+	}
+
+	if (direction == 0)
+	{
+		return;
+	}
+
+	for (size_t e = 0; e < n; e++)
+	{
+		const MapObject & a = polygon[e];
+		const MapObject & b = polygon[(e + 1) % n];
+
+		if (a == b) continue;
+
+		normals.push_back ((direction > 0) ? MapObject::crossProduct (a, b) : MapObject::crossProduct (b, a));
+	}
+}
+
+static bool isInside (const vector<MapObject> & normals, const MapObject & pt)
+{
+	for (auto & normal : normals)
+	{
+		if (pt.GetAngleCos (normal) < 0) return false;
+	}
+
+	return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+// Sutherland-Hodgman: edge of clip polygon is great circle, inside of it is where its
+// normal points. Both polygons must fit into hemisphere.
+//////////////////////////////////////////////////////////////////////////////////////////
+
+static void clipByNormals (const vector<MapObject> & polygon, const vector<MapObject> & normals,
+				vector<MapObject> & output)
+{
+	output = polygon;
+
+	for (size_t e = 0; e < normals.size() && !output.empty(); e++)
+	{
+		const MapObject & normal = normals[e];
+
+		vector<MapObject> input;
+		input.swap (output);
+
+		for (size_t i = 0; i < input.size(); i++)
+		{
+			const MapObject & s = input[i];
+			const MapObject & t = input[(i + 1) % input.size()];
+
+			double ds = s.GetAngleCos (normal);
+			double dt = t.GetAngleCos (normal);
+
+			if (ds >= 0)
+			{
+				output.push_back (s);
+			}
+
+			if ((ds >= 0) != (dt >= 0))
+			{
+				double x = ds * t.X() - dt * s.X();
+				double y = ds * t.Y() - dt * s.Y();
+				double z = ds * t.Z() - dt * s.Z();
+
+				if (ds < 0)
+				{
+					x = -x; y = -y; z = -z;
+				}
+
+				double norm = sqrt (x * x + y * y + z * z);
+
+				if (norm > 0)
+				{
+					output.push_back (MapObject (x / norm, y / norm, z / norm));
+				}
+			}
+		}
+	}
+}
+
+void SphericalDelaunay::clip (const vector<MapObject> & polygon, const vector<MapObject> & clip,
+				vector<MapObject> & output)
+{
+	vector<MapObject> normals;
+
+	edgeNormals (clip, normals);
+
+	if (normals.size() < 3)
+	{
+		output = polygon;
+		return;
+	}
+
+	clipByNormals (polygon, normals, output);
+}
+
+// angle between unit vectors from their chord: acos of dot product loses all digits for
+// points centimeters apart.
+
+static double chordAngle (const MapObject & a, const MapObject & b)
+{
+	double dx = a.X() - b.X(), dy = a.Y() - b.Y(), dz = a.Z() - b.Z();
+
+	return 2 * asin (min (1.0, sqrt (dx * dx + dy * dy + dz * dz) / 2));
+}
+
+// hull of points on one line is made a polygon only by rounding: its width is much less
+// than its length.
+
+static bool hasArea (const vector<MapObject> & polygon)
+{
+	double perimeter = 0;
+
+	for (size_t i = 0; i < polygon.size(); i++)
+	{
+		perimeter += chordAngle (polygon[i], polygon[(i + 1) % polygon.size()]);
+	}
+
+	return fabs (GeoUtils::ringArea (polygon)) > 1e-9 * perimeter * perimeter;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+// distance to the nearest point is largest at a vertex of some Voronoi cell cut by REGION:
+// inside of the cell it grows towards the cell boundary (where another point gets as
+// close), and on the boundary towards its corners. Only cells which stick out of REGION
+// need cutting, others are looked at through their vertices.
+//////////////////////////////////////////////////////////////////////////////////////////
+
+bool SphericalDelaunay::largestEmptyCircle (const vector<MapObject> & region, MapObject & center,
+				double & radius) const
+{
+	vector<MapObject> normals;
+
+	edgeNormals (region, normals);
+
+	bool whole = region.empty();
+
+	if (whole ? !coversSphere() : (normals.size() < 3 || !hasArea (region)))
+	{
+		return false;
+	}
+
+	bool found = false;
+
+	radius = 0;
+
+	vector<MapObject> cell, clipped;
+
+	for (int i = 0; i < (int) points.size(); i++)
+	{
+		if (!voronoiCell (i, cell))
+		{
+			continue;
+		}
+
+		bool inside = whole;
+
+		if (!whole)
+		{
+			inside = true;
+
+			for (size_t k = 0; k < cell.size() && inside; k++)
+			{
+				inside = isInside (normals, cell[k]);
+			}
+		}
+
+		if (inside)
+		{
+			clipped.swap (cell);
+		}
+		else
+		{
+			clipByNormals (cell, normals, clipped);
+		}
+
+		for (auto & corner : clipped)
+		{
+			double distance = corner.GetAngle (points[i]);
+
+			if (distance > radius)
+			{
+				radius = distance;
+				center = corner;
+				found = true;
+			}
+		}
+	}
+
+	return found;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+// Union of circles of the same radius. Part of the union in Voronoi cell of a point is the
+// part of its own circle in that cell (points of the cell are closer to it than to others),
+// so boundary of the union is made of arcs of each circle inside of its cell. Arc ends are
+// where the circle crosses edge of the cell, and there arc of the neighbor's circle starts:
+// both circles cross the edge (points equally far from both) in the same point. Circles
+// with no arc are covered by others and cost only the cell test.
+//
+// Arcs are traced counterclockwise, so union is on their left: outer rings are
+// counterclockwise, holes clockwise.
+//////////////////////////////////////////////////////////////////////////////////////////
+
+struct UnionArc
+{
+	int circle;
+	double from, to;         // angles around circle center.
+	long long fromKey, toKey;
+	int next;
+	bool used;
+};
+
+// directions F1, F2 at C (F2 is 90 degrees counterclockwise from F1).
+
+static void frameAt (const MapObject & c, double f1[3], double f2[3])
+{
+	double ax = (fabs (c.Z()) < 0.9) ? 0 : 1;
+	double az = 1 - ax;
+
+	// f1 = axis x c, f2 = c x f1.
+
+	f1[0] = - az * c.Y();
+	f1[1] = az * c.X() - ax * c.Z();
+	f1[2] = ax * c.Y();
+
+	double n = sqrt (f1[0] * f1[0] + f1[1] * f1[1] + f1[2] * f1[2]);
+
+	for (int k = 0; k < 3; k++) f1[k] /= n;
+
+	f2[0] = c.Y() * f1[2] - c.Z() * f1[1];
+	f2[1] = c.Z() * f1[0] - c.X() * f1[2];
+	f2[2] = c.X() * f1[1] - c.Y() * f1[0];
+}
+
+static MapObject pointOnCircle (const MapObject & c, const double radius, const double f1[3],
+				const double f2[3], const double angle)
+{
+	double cr = cos (radius), sr = sin (radius);
+	double ca = cos (angle), sa = sin (angle);
+
+	return MapObject (cr * c.X() + sr * (ca * f1[0] + sa * f2[0]),
+		cr * c.Y() + sr * (ca * f1[1] + sa * f2[1]),
+		cr * c.Z() + sr * (ca * f1[2] + sa * f2[2]));
+}
+
+// is X on the shorter arc from A to B (X is on their great circle).
+
+static bool onArc (const MapObject & a, const MapObject & b, const MapObject & x)
+{
+	double n[3] =
+	{
+		a.Y() * b.Z() - a.Z() * b.Y(),
+		a.Z() * b.X() - a.X() * b.Z(),
+		a.X() * b.Y() - a.Y() * b.X()
+	};
+
+	double ax = n[0] * (a.Y() * x.Z() - a.Z() * x.Y()) + n[1] * (a.Z() * x.X() - a.X() * x.Z()) +
+		n[2] * (a.X() * x.Y() - a.Y() * x.X());
+	double xb = n[0] * (x.Y() * b.Z() - x.Z() * b.Y()) + n[1] * (x.Z() * b.X() - x.X() * b.Z()) +
+		n[2] * (x.X() * b.Y() - x.Y() * b.X());
+
+	return ax >= 0 && xb >= 0;
+}
+
+// crossings of circle around point I with circle around point J which ON_EDGE keeps (they
+// are on edge of the cell of I): <angle, entering the cell>, and their keys. Both circles
+// get the same key for the same crossing. NORMAL of the edge points into the cell.
+
+template <class OnEdge>
+static void addCrossings (const vector<MapObject> & points, const int i, const int j,
+				const double radiusCos, const double f1[3], const double f2[3], const double normal[3],
+				OnEdge onEdge, vector<pair<double, bool> > & crossings, vector<long long> & keys)
+{
+	const MapObject & c = points[i];
+	const MapObject & d = points[j];
+
+	long long n = (long long) points.size();
+
+	// X = a (c + d) + b w is on both circles.
+
+	double m = c.GetAngleCos (d);
+	double a = radiusCos / (1 + m);
+	double b2 = 1 - 2 * radiusCos * a;
+
+	if (b2 <= 0)
+	{
+		return;
+	}
+
+	int lo = min (i, j), hi = max (i, j);
+
+	double w[3] =
+	{
+		points[lo].Y() * points[hi].Z() - points[lo].Z() * points[hi].Y(),
+		points[lo].Z() * points[hi].X() - points[lo].X() * points[hi].Z(),
+		points[lo].X() * points[hi].Y() - points[lo].Y() * points[hi].X()
+	};
+
+	double wn = sqrt (w[0] * w[0] + w[1] * w[1] + w[2] * w[2]);
+	double b = sqrt (b2) / wn;
+
+	for (int sign = 0; sign < 2; sign++)
+	{
+		double s = sign ? b : -b;
+
+		MapObject x (a * (c.X() + d.X()) + s * w[0], a * (c.Y() + d.Y()) + s * w[1],
+			a * (c.Z() + d.Z()) + s * w[2]);
+
+		if (!onEdge (x))
+		{
+			continue;
+		}
+
+		// moving counterclockwise around c (direction c x X) into the cell?
+
+		double t[3] =
+		{
+			c.Y() * x.Z() - c.Z() * x.Y(),
+			c.Z() * x.X() - c.X() * x.Z(),
+			c.X() * x.Y() - c.Y() * x.X()
+		};
+
+		double inward = t[0] * normal[0] + t[1] * normal[1] + t[2] * normal[2];
+
+		double angle = atan2 (x.X() * f2[0] + x.Y() * f2[1] + x.Z() * f2[2],
+			x.X() * f1[0] + x.Y() * f1[1] + x.Z() * f1[2]);
+
+		crossings.push_back (make_pair (angle, inward > 0));
+		keys.push_back (((lo * n) + hi) * 2 + sign);
+	}
+}
+
+// arcs of circle around point I inside of its cell, between CROSSINGS with the cell edges.
+// Circle which crosses no edge is whole ring, unless the cell is COVERED by it.
+
+static void addArcs (const vector<MapObject> & points, const int i, const double radius,
+				const int vertCount, const double f1[3], const double f2[3],
+				const vector<pair<double, bool> > & crossings, const vector<long long> & keys,
+				const bool covered, vector<UnionArc> & arcs, vector<vector<MapObject> > & rings,
+				vector<int> & ringCircle)
+{
+	const MapObject & c = points[i];
+
+	double step = 2 * M_PI / vertCount;
+
+	if (crossings.empty())
+	{
+		if (!covered)
+		{
+			vector<MapObject> ring;
+
+			for (int k = 0; k < vertCount; k++)
+			{
+				ring.push_back (pointOnCircle (c, radius, f1, f2, k * step));
+			}
+
+			rings.push_back (ring);
+			ringCircle.push_back (i);
+		}
+
+		return;
+	}
+
+	vector<int> byAngle (crossings.size());
+
+	for (size_t k = 0; k < byAngle.size(); k++) byAngle[k] = (int) k;
+
+	sort (byAngle.begin(), byAngle.end(), [&] (int p, int q) { return crossings[p].first < crossings[q].first; });
+
+	for (size_t k = 0; k < byAngle.size(); k++)
+	{
+		int p = byAngle[k], q = byAngle[(k + 1) % byAngle.size()];
+
+		if (!crossings[p].second || crossings[q].second)
+		{
+			continue;
+		}
+
+		double to = crossings[q].first;
+
+		if (to <= crossings[p].first) to += 2 * M_PI;
+
+		arcs.push_back (UnionArc { i, crossings[p].first, to, keys[p], keys[q], -1, false });
+	}
+}
+
+// rings traced along ARCS, and whole circle RINGS, made into polygons. Circles of points
+// joined by EDGES (all pairs of neighbors) overlap when they are close enough.
+
+static void unionPolygons (const vector<MapObject> & points, const double radius, const int vertCount,
+				vector<UnionArc> & arcs, vector<vector<MapObject> > & rings, vector<int> & ringCircle,
+				const vector<pair<int,int> > & edges, vector<vector<vector<MapObject> > > & polygons)
+{
+	double step = 2 * M_PI / vertCount;
+
+	// arc which starts where another ends follows it.
+
+	vector<pair<long long, int> > starts;
+
+	for (int k = 0; k < (int) arcs.size(); k++)
+	{
+		starts.push_back (make_pair (arcs[k].fromKey, k));
+	}
+
+	sort (starts.begin(), starts.end());
+
+	for (auto & arc : arcs)
+	{
+		auto it = lower_bound (starts.begin(), starts.end(), make_pair (arc.toKey, -1));
+
+		if (it != starts.end() && it->first == arc.toKey)
+		{
+			arc.next = it->second;
+		}
+	}
+
+	for (int k = 0; k < (int) arcs.size(); k++)
+	{
+		if (arcs[k].used) continue;
+
+		vector<MapObject> ring;
+
+		int arc = k;
+
+		while (arc >= 0 && !arcs[arc].used)
+		{
+			UnionArc & a = arcs[arc];
+			const MapObject & c = points[a.circle];
+
+			a.used = true;
+
+			double f1[3], f2[3];
+			frameAt (c, f1, f2);
+
+			ring.push_back (pointOnCircle (c, radius, f1, f2, a.from));
+
+			for (double angle = (floor (a.from / step) + 1) * step; angle < a.to; angle += step)
+			{
+				ring.push_back (pointOnCircle (c, radius, f1, f2, angle));
+			}
+
+			arc = a.next;
+		}
+
+		// ring which does not close (numerical trouble at vertex of three circles) is dropped.
+
+		if (arc == k && ring.size() > 2)
+		{
+			rings.push_back (ring);
+			ringCircle.push_back (arcs[k].circle);
+		}
+	}
+
+	// connected parts of the union: circles which overlap are joined.
+
+	vector<int> part (points.size());
+
+	for (size_t i = 0; i < part.size(); i++) part[i] = (int) i;
+
+	auto root = [&] (int i)
+	{
+		while (part[i] != i) i = part[i] = part[part[i]];
+		return i;
+	};
+
+	double overlapCos = cos (2 * radius);
+
+	for (auto & edge : edges)
+	{
+		if (points[edge.first].GetAngleCos (points[edge.second]) >= overlapCos)
+		{
+			part[root (edge.first)] = root (edge.second);
+		}
+	}
+
+	// outer rings and holes. Hole is inside of outer ring of its own part; when a part has
+	// more of them (only possible around the globe), the smallest one around it is taken.
+
+	vector<double> areas;
+	vector<int> outer;
+	vector<int> partOuter (points.size(), -1);
+	vector<int> partOuters (points.size(), 0);
+
+	for (size_t r = 0; r < rings.size(); r++)
+	{
+		areas.push_back (GeoUtils::ringArea (rings[r]));
+
+		if (areas.back() > 0)
+		{
+			int p = root (ringCircle[r]);
+
+			partOuter[p] = (int) outer.size();
+			partOuters[p]++;
+
+			outer.push_back ((int) r);
+			polygons.push_back (vector<vector<MapObject> > (1, rings[r]));
+		}
+	}
+
+	for (size_t r = 0; r < rings.size(); r++)
+	{
+		if (areas[r] > 0) continue;
+
+		int p = root (ringCircle[r]);
+
+		if (partOuters[p] == 1)
+		{
+			polygons[partOuter[p]].push_back (rings[r]);
+			continue;
+		}
+
+		int best = -1;
+
+		for (size_t o = 0; o < outer.size(); o++)
+		{
+			if (GeoUtils::ringContains (rings[outer[o]], rings[r].front()) &&
+				(best < 0 || areas[outer[o]] < areas[outer[best]]))
+			{
+				best = (int) o;
+			}
+		}
+
+		if (best >= 0)
+		{
+			polygons[best].push_back (rings[r]);
+		}
+	}
+}
+
+void SphericalDelaunay::circlesUnion (const double radius, const int vertCount,
+				vector<vector<vector<MapObject> > > & polygons) const
+{
+	polygons.clear();
+
+	if (faces.empty())
+	{
+		circlesUnionOnCircle (radius, vertCount, polygons);
+		return;
+	}
+
+	double radiusCos = cos (radius);
+
+	vector<UnionArc> arcs;
+	vector<vector<MapObject> > rings;
+	vector<int> ringCircle;
+
+	vector<int> around;
+
+	for (int i = 0; i < (int) points.size(); i++)
+	{
+		if (!facesAround (i, around))
+		{
+			continue;
+		}
+
+		const MapObject & c = points[i];
+
+		double f1[3], f2[3];
+		frameAt (c, f1, f2);
+
+		vector<pair<double, bool> > crossings;
+		vector<long long> keys;
+
+		bool allInside = true;
+
+		for (size_t k = 0; k < around.size(); k++)
+		{
+			const Face & f = faces[around[k]];
+
+			int at = (f.v[0] == i) ? 0 : (f.v[1] == i) ? 1 : 2;
+			int j = f.v[(at + 2) % 3];
+
+			MapObject from = circumcenter (around[k]);
+			MapObject to = circumcenter (around[(k + 1) % around.size()]);
+
+			if (from.GetAngleCos (c) < radiusCos) allInside = false;
+
+			double normal[3] =
+			{
+				from.Y() * to.Z() - from.Z() * to.Y(),
+				from.Z() * to.X() - from.X() * to.Z(),
+				from.X() * to.Y() - from.Y() * to.X()
+			};
+
+			addCrossings (points, i, j, radiusCos, f1, f2, normal,
+				[&] (const MapObject & x) { return onArc (from, to, x); }, crossings, keys);
+		}
+
+		// cell inside of circle means it is covered.
+
+		addArcs (points, i, radius, vertCount, f1, f2, crossings, keys, allInside, arcs, rings, ringCircle);
+	}
+
+	// nearest neighbors are among Delaunay edges.
+
+	vector<pair<int,int> > edges;
+
+	for (auto & f : faces)
+	{
+		for (int k = 0; k < 3 && f.alive; k++)
+		{
+			edges.push_back (make_pair (f.v[k], f.v[(k + 1) % 3]));
+		}
+	}
+
+	unionPolygons (points, radius, vertCount, arcs, rings, ringCircle, edges, polygons);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+// union when build failed: fewer than 4 points, or all of them on one circle. Then all
+// bisectors go through poles of that circle, and cell of a point is the lune between its
+// bisectors with neighbors along the circle (one neighbor for 2 points, none for 1).
+//////////////////////////////////////////////////////////////////////////////////////////
+
+void SphericalDelaunay::circlesUnionOnCircle (const double radius, const int vertCount,
+				vector<vector<vector<MapObject> > > & polygons) const
+{
+	int n = (int) points.size();
+
+	double radiusCos = cos (radius);
+
+	// points in order around the axis of their circle.
+
+	vector<int> chain (n);
+
+	for (int i = 0; i < n; i++) chain[i] = i;
+
+	double axis[3] = { 0, 0, 0 };
+
+	if (n > 2)
+	{
+		double bx = points[1].X() - points[0].X(), by = points[1].Y() - points[0].Y(), bz = points[1].Z() - points[0].Z();
+		double cx = points[2].X() - points[0].X(), cy = points[2].Y() - points[0].Y(), cz = points[2].Z() - points[0].Z();
+
+		axis[0] = by * cz - bz * cy;
+		axis[1] = bz * cx - bx * cz;
+		axis[2] = bx * cy - by * cx;
+
+		double norm = sqrt (axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2]);
+
+		for (int k = 0; k < 3; k++) axis[k] /= norm;
+
+		double f1[3], f2[3];
+		frameAt (MapObject (axis[0], axis[1], axis[2]), f1, f2);
+
+		vector<double> angles;
+
+		for (auto & p : points)
+		{
+			angles.push_back (atan2 (p.X() * f2[0] + p.Y() * f2[1] + p.Z() * f2[2],
+				p.X() * f1[0] + p.Y() * f1[1] + p.Z() * f1[2]));
+		}
+
+		sort (chain.begin(), chain.end(), [&] (int p, int q) { return angles[p] < angles[q]; });
+	}
+
+	vector<int> position (n);
+
+	for (int k = 0; k < n; k++) position[chain[k]] = k;
+
+	auto neighbors = [&] (const int i, vector<int> & output)
+	{
+		output.clear();
+
+		if (n > 1) output.push_back (chain[(position[i] + 1) % n]);
+		if (n > 2) output.push_back (chain[(position[i] + n - 1) % n]);
+	};
+
+	vector<UnionArc> arcs;
+	vector<vector<MapObject> > rings;
+	vector<int> ringCircle;
+
+	vector<int> around, others;
+
+	for (int i = 0; i < n; i++)
+	{
+		const MapObject & c = points[i];
+
+		double f1[3], f2[3];
+		frameAt (c, f1, f2);
+
+		vector<pair<double, bool> > crossings;
+		vector<long long> keys;
+
+		neighbors (i, around);
+
+		for (int j : around)
+		{
+			const MapObject & d = points[j];
+
+			// crossing is on the edge when no neighbor of I or J is closer to it (compared
+			// from the same point for both circles, so that their arcs meet).
+
+			neighbors (j, others);
+			others.insert (others.end(), around.begin(), around.end());
+
+			const MapObject & p = points[min (i, j)];
+
+			auto onEdge = [&] (const MapObject & x)
+			{
+				for (int k : others)
+				{
+					if (k != i && k != j && x.GetAngleCos (points[k]) > x.GetAngleCos (p)) return false;
+				}
+
+				return true;
+			};
+
+			double normal[3] = { c.X() - d.X(), c.Y() - d.Y(), c.Z() - d.Z() };
+
+			addCrossings (points, i, j, radiusCos, f1, f2, normal, onEdge, crossings, keys);
+		}
+
+		// circle which crosses no edge covers the cell when it holds its corner: pole of the
+		// circle of points, or for 2 points the farthest point of their bisector.
+
+		bool covered = false;
+
+		if (n > 2)
+		{
+			double h = c.X() * axis[0] + c.Y() * axis[1] + c.Z() * axis[2];
+
+			covered = fabs (h) >= radiusCos;
+		}
+		else if (n == 2)
+		{
+			const MapObject & d = points[around[0]];
+
+			double x = c.X() + d.X(), y = c.Y() + d.Y(), z = c.Z() + d.Z();
+			double norm = sqrt (x * x + y * y + z * z);
+
+			covered = norm > 0 && -(x * c.X() + y * c.Y() + z * c.Z()) / norm >= radiusCos;
+		}
+
+		addArcs (points, i, radius, vertCount, f1, f2, crossings, keys, covered, arcs, rings, ringCircle);
+	}
+
+	vector<pair<int,int> > edges;
+
+	for (int k = 0; k + 1 < n; k++)
+	{
+		edges.push_back (make_pair (chain[k], chain[k + 1]));
+	}
+
+	if (n > 2)
+	{
+		edges.push_back (make_pair (chain[n - 1], chain[0]));
+	}
+
+	unionPolygons (points, radius, vertCount, arcs, rings, ringCircle, edges, polygons);
+}
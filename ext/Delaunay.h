@@ -0,0 +1,135 @@
+/* geojson, Copyright (c) 2013-2020 Yuriy Yakimenko
+ *
+ * Permission to use, copy, modify, distribute, and sell this software and its
+ * documentation for any purpose is hereby granted without fee, provided that
+ * the above copyright notice appear in all copies and that both that
+ * copyright notice and this permission notice appear in supporting
+ * documentation.  No representations are made about the suitability of this
+ * software for any purpose.  It is provided "as is" without express or
+ * implied warranty.
+ */
+
+#pragma once
+
+#include <vector>
+#include "MapObject.h"
+
+//////////////////////////////////////////////////////////////////////////////////////////
+// Delaunay triangulation of points on the sphere, and its dual Voronoi diagram.
+//
+// Points are on the unit sphere, so triangle has empty circumcircle exactly when it is a
+// face of 3D convex hull of the points: circle is where the plane of the face cuts the
+// sphere. Hull is built by adding points one by one. Face hit by the ray from a point
+// inside of hull towards the new point is found by walking over faces from the last
+// created one, faces visible from it are replaced by fan of faces to their boundary.
+// Points are added in order of Hilbert curve, so walks are short and build is
+// O(n log n) in practice (sorting), only bad inputs walk far.
+//
+// Hull of points which are not all over the sphere also has faces on the far side, their
+// circles are larger than hemisphere. They are kept (Voronoi diagram needs them), but are
+// not Delaunay triangles of the area, see isInner.
+//////////////////////////////////////////////////////////////////////////////////////////
+
+class SphericalDelaunay
+{
+private:
+	struct Face
+	{
+		int v[3];       // vertices, counterclockwise seen from outside.
+		int next[3];    // face across edge opposite to v[i].
+		bool alive;
+		unsigned stamp;
+	};
+
+	std::vector<MapObject> points;
+	std::vector<std::pair<double,double> > planar;  // stereographic projection of points.
+	std::vector<int> order;          // index of point in input (duplicates are dropped).
+	std::vector<Face> faces;
+	std::vector<int> freeFaces;
+	std::vector<int> vertexFace;     // some face of each vertex, -1 for skipped points.
+
+	// edge (A, B) of faces visible from inserted point, with face OUTSIDE of them.
+	struct Edge
+	{
+		int a, b, outside, from;
+	};
+
+	// work space of insert.
+	std::vector<int> visible, corners, starts;
+	std::vector<Edge> horizon;
+	std::vector<std::pair<int,int> > starting, ending;
+
+	MapObject inside;                // point inside of hull, for walking.
+	int lastFace;
+	unsigned stamp;
+	long skipped;
+
+	void project ();
+	int orient (const int face, const int q) const;
+	int locate (const MapObject & q);
+	int newFace (const int a, const int b, const int c);
+	bool insert (const int index);
+	void circlesUnionOnCircle (const double radius, const int vertCount,
+		std::vector<std::vector<std::vector<MapObject> > > & polygons) const;
+
+public:
+	SphericalDelaunay ();
+
+	// points have order <longitude,latitude>. False when all of them are on one circle.
+	bool build (const std::vector<std::pair<double,double> > & input);
+
+	size_t size () const { return points.size(); }
+
+	// index in input of point I (I from 0 to size()).
+	int inputIndex (const int i) const { return order[i]; }
+	const MapObject & point (const int i) const { return points[i]; }
+
+	// points dropped because their projections coincide with those of others (distinct
+	// points which rounding of projection merged).
+	long skippedCount () const { return skipped; }
+
+	int faceCount () const { return (int) faces.size(); }
+	bool isAlive (const int face) const { return faces[face].alive; }
+	int vertex (const int face, const int i) const { return faces[face].v[i]; }
+	int neighbor (const int face, const int i) const { return faces[face].next[i]; }
+
+	// face is Delaunay triangle of the area covered by points: its circle is smaller than
+	// hemisphere (center of the earth is inside of hull, below the face).
+	bool isInner (const int face) const;
+
+	// all faces are inner, with circles clearly smaller than hemisphere: points are all
+	// over the sphere, and area covered by them has no edge.
+	bool coversSphere () const;
+
+	// center of circle through face vertices, on the side of its empty cap (same point as
+	// MapObject::equidistantPoint for inner faces), and its radius as angle (radians).
+	MapObject circumcenter (const int face) const;
+	double circumradius (const int face) const;
+
+	// Delaunay triangles of the area, as point indexes.
+	void triangles (std::vector<std::vector<int> > & output) const;
+
+	// faces around point I, counterclockwise. Their circumcenters are vertices of its Voronoi cell.
+	bool facesAround (const int i, std::vector<int> & output) const;
+	bool voronoiCell (const int i, std::vector<MapObject> & output) const;
+
+	// largest circle (radius as angle) with center inside of convex polygon REGION (whole
+	// sphere when it is empty) and no point inside of it. False when REGION has no area, or
+	// is empty while points do not cover the sphere.
+	bool largestEmptyCircle (const std::vector<MapObject> & region, MapObject & center, double & radius) const;
+
+	// alpha shape: union of Delaunay triangles whose circle radius (angle) is not larger
+	// than ALPHA. Each polygon is outer ring (counterclockwise) and its holes (clockwise),
+	// as point indexes.
+	void alphaShape (const double alpha, std::vector<std::vector<std::vector<int> > > & polygons) const;
+
+	// union of circles of RADIUS (angle) around all points, with VERTCOUNT points per
+	// full circle. Each polygon is outer ring (counterclockwise) and its holes (clockwise).
+	// Also works when build returned false (fewer than 4 points, or all on one circle).
+	void circlesUnion (const double radius, const int vertCount,
+		std::vector<std::vector<std::vector<MapObject> > > & polygons) const;
+
+	// part of convex polygon POLYGON (counterclockwise) inside of convex polygon CLIP.
+	static void clip (const std::vector<MapObject> & polygon, const std::vector<MapObject> & clip,
+		std::vector<MapObject> & output);
+};
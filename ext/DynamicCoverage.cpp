@@ -0,0 +1,458 @@
+/* geojson, Copyright (c) 2013-2020 Yuriy Yakimenko
+ *
+ * Permission to use, copy, modify, distribute, and sell this software and its
+ * documentation for any purpose is hereby granted without fee, provided that
+ * the above copyright notice appear in all copies and that both that
+ * copyright notice and this permission notice appear in supporting
+ * documentation.  No representations are made about the suitability of this
+ * software for any purpose.  It is provided "as is" without express or 
+ * implied warranty.
+ */
+
+#include "DynamicCoverage.h"
+#include "GeoUtils.h"
+
+#include <algorithm>
+
+using namespace std;
+
+DynamicCoverage::DynamicCoverage () : center(0, 0, 1), u(1, 0, 0), v(0, 1, 0),
+	valid(false), nextId(0), recalculated(0)
+{
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+double DynamicCoverage::angleOf (const MapObject & obj) const
+{
+	return atan2 (obj.GetAngleCos (v), obj.GetAngleCos (u));
+}
+
+bool DynamicCoverage::inHemisphere (const MapObject & obj) const
+{
+	return obj.GetAngleCos (center) > 1e-6;
+}
+
+DynamicCoverage::HullMap::iterator DynamicCoverage::nextOf (HullMap::iterator it)
+{
+	++it;
+	return (it == hull.end()) ? hull.begin() : it;
+}
+
+DynamicCoverage::HullMap::iterator DynamicCoverage::prevOf (HullMap::iterator it)
+{
+	if (it == hull.begin()) it = hull.end();
+	return --it;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+// new center (direction of sum of all points), new angles and hull from scratch.
+// Only needed at start and when hull gets too thin to keep its center inside.
+//////////////////////////////////////////////////////////////////////////////////////////
+
+void DynamicCoverage::rebuild ()
+{
+	hull.clear();
+	valid = false;
+
+	if (sites.empty())
+	{
+		return;
+	}
+
+	double cx = 0, cy = 0, cz = 0;
+
+	for (auto & entry : sites)
+	{
+		cx += entry.second.obj.X();
+		cy += entry.second.obj.Y();
+		cz += entry.second.obj.Z();
+	}
+
+	double n = sqrt (cx * cx + cy * cy + cz * cz);
+
+	center = (n > 0) ? MapObject (cx / n, cy / n, cz / n) : sites.begin()->second.obj;
+
+	MapObject axis = (fabs (center.Z()) < 0.9) ? MapObject (0, 0, 1) : MapObject (1, 0, 0);
+	u = MapObject::crossProduct (axis, center);
+	v = MapObject::crossProduct (center, u);
+
+	SiteMap rekeyed;
+	vector<MapObject> objects;
+	vector<const Site *> order;
+	bool hemisphere = true;
+
+	for (auto & entry : sites)
+	{
+		rekeyed.insert (make_pair (angleOf (entry.second.obj), entry.second));
+		hemisphere = hemisphere && inHemisphere (entry.second.obj);
+	}
+
+	sites.swap (rekeyed);
+
+	for (auto & entry : sites)
+	{
+		objects.push_back (entry.second.obj);
+		order.push_back (&entry.second);
+	}
+
+	vector<long> indexes;
+
+	if (!GeoUtils::getHullIndexes (objects, indexes))
+	{
+		return;
+	}
+
+	for (long index : indexes)
+	{
+		hull.insert (make_pair (angleOf (objects[index]), *order[index]));
+	}
+
+	if (!hemisphere || hull.size() < 3)
+	{
+		return;
+	}
+
+	for (auto it = hull.begin(); it != hull.end(); ++it)
+	{
+		if (MapObject::orientation (it->second.obj, nextOf (it)->second.obj, center) <= 0)
+		{
+			return;
+		}
+	}
+
+	valid = true;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+void DynamicCoverage::build (const vector<pair<double,double> > & points)
+{
+	sites.clear();
+	fragments.clear();
+
+	for (auto & pt : points)
+	{
+		sites.insert (make_pair (0.0, Site (nextId++, pt)));
+	}
+
+	rebuild();
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+// point inside of the hull costs one map lookup and one orientation test.
+//////////////////////////////////////////////////////////////////////////////////////////
+
+void DynamicCoverage::insert (const pair<double,double> & point)
+{
+	Site site (nextId++, point);
+
+	if (!valid || !inHemisphere (site.obj))
+	{
+		sites.insert (make_pair (0.0, site));
+		rebuild();
+		return;
+	}
+
+	double angle = angleOf (site.obj);
+
+	sites.insert (make_pair (angle, site));
+
+	auto b = hull.upper_bound (angle);
+	if (b == hull.end()) b = hull.begin();
+	auto a = prevOf (b);
+
+	if (MapObject::orientation (a->second.obj, b->second.obj, site.obj) >= 0)
+	{
+		return; // inside of hull or on its edge.
+	}
+
+	// vertex in the same direction is closer to center than new one, so it is inside now.
+
+	auto same = hull.find (angle);
+
+	if (same != hull.end())
+	{
+		hull.erase (same);
+	}
+
+	auto it = hull.insert (make_pair (angle, site)).first;
+
+	// remove neighbors which new vertex makes concave. Center stays inside, so there will be
+	// at least three vertices left.
+
+	while (hull.size() > 3)
+	{
+		auto n1 = nextOf (it);
+		auto n2 = nextOf (n1);
+
+		if (MapObject::orientation (site.obj, n1->second.obj, n2->second.obj) > 0) break;
+
+		hull.erase (n1);
+	}
+
+	while (hull.size() > 3)
+	{
+		auto p1 = prevOf (it);
+		auto p2 = prevOf (p1);
+
+		if (MapObject::orientation (p2->second.obj, p1->second.obj, site.obj) > 0) break;
+
+		hull.erase (p1);
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+// hull between PREV and NEXT (which stay hull vertices) is made from points with angles
+// between theirs, using Graham scan - those are already sorted by angle around center.
+//////////////////////////////////////////////////////////////////////////////////////////
+
+void DynamicCoverage::patch (HullMap::iterator prev, HullMap::iterator next)
+{
+	double a0 = prev->first;
+	double a1 = next->first;
+
+	vector<const Site *> chain;
+	chain.push_back (&prev->second);
+
+	auto add = [&chain] (const Site * site)
+	{
+		while (chain.size() >= 2 &&
+			MapObject::orientation (chain[chain.size() - 2]->obj, chain.back()->obj, site->obj) <= 0)
+		{
+			chain.pop_back();
+		}
+		chain.push_back (site);
+	};
+
+	// points at exactly a0 or a1 are between center and PREV (NEXT), so not needed.
+
+	auto it = sites.upper_bound (a0);
+
+	for (int round = 0; round < 2; round++)
+	{
+		auto end = (a0 < a1 || round == 1) ? sites.lower_bound (a1) : sites.end();
+
+		for (; it != end; ++it)
+		{
+			add (&it->second);
+		}
+
+		if (a0 < a1) break;
+
+		it = sites.begin(); // wraps over -PI.
+	}
+
+	add (&next->second);
+
+	for (size_t i=0; i + 1 < chain.size(); i++)
+	{
+		if (MapObject::orientation (chain[i]->obj, chain[i + 1]->obj, center) <= 0)
+		{
+			rebuild();
+			return;
+		}
+	}
+
+	for (size_t i=1; i + 1 < chain.size(); i++)
+	{
+		hull.insert (make_pair (angleOf (chain[i]->obj), *chain[i]));
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+bool DynamicCoverage::erase (const pair<double,double> & point)
+{
+	if (sites.empty())
+	{
+		return false;
+	}
+
+	MapObject obj (TLatLong (point.second, point.first));
+
+	double angle = angleOf (obj);
+
+	auto range = sites.equal_range (angle);
+	auto found = sites.end();
+	auto other = sites.end();
+
+	for (auto it = range.first; it != range.second; ++it)
+	{
+		if (it->second.coord != point) continue;
+
+		if (found == sites.end()) found = it; else other = it;
+	}
+
+	if (found == sites.end())
+	{
+		return false;
+	}
+
+	long id = found->second.id;
+
+	sites.erase (found);
+
+	if (!valid)
+	{
+		rebuild();
+		return true;
+	}
+
+	auto vertex = hull.find (angle);
+
+	if (vertex == hull.end() || vertex->second.id != id)
+	{
+		return true; // not a hull vertex.
+	}
+
+	if (other != sites.end())
+	{
+		vertex->second = other->second; // same point is still there.
+		return true;
+	}
+
+	if (hull.size() <= 3)
+	{
+		rebuild();
+		return true;
+	}
+
+	auto prev = prevOf (vertex);
+	auto next = nextOf (vertex);
+
+	hull.erase (vertex);
+
+	patch (prev, next);
+
+	return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+// part of outline which belongs to SITE: points of its ring which are on the hull of rings
+// of SITE and its two neighbors.
+//////////////////////////////////////////////////////////////////////////////////////////
+
+void DynamicCoverage::makeFragment (const Site & prev, const Site & site, const Site & next,
+		const double radiusMiles, const int vertCount, Fragment & fragment)
+{
+	double trueR = MapObject::getTrueRadius (radiusMiles, vertCount);
+
+	vector<TLatLongSP> rings;
+
+	MapObject::getNPointsAround (TLatLong (prev.coord.second, prev.coord.first), trueR, vertCount, rings);
+	MapObject::getNPointsAround (TLatLong (site.coord.second, site.coord.first), trueR, vertCount, rings);
+	MapObject::getNPointsAround (TLatLong (next.coord.second, next.coord.first), trueR, vertCount, rings);
+
+	vector<MapObject> objects;
+
+	for (auto & ll : rings)
+	{
+		objects.emplace_back (*ll);
+	}
+
+	fragment.prev = prev.id;
+	fragment.next = next.id;
+	fragment.radiusMiles = radiusMiles;
+	fragment.vertCount = vertCount;
+	fragment.points.clear();
+
+	vector<long> indexes;
+
+	if (!GeoUtils::getHullIndexes (objects, indexes) || indexes.size() < 3)
+	{
+		return;
+	}
+
+	if (MapObject::orientation (objects[indexes[0]], objects[indexes[1]], objects[indexes[2]]) < 0)
+	{
+		reverse (indexes.begin(), indexes.end());
+	}
+
+	auto own = [vertCount] (long index) { return index >= vertCount && index < 2 * vertCount; };
+
+	size_t h = indexes.size();
+
+	for (size_t i = 0; i < h; i++)
+	{
+		if (own (indexes[i]) && !own (indexes[(i + h - 1) % h]))
+		{
+			for (size_t k = i; own (indexes[k % h]) && k < i + h; k++)
+			{
+				TLatLongSP & ll = rings[indexes[k % h]];
+				fragment.points.push_back (make_pair (ll->Longitude(), ll->Latitude()));
+			}
+			break;
+		}
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+bool DynamicCoverage::polygon (const double radiusMiles, const int vertCount,
+		vector<pair<double,double> > & output)
+{
+	recalculated = 0;
+
+	if (!valid)
+	{
+		// one or two points, or all of them on one line: nothing to keep between calls.
+
+		fragments.clear();
+
+		vector<pair<double,double> > points;
+
+		for (auto & entry : sites)
+		{
+			points.push_back (entry.second.coord);
+		}
+
+		if (points.empty())
+		{
+			return false;
+		}
+
+		recalculated = (int) hull.size();
+
+		if (points.size() == 1)
+		{
+			return GeoUtils::getPointsAroundCoordinate (TLatLong (points[0].second, points[0].first),
+				radiusMiles, vertCount, output);
+		}
+
+		return GeoUtils::getConvexHull (points, output, radiusMiles, vertCount);
+	}
+
+	unordered_map<long, Fragment> used;
+
+	for (auto it = hull.begin(); it != hull.end(); ++it)
+	{
+		const Site & prev = prevOf (it)->second;
+		const Site & next = nextOf (it)->second;
+
+		auto cached = fragments.find (it->second.id);
+
+		Fragment & fragment = used[it->second.id];
+
+		if (cached != fragments.end() && cached->second.prev == prev.id && cached->second.next == next.id &&
+			cached->second.radiusMiles == radiusMiles && cached->second.vertCount == vertCount)
+		{
+			fragment.points.swap (cached->second.points);
+			fragment.prev = prev.id;
+			fragment.next = next.id;
+			fragment.radiusMiles = radiusMiles;
+			fragment.vertCount = vertCount;
+		}
+		else
+		{
+			makeFragment (prev, it->second, next, radiusMiles, vertCount, fragment);
+			recalculated++;
+		}
+
+		output.insert (output.end(), fragment.points.begin(), fragment.points.end());
+	}
+
+	fragments.swap (used);
+
+	return !output.empty();
+}
@@ -0,0 +1,90 @@
+/* geojson, Copyright (c) 2013-2020 Yuriy Yakimenko
+ *
+ * Permission to use, copy, modify, distribute, and sell this software and its
+ * documentation for any purpose is hereby granted without fee, provided that
+ * the above copyright notice appear in all copies and that both that
+ * copyright notice and this permission notice appear in supporting
+ * documentation.  No representations are made about the suitability of this
+ * software for any purpose.  It is provided "as is" without express or 
+ * implied warranty.
+ */
+
+#pragma once
+
+#include <map>
+#include <unordered_map>
+#include <vector>
+#include "MapObject.h"
+
+//////////////////////////////////////////////////////////////////////////////////////////
+// Coverage area (same as GeoUtils::getConvexHull) of a set of points which changes over time.
+//
+// Points are kept sorted by angle around a fixed center inside the hull, and so are hull
+// vertices. Inserted point is checked against the one hull edge in its direction and, when
+// outside, only neighbors it hides are removed. When hull vertex is erased, only points
+// between its two neighbors are looked at to patch the hull. Buffered outline is kept
+// per hull vertex and recalculated only for vertices whose neighbors changed.
+//////////////////////////////////////////////////////////////////////////////////////////
+
+class DynamicCoverage
+{
+private:
+	struct Site
+	{
+		long id;
+		MapObject obj;
+		std::pair<double,double> coord; // <longitude,latitude>
+
+		Site (const long i, const std::pair<double,double> & c) : id(i), obj(TLatLong(c.second, c.first)), coord(c) { }
+	};
+
+	struct Fragment
+	{
+		long prev, next;
+		double radiusMiles;
+		int vertCount;
+		std::vector<std::pair<double,double> > points;
+	};
+
+	typedef std::multimap<double, Site> SiteMap;
+	typedef std::map<double, Site> HullMap;
+
+	SiteMap sites;  // all points, by angle around center.
+	HullMap hull;   // hull vertices, by angle around center (so counterclockwise).
+
+	MapObject center, u, v;
+	bool valid;     // center is strictly inside of hull, which has 3 or more vertices.
+	long nextId;
+	int recalculated;
+
+	std::unordered_map<long, Fragment> fragments;
+
+	double angleOf (const MapObject & obj) const;
+	bool inHemisphere (const MapObject & obj) const;
+
+	HullMap::iterator nextOf (HullMap::iterator it);
+	HullMap::iterator prevOf (HullMap::iterator it);
+
+	void rebuild ();
+	void patch (HullMap::iterator prev, HullMap::iterator next);
+	void makeFragment (const Site & prev, const Site & site, const Site & next,
+		const double radiusMiles, const int vertCount, Fragment & fragment);
+
+public:
+	DynamicCoverage ();
+
+	void build (const std::vector<std::pair<double,double> > & points);
+
+	void insert (const std::pair<double,double> & point);
+	bool erase (const std::pair<double,double> & point);
+
+	// same polygon as GeoUtils::getConvexHull gives for current points.
+	bool polygon (const double radiusMiles, const int vertCount,
+		std::vector<std::pair<double,double> > & output);
+
+	size_t size () const { return sites.size(); }
+	size_t hullSize () const { return hull.size(); }
+
+	// number of hull vertices whose part of outline was recalculated by last polygon call.
+	int recalculatedCount () const { return recalculated; }
+};
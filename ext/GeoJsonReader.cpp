@@ -0,0 +1,378 @@
+/* geojson, Copyright (c) 2013-2020 Yuriy Yakimenko
+ *
+ * Permission to use, copy, modify, distribute, and sell this software and its
+ * documentation for any purpose is hereby granted without fee, provided that
+ * the above copyright notice appear in all copies and that both that
+ * copyright notice and this permission notice appear in supporting
+ * documentation.  No representations are made about the suitability of this
+ * software for any purpose.  It is provided "as is" without express or
+ * implied warranty.
+ */
+
+#include "GeoJsonReader.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+using namespace std;
+
+// nested arrays of "coordinates" member, down to positions.
+
+struct Coordinates
+{
+	vector<Coordinates> items;
+	double longitude, latitude;
+	bool position;
+
+	Coordinates () : longitude(0), latitude(0), position(false) { }
+};
+
+// what is needed of a GeoJSON object: its type, coordinates and objects inside of it
+// ("geometry", "features" or "geometries").
+
+struct GeoObject
+{
+	string type;
+	Coordinates coordinates;
+	vector<GeoObject> children;
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////
+// recursive descent over JSON text; members other than above are skipped.
+//////////////////////////////////////////////////////////////////////////////////////////
+
+static const int MAX_DEPTH = 256;
+
+struct Parser
+{
+	const char * p;
+	const char * end;
+
+	Parser (const char * text, const size_t length) : p(text), end(text + length) { }
+
+	void space ()
+	{
+		while (p < end && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r')) p++;
+	}
+
+	bool expect (const char c)
+	{
+		space();
+
+		if (p < end && *p == c)
+		{
+			p++;
+			return true;
+		}
+
+		return false;
+	}
+
+	bool peek (const char c)
+	{
+		space();
+
+		return p < end && *p == c;
+	}
+
+	bool text (string & value)
+	{
+		if (!expect ('"')) return false;
+
+		value.clear();
+
+		while (p < end && *p != '"')
+		{
+			if (*p == '\\')
+			{
+				if (++p == end) return false;
+
+				// escaped characters are not needed in type names, kept as they are.
+
+				if (*p == 'u')
+				{
+					if (end - p < 5) return false;
+					p += 4;
+				}
+			}
+
+			value += *p++;
+		}
+
+		return expect ('"');
+	}
+
+	bool number (double & value)
+	{
+		space();
+
+		char * after = nullptr;
+
+		// JSON numbers end before any character strtod would take further.
+
+		char buffer[64];
+		size_t length = 0;
+
+		while (p + length < end && length + 1 < sizeof(buffer) && strchr ("+-0123456789.eE", p[length]))
+		{
+			buffer[length] = p[length];
+			length++;
+		}
+
+		buffer[length] = 0;
+
+		value = strtod (buffer, &after);
+
+		if (after == buffer) return false;
+
+		p += after - buffer;
+
+		return true;
+	}
+
+	bool skip (const int depth)
+	{
+		space();
+
+		if (p == end || depth > MAX_DEPTH) return false;
+
+		if (*p == '"')
+		{
+			string value;
+			return text (value);
+		}
+
+		if (*p == '{' || *p == '[')
+		{
+			char close = (*p == '{') ? '}' : ']';
+
+			p++;
+
+			if (expect (close)) return true;
+
+			do
+			{
+				if (close == '}')
+				{
+					string key;
+
+					if (!text (key) || !expect (':')) return false;
+				}
+
+				if (!skip (depth + 1)) return false;
+			}
+			while (expect (','));
+
+			return expect (close);
+		}
+
+		if (*p == 't' || *p == 'f' || *p == 'n')
+		{
+			while (p < end && *p >= 'a' && *p <= 'z') p++;
+			return true;
+		}
+
+		double value;
+
+		return number (value);
+	}
+
+	bool coordinates (Coordinates & c, const int depth)
+	{
+		if (!expect ('[') || depth > MAX_DEPTH) return false;
+
+		if (expect (']')) return true;
+
+		space();
+
+		if (p < end && *p != '[')
+		{
+			// position: longitude, latitude and maybe altitude (skipped).
+
+			c.position = true;
+
+			if (!number (c.longitude) || !expect (',') || !number (c.latitude)) return false;
+
+			double altitude;
+
+			while (expect (','))
+			{
+				if (!number (altitude)) return false;
+			}
+
+			return expect (']');
+		}
+
+		do
+		{
+			c.items.push_back (Coordinates ());
+
+			if (!coordinates (c.items.back(), depth + 1)) return false;
+		}
+		while (expect (','));
+
+		return expect (']');
+	}
+
+	bool object (GeoObject & o, const int depth)
+	{
+		if (!expect ('{') || depth > MAX_DEPTH) return false;
+
+		if (expect ('}')) return true;
+
+		do
+		{
+			string key;
+
+			if (!text (key) || !expect (':')) return false;
+
+			bool ok;
+
+			if (key == "type" && peek ('"'))
+			{
+				ok = text (o.type);
+			}
+			else if (key == "coordinates" && peek ('['))
+			{
+				ok = coordinates (o.coordinates, depth + 1);
+			}
+			else if (key == "geometry" && peek ('{'))
+			{
+				o.children.push_back (GeoObject ());
+				ok = object (o.children.back(), depth + 1);
+			}
+			else if ((key == "features" || key == "geometries") && peek ('['))
+			{
+				ok = objects (o.children, depth + 1);
+			}
+			else
+			{
+				ok = skip (depth + 1);
+			}
+
+			if (!ok) return false;
+		}
+		while (expect (','));
+
+		return expect ('}');
+	}
+
+	// array of objects, other values in it skipped.
+
+	bool objects (vector<GeoObject> & output, const int depth)
+	{
+		if (!expect ('[')) return false;
+
+		if (expect (']')) return true;
+
+		do
+		{
+			if (peek ('{'))
+			{
+				output.push_back (GeoObject ());
+
+				if (!object (output.back(), depth + 1)) return false;
+			}
+			else if (!skip (depth + 1))
+			{
+				return false;
+			}
+		}
+		while (expect (','));
+
+		return expect (']');
+	}
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+static void addPolygon (const Coordinates & rings, vector<vector<vector<pair<double,double> > > > & polygons)
+{
+	polygons.push_back (vector<vector<pair<double,double> > > ());
+
+	for (auto & ring : rings.items)
+	{
+		polygons.back().push_back (vector<pair<double,double> > ());
+
+		for (auto & position : ring.items)
+		{
+			if (position.position)
+			{
+				polygons.back().back().push_back (make_pair (position.longitude, position.latitude));
+			}
+		}
+	}
+}
+
+static void collect (const GeoObject & o, vector<vector<vector<pair<double,double> > > > & polygons,
+			vector<long> & geometries, long & geometry)
+{
+	size_t count = polygons.size();
+
+	if (o.type == "Polygon")
+	{
+		addPolygon (o.coordinates, polygons);
+	}
+	else if (o.type == "MultiPolygon")
+	{
+		for (auto & polygon : o.coordinates.items)
+		{
+			addPolygon (polygon, polygons);
+		}
+	}
+	else
+	{
+		for (auto & child : o.children)
+		{
+			collect (child, polygons, geometries, geometry);
+		}
+
+		return;
+	}
+
+	if (polygons.size() > count)
+	{
+		geometries.resize (polygons.size(), geometry++);
+	}
+}
+
+bool GeoJsonReader::readPolygons (const char * filename, vector<vector<vector<pair<double,double> > > > & polygons,
+				vector<long> & geometries)
+{
+	FILE * input = fopen (filename, "rb");
+
+	if (!input)
+	{
+		fprintf (stderr, "Cannot open %s\n", filename);
+		return false;
+	}
+
+	string content;
+	char buffer[65536];
+	size_t length;
+
+	while ((length = fread (buffer, 1, sizeof(buffer), input)) > 0)
+	{
+		content.append (buffer, length);
+	}
+
+	fclose (input);
+
+	Parser parser (content.data(), content.size());
+
+	GeoObject root;
+
+	if (!parser.object (root, 0))
+	{
+		fprintf (stderr, "Invalid GeoJSON in %s at byte %ld\n", filename, (long) (parser.p - content.data()));
+		return false;
+	}
+
+	long geometry = geometries.empty() ? 0 : geometries.back() + 1;
+
+	collect (root, polygons, geometries, geometry);
+
+	return true;
+}
@@ -0,0 +1,32 @@
+/* geojson, Copyright (c) 2013-2020 Yuriy Yakimenko
+ *
+ * Permission to use, copy, modify, distribute, and sell this software and its
+ * documentation for any purpose is hereby granted without fee, provided that
+ * the above copyright notice appear in all copies and that both that
+ * copyright notice and this permission notice appear in supporting
+ * documentation.  No representations are made about the suitability of this
+ * software for any purpose.  It is provided "as is" without express or
+ * implied warranty.
+ */
+
+#pragma once
+
+#include <vector>
+
+//////////////////////////////////////////////////////////////////////////////////////////
+// Reads polygons back from GeoJSON: Polygon and MultiPolygon geometries, alone or in
+// Feature, FeatureCollection and GeometryCollection (at any depth). Other geometries and
+// all properties are skipped, coordinates are kept as they are (rings are not closed or
+// reordered here).
+//////////////////////////////////////////////////////////////////////////////////////////
+
+class GeoJsonReader
+{
+public:
+	// appends each polygon (outer ring and holes, <longitude,latitude>) to POLYGONS and number
+	// of its geometry (from 0, in order of the file) to GEOMETRIES, so polygons of one
+	// MultiPolygon have the same number. False (with message) when file is not valid JSON.
+	static bool readPolygons (const char * filename,
+		std::vector<std::vector<std::vector<std::pair<double,double> > > > & polygons,
+		std::vector<long> & geometries);
+};
@@ -11,8 +11,10 @@
 
 #include "LatLong.h"
 #include "GeoUtils.h"
+#include "Parallel.h"
 
 #include <algorithm>
+#include <random>
 
 using namespace std;
 
@@ -27,8 +29,6 @@ bool GeoUtils::sameHemisphereUsingIndexedPair (const int indexA, const int index
 		return false;
 	}
 
-	MapObject ab  = MapObject::crossProduct (ma, mb);
-
 	int first_sign = 0;
 
 	int index = -1;
@@ -42,22 +42,22 @@ bool GeoUtils::sameHemisphereUsingIndexedPair (const int indexA, const int index
 			continue;
 		}
 
-		double value = pt.X() * ab.X() + pt.Y() * ab.Y() + pt.Z() * ab.Z();
-
-		int sign= 0;
+		int sign = -MapObject::orientation (ma, mb, pt);
 
-		if (fabs(value) == 0)
+		if (sign == 0)
 		{
-			continue;
-		}
+			// exactly on the great circle through a and b. Points between a and b do not
+			// matter, but a point outside of the arc means a or b is not a hull vertex
+			// and accepting this pair would let the march skip or repeat vertices.
 
-		if (value < 0)
-		{
-			sign = 1;
-		}
-		else if (value > 0)
-		{
-			sign = -1;
+			double abCos = ma.GetAngleCos (mb);
+
+			if (pt.GetAngleCos (ma) < abCos || pt.GetAngleCos (mb) < abCos)
+			{
+				return false;
+			}
+
+			continue;
 		}
 
 		if (first_sign==0)
@@ -96,7 +96,8 @@ MapObject GeoUtils::getEquidistantPoint (const MapObject & a, const MapObject &
 // to positive value.
 /////////////////////////////////////////////////////////////////////////////////////////
 
-bool GeoUtils::getConvexHull (vector<TLatLongSP> latlongs, vector<TLatLongSP> & border_latlongs, const int batchCount)
+bool GeoUtils::getConvexHull (vector<TLatLongSP> latlongs, vector<TLatLongSP> & border_latlongs, const int batchCount,
+					const Deadline & deadline)
 {
 	if (latlongs.size() < 2)
 	{
@@ -121,6 +122,12 @@ bool GeoUtils::getConvexHull (vector<TLatLongSP> latlongs, vector<TLatLongSP> &
 
 	for (int i=0; i < cnt && (start_index < 0); i++)
     {
+		if (deadline.expired())
+		{
+			fprintf (stderr, "deadline expired\n");
+			return false;
+		}
+
 		for (int j=i + 1; j < cnt; j++)
 		{
 			if (batchCount > 0)
@@ -157,16 +164,30 @@ bool GeoUtils::getConvexHull (vector<TLatLongSP> latlongs, vector<TLatLongSP> &
 		}
 	}
 
+	if (start_index < 0)
+	{
+		fprintf (stderr, "no hull edge found\n");
+		return false;
+	}
+
 	while (cur_node != start_index)
 	{
 		// why not start with zero? in batch mode our indexes always "grow" so it makes sense to immediately
 		// start looking at indexes larger than current node.
 
-		for (int index = cur_node + 1 ; index != cur_node; index++)
+		bool found = false;
+
+		for (long offset = 1; offset < cnt; offset++)
 		{
-			if (index == cnt) { index = 0; }
+			int index = (cur_node + offset) % cnt;
+
+			if (index == prev_node) continue;
 
-			if (index == cur_node || index == prev_node) continue;
+			if ((offset & 63) == 0 && deadline.expired())
+			{
+				fprintf (stderr, "deadline expired\n");
+				return false;
+			}
 
 			if (batchCount > 0)
 			{
@@ -201,9 +222,39 @@ bool GeoUtils::getConvexHull (vector<TLatLongSP> latlongs, vector<TLatLongSP> &
 				border_points.push_back(index);
 				prev_node = cur_node;
 				cur_node = index;
+				found = true;
 				break;
 			}
 		}
+
+		if (!found && batchCount > 0)
+		{
+			// batch shortcut assumes every center contributes to the outline, which is not
+			// the case for (nearly) collinear centers. Caller repeats without batches.
+			return false;
+		}
+
+		if (!found)
+		{
+			// all points on one great circle: hull degenerates into segment and we walk back.
+			if (sameHemisphereUsingIndexedPair(cur_node, prev_node, objects))
+			{
+				border_points.push_back(prev_node);
+				std::swap (prev_node, cur_node);
+				continue;
+			}
+
+			fprintf (stderr, "not circular\n");
+			return false;
+		}
+
+		if ((long) border_points.size() > cnt + 1)
+		{
+			if (batchCount > 0) return false;
+
+			fprintf (stderr, "not circular\n");
+			return false;
+		}
 	}
 
 	cnt = border_points.size();
@@ -230,230 +281,1195 @@ bool GeoUtils::getConvexHull (vector<TLatLongSP> latlongs, vector<TLatLongSP> &
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////
-// pairs order: <longitude,latitude>
-//
-// Creates convex hill with around input "points", which is at least radiusMiles away from the
-// closest point in the provided list of points.
-//
-// To achieve this, we first create convex hull with provided points. Let's say there is 100
-// input points. Then around each point
-// in the resulting convex hull (let's say there are 30 of them) we create vertCount points
-// at radiusMiles distance from them (actually a bit more, so that
-// connected line is not closer than radiusMiles to each point). For xample if vertCount is 10,
-// in our example we now have 30x10 = 300 points. Then we cann convexHull function
-// again with this new set of 300 points as input, and 10 as "batchCount".
-// We use batch count for optimization, since in the resulting hull only points around adjacent
-// "centers" will form the hull.
+// Divide and conquer hull.
+// Points are projected on the plane touching the sphere at their center (gnomonic
+// projection), where great circles become straight lines, so planar monotone chain
+// algorithm applies. Sign of planar cross product equals MapObject::orientation of
+// original points, and that is what we use to avoid rounding in projected values.
+// Input is split into parts, hull of each part is found on its own thread and
+// then the hull of all part hulls gives the result.
 /////////////////////////////////////////////////////////////////////////////////////////
-bool GeoUtils::getConvexHull (vector<std::pair<double,double> > points,
-                 vector<std::pair<double,double> > & output,
-				 const double radiusMiles, const int vertCount)
+
+struct HullPoint
 {
-	std::vector<TLatLongSP> latlongs;
+	MapObject obj;
+	double x, y; // projected coordinates, used for sorting only.
+	long index;
 
-	for (auto & pt: points)
-	{
-		auto llsp = std::make_shared<TLatLong>(pt.second, pt.first);
+	HullPoint (const MapObject & o, const long i) : obj(o), x(0), y(0), index(i) { }
+};
 
-		latlongs.push_back(llsp);
-	}
+static bool hullPointLess (const HullPoint & a, const HullPoint & b)
+{
+	if (a.x != b.x) return a.x < b.x;
+	if (a.y != b.y) return a.y < b.y;
+	return a.index < b.index;
+}
 
-	std::vector<TLatLongSP> border_latlongs;
-	std::vector<TLatLongSP> temp_output;
+// result is counterclockwise, without duplicates and points in the middle of edges.
 
-	double trueR = MapObject::getTrueRadius(radiusMiles, vertCount);
+static void monotoneChain (vector<HullPoint> & pts, vector<HullPoint> & hull)
+{
+	sort (pts.begin(), pts.end(), hullPointLess);
+
+	// equal points are next to each other now, keep the one with smallest index.
 
-	if (getConvexHull(latlongs, border_latlongs, -1))
+	vector<HullPoint> unique;
+	unique.reserve (pts.size());
+
+	for (auto & pt : pts)
 	{
-		for (auto & llsp : border_latlongs)
+		if (unique.empty() || !(unique.back().obj == pt.obj))
 		{
-			MapObject::getNPointsAround (*llsp.get(), trueR, vertCount, temp_output);
+			unique.push_back (pt);
 		}
+	}
 
-		std::vector<TLatLongSP> outline_latlongs;
+	hull.clear();
 
-		if (getConvexHull (temp_output, outline_latlongs, vertCount))
+	if (unique.size() < 3)
+	{
+		hull = unique;
+		return;
+	}
+
+	for (size_t i=0; i < unique.size(); i++)
+	{
+		while (hull.size() >= 2 &&
+			MapObject::orientation (hull[hull.size() - 2].obj, hull.back().obj, unique[i].obj) <= 0)
 		{
-			long cnt = outline_latlongs.size();
+			hull.pop_back();
+		}
+		hull.push_back (unique[i]);
+	}
 
-			output.reserve(cnt);
+	size_t lower = hull.size() + 1;
 
-			for (auto & llsp : outline_latlongs)
-			{
-				output.push_back(make_pair(llsp->Longitude(), llsp->Latitude()));
-			}
-			return true;
+	for (long i = (long) unique.size() - 2; i >= 0; i--)
+	{
+		while (hull.size() >= lower &&
+			MapObject::orientation (hull[hull.size() - 2].obj, hull.back().obj, unique[i].obj) <= 0)
+		{
+			hull.pop_back();
 		}
+		hull.push_back (unique[i]);
 	}
 
-	return false;
+	hull.pop_back(); // first point is repeated at the end.
 }
 
-/////////////////////////////////////////////////////////////////////////////////////////
-// output pairs have order <longitude,latitude>
-// COUNT is number of vertices in triangle/square/pentagon/hexagon etc.
-/////////////////////////////////////////////////////////////////////////////////////////
-bool GeoUtils::getPointsAroundCoordinate (const TLatLong & coord,
-					const double radiusMiles,
-					const int vertCount, vector <pair<double,double> > & output)
+// When deadline expires before the hull is found, polygon made by supporting lines in
+// COARSE_DIRECTIONS directions (in projection plane) is used instead. It contains all points,
+// and each of its corners is cut off from it by the segment between two support points,
+// which is inside the exact hull, so distance to that segment bounds how far the polygon
+// goes beyond the hull.
+
+static const int COARSE_DIRECTIONS = 32;
+
+struct CoarseHull
 {
-	std::vector<TLatLongSP> temp_output;
+	bool used;
+	vector<MapObject> corners;
+	double errorMiles;
 
-	double trueR = MapObject::getTrueRadius(radiusMiles, vertCount);
+	CoarseHull () : used(false), errorMiles(0) { }
+};
 
-	MapObject::getNPointsAround (coord, trueR, vertCount, temp_output);
+// leaves in PTS only the extreme point for each direction, in direction order.
 
-	for (auto & ll : temp_output)
+static void coarseSupports (vector<HullPoint> & pts)
+{
+	if (pts.empty()) return;
+
+	double dx[COARSE_DIRECTIONS], dy[COARSE_DIRECTIONS], best[COARSE_DIRECTIONS];
+	size_t bestIndex[COARSE_DIRECTIONS];
+
+	for (int k = 0; k < COARSE_DIRECTIONS; k++)
 	{
-		output.push_back (make_pair (ll->Longitude(), ll->Latitude() ));
+		double angle = 2 * M_PI * k / COARSE_DIRECTIONS;
+
+		dx[k] = cos (angle);
+		dy[k] = sin (angle);
+		best[k] = pts[0].x * dx[k] + pts[0].y * dy[k];
+		bestIndex[k] = 0;
 	}
 
-	return true;
-}
+	for (size_t i = 1; i < pts.size(); i++)
+	{
+		for (int k = 0; k < COARSE_DIRECTIONS; k++)
+		{
+			double d = pts[i].x * dx[k] + pts[i].y * dy[k];
 
-struct Circle
-{
-    MapObject center;
-    double radius;
-    Circle (double lat, double lon, const double r) : center(TLatLong(lat,lon))
-    {
-        radius = r;
-    }
-	Circle (MapObject obj, const double r) : center (obj)
+			if (d > best[k])
+			{
+				best[k] = d;
+				bestIndex[k] = i;
+			}
+		}
+	}
+
+	vector<HullPoint> supports;
+
+	for (int k = 0; k < COARSE_DIRECTIONS; k++)
 	{
-		radius = r;
+		supports.push_back (pts[bestIndex[k]]);
 	}
-};
 
-Circle smallestEnclosing (const MapObject &a, const MapObject &b, const MapObject &c)
-{
-	double abCos = a.GetAngleCos (b);
-	double bcCos = b.GetAngleCos (c);
-	double acCos = a.GetAngleCos (c);
+	pts.swap (supports);
+}
 
-	// min value corresponds to maximum distance.
+// SUPPORTS from coarseSupports, projection basis is CENTER, U, V.
 
-	int minIndex = -1; // 0 - a, 1 - b, 2 - c.
+static void coarsePolygon (const vector<HullPoint> & supports, const MapObject & center,
+					const MapObject & u, const MapObject & v, CoarseHull & coarse)
+{
+	double step = 2 * M_PI / COARSE_DIRECTIONS;
 
-	minIndex = (abCos < bcCos) ? 2 : 0;
-	if (acCos < min(abCos, bcCos)) minIndex = 1;
+	coarse.used = true;
+	coarse.corners.clear();
+	coarse.errorMiles = 0;
 
-	if (minIndex == 0)
+	for (int k = 0; k < COARSE_DIRECTIONS; k++)
 	{
-		MapObject m = MapObject::midpoint (b, c);
-		if (m.GetAngleCos(a) > m.GetAngleCos(b)) // distance MA smaller than MB.
+		int next = (k + 1) % COARSE_DIRECTIONS;
+
+		double a = step * k, b = step * (k + 1);
+
+		const HullPoint & sa = supports[k];
+		const HullPoint & sb = supports[next];
+
+		// supporting lines x cos + y sin = h, moved out a little against rounding.
+
+		double ha = sa.x * cos (a) + sa.y * sin (a);
+		double hb = sb.x * cos (b) + sb.y * sin (b);
+
+		ha += 1e-12 * (1 + fabs (ha));
+		hb += 1e-12 * (1 + fabs (hb));
+
+		double x = (ha * sin (b) - hb * sin (a)) / sin (step);
+		double y = (hb * cos (a) - ha * cos (b)) / sin (step);
+
+		double px = center.X() + x * u.X() + y * v.X();
+		double py = center.Y() + x * u.Y() + y * v.Y();
+		double pz = center.Z() + x * u.Z() + y * v.Z();
+		double n = sqrt (px * px + py * py + pz * pz);
+
+		MapObject corner (px / n, py / n, pz / n);
+
+		double error = min (corner.GetAirDistance (sa.obj), corner.GetAirDistance (sb.obj));
+
+		if (!(sa.obj == sb.obj))
 		{
-			double dist = m.GetAirDistance (b);
-			return Circle (m, dist);
+			bool withinSegment;
+			TLatLongSP closest;
+
+			double d = corner.distanceToSegment (sa.obj, sb.obj, withinSegment, closest);
+
+			if (withinSegment) error = min (error, d);
 		}
-	}
-	else if (minIndex == 1)
-	{
-		MapObject m = MapObject::midpoint (a, c);
-		if (m.GetAngleCos(b) > m.GetAngleCos(a)) // distance MB smaller than MA.
+
+		coarse.errorMiles = max (coarse.errorMiles, error);
+
+		if (!coarse.corners.empty() && corner.GetAirDistance (coarse.corners.back()) < 1e-6)
 		{
-			double dist = m.GetAirDistance (a);
-			return Circle (m, dist);
+			continue;
 		}
+
+		coarse.corners.push_back (corner);
 	}
 
-	else if (minIndex == 2)
+	while (coarse.corners.size() > 1 && coarse.corners.back().GetAirDistance (coarse.corners.front()) < 1e-6)
 	{
-		MapObject m = MapObject::midpoint (a, b);
-		if (m.GetAngleCos(c) > m.GetAngleCos(a)) // distance MC smaller than MA.
-		{
-			double dist = m.GetAirDistance (a);
-			return Circle (m, dist);
-		}
+		coarse.corners.pop_back();
 	}
-
-	MapObject m = GeoUtils::getEquidistantPoint (a, b, c);
-	double dist = m.GetAirDistance (a);
-	return Circle (m, dist);
 }
 
-Circle trivial (const vector <MapObjectEx> & input)
+// with DEADLINE, COARSE receives coarse polygon when it expires (and HULL is then empty).
+
+template <typename Source>
+static bool hullIndexes (const Source & source, const long count, vector<long> & hull, const int threads,
+				const Deadline & deadline = Deadline(), CoarseHull * coarse = nullptr)
 {
-	const MapObject &cast = (input[0]);
-	const MapObject &cast2 = (input[1]);
-	const MapObject &cast3 = (input[2]);
+	if (count < 2)
+	{
+		return false;
+	}
 
-    return smallestEnclosing(cast, cast2, cast3);
-}
+	int parts = Parallel::threadCount (threads);
 
-static bool containsPoint (const Circle & c, const MapObject &pt)
-{
-    bool ret = (c.radius > 0 && (pt.GetAirDistance(c.center) <= c.radius + 1e-15)) ;
+	if (parts > count) parts = (int) count;
 
-    return ret;
-}
+	vector<vector<HullPoint> > chunks (parts);
+	vector<double> sums (parts * 3, 0.0);
 
-static int unmarkedIndex (vector <MapObjectEx> & R)
-{
-    for (size_t i=0; i < R.size(); i++)
-    {
-        if (R[i].mark == 0) return i;
-    }
-    return -1;
-}
+	Parallel::forEachPart (count, parts, [&] (int part, long begin, long end)
+	{
+		vector<HullPoint> & chunk = chunks[part];
+		chunk.reserve (end - begin);
 
-//////////////////////////////////////////////////////////////////////////////////////////
-// Weizl agorithm.
-// non recursive version, with MSW fix.
-//////////////////////////////////////////////////////////////////////////////////////////
-MapObject GeoUtils::smallestCircle (vector <MapObjectEx> & inputP, double & outRadius)
-{
-	vector <MapObjectEx> inputR;
+		for (long i = begin; i < end; i++)
+		{
+			chunk.emplace_back (source (i), i);
 
-	if (inputP.size() == 2)
+			sums[part * 3] += chunk.back().obj.X();
+			sums[part * 3 + 1] += chunk.back().obj.Y();
+			sums[part * 3 + 2] += chunk.back().obj.Z();
+		}
+	});
+
+	double cx = 0, cy = 0, cz = 0;
+
+	for (int part = 0; part < parts; part++)
 	{
-		MapObject m = MapObject::midpoint (inputP[0], inputP[1]);
-		outRadius = m.GetAirDistance (inputP[0]);
-		return m;
+		cx += sums[part * 3];
+		cy += sums[part * 3 + 1];
+		cz += sums[part * 3 + 2];
 	}
 
-    // 1. pick first three Points and put into inputR (while removing from P).
+	double n = sqrt (cx * cx + cy * cy + cz * cz);
 
-    for (int i=0; i < 3; i++)
-    {
-        inputR.push_back(inputP[0]);
-        inputP.erase (inputP.begin());
-    }
+	if (n == 0)
+	{
+		return false;
+	}
 
-    size_t index = 0;
-    Circle r = trivial(inputR);
+	MapObject center (cx / n, cy / n, cz / n);
 
-	while (index < inputP.size())
+	// u, v and center make right-handed basis.
+
+	MapObject axis = (fabs (center.Z()) < 0.9) ? MapObject (0, 0, 1) : MapObject (1, 0, 0);
+	MapObject u = MapObject::crossProduct (axis, center);
+	MapObject v = MapObject::crossProduct (center, u);
+
+	vector<vector<HullPoint> > partHulls (parts);
+	vector<char> inHemisphere (parts, 1);
+	vector<char> expired (parts, 0);
+
+	// with deadline parts are chained in blocks, so that they can stop between them.
+
+	const size_t block = 65536;
+
+	Parallel::forEachPart (parts, parts, [&] (int part, long, long)
 	{
-		MapObjectEx pt = inputP[index];
+		for (auto & pt : chunks[part])
+		{
+			double d = pt.obj.GetAngleCos (center);
 
-		if (containsPoint (r, pt)) { index++; continue; }
+			if (d < 1e-6)
+			{
+				inHemisphere[part] = 0;
+				return;
+			}
 
-		// pt is not in r.
+			pt.x = pt.obj.GetAngleCos (u) / d;
+			pt.y = pt.obj.GetAngleCos (v) / d;
+		}
 
-		pt.mark = 1;
+		vector<HullPoint> & chunk = chunks[part];
+		vector<HullPoint> & partHull = partHulls[part];
 
-		int replace = unmarkedIndex (inputR);
-		if (replace >= 0)
+		if (!coarse)
 		{
-			inputP[index] = inputR[replace];
-			inputR[replace] = pt;
-			index = 0;
-			r = trivial(inputR);
+			monotoneChain (chunk, partHull);
 		}
-		else // all indexes required..
+		else
 		{
-			Circle c1 = smallestEnclosing(inputR[0], inputR[1], pt);
-			if (containsPoint (c1, inputR[2]))
+			size_t done = 0;
+
+			while (done < chunk.size())
 			{
-				// remove 2.
-				MapObjectEx pt2 = inputR[2];
-				pt2.mark = 0;
-				inputP[index] = pt2;
-				inputR[2] = pt;
-				index = 0;
-				r = c1;
-				continue;
+				if (deadline.expired())
+				{
+					// rest of the part is represented by its support points.
+
+					expired[part] = 1;
+					partHull.insert (partHull.end(), chunk.begin() + done, chunk.end());
+					coarseSupports (partHull);
+					break;
+				}
+
+				size_t next = min (chunk.size(), done + block);
+
+				vector<HullPoint> pts (partHull);
+				pts.insert (pts.end(), chunk.begin() + done, chunk.begin() + next);
+
+				monotoneChain (pts, partHull);
+
+				done = next;
+			}
+		}
+
+		vector<HullPoint>().swap (chunk);
+	});
+
+	vector<HullPoint> merged;
+
+	for (int part = 0; part < parts; part++)
+	{
+		if (!inHemisphere[part])
+		{
+			return false;
+		}
+
+		merged.insert (merged.end(), partHulls[part].begin(), partHulls[part].end());
+	}
+
+	if (coarse && (std::find (expired.begin(), expired.end(), 1) != expired.end() || deadline.expired()))
+	{
+		coarseSupports (merged);
+		coarsePolygon (merged, center, u, v, *coarse);
+
+		hull.clear();
+		return true;
+	}
+
+	vector<HullPoint> result;
+
+	monotoneChain (merged, result);
+
+	if (result.size() < 2)
+	{
+		return false;
+	}
+
+	// same order as in Jarvis march: smallest index goes last, its neighbor with smaller index first.
+
+	size_t h = result.size();
+	size_t first = 0;
+
+	for (size_t i = 1; i < h; i++)
+	{
+		if (result[i].index < result[first].index) first = i;
+	}
+
+	bool forward = result[(first + 1) % h].index <= result[(first + h - 1) % h].index;
+
+	hull.clear();
+	hull.reserve (h);
+
+	for (size_t i = 0; i < h; i++)
+	{
+		size_t k = forward ? (first + 1 + i) % h : (first + 2 * h - 1 - i) % h;
+		hull.push_back (result[k].index);
+	}
+
+	return true;
+}
+
+bool GeoUtils::getHullIndexes (const vector<pair<double,double> > & points, vector<long> & hull,
+                const int threads)
+{
+	auto source = [&points] (long i)
+	{
+		return MapObject (TLatLong (points[i].second, points[i].first));
+	};
+
+	return hullIndexes (source, (long) points.size(), hull, threads);
+}
+
+bool GeoUtils::getHullIndexes (const vector<MapObject> & points, vector<long> & hull, const int threads)
+{
+	auto source = [&points] (long i) -> const MapObject &
+	{
+		return points[i];
+	};
+
+	return hullIndexes (source, (long) points.size(), hull, threads);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+// pairs order: <longitude,latitude>
+//
+// Creates convex hill with around input "points", which is at least radiusMiles away from the
+// closest point in the provided list of points.
+//
+// To achieve this, we first create convex hull with provided points. Let's say there is 100
+// input points. Then around each point
+// in the resulting convex hull (let's say there are 30 of them) we create vertCount points
+// at radiusMiles distance from them (actually a bit more, so that
+// connected line is not closer than radiusMiles to each point). For xample if vertCount is 10,
+// in our example we now have 30x10 = 300 points. Then we cann convexHull function
+// again with this new set of 300 points as input, and 10 as "batchCount".
+// We use batch count for optimization, since in the resulting hull only points around adjacent
+// "centers" will form the hull.
+//
+// First step is done by getHullVertices, second one by bufferHull.
+/////////////////////////////////////////////////////////////////////////////////////////
+bool GeoUtils::getConvexHull (const vector<std::pair<double,double> > & points,
+                 vector<std::pair<double,double> > & output,
+				 const double radiusMiles, const int vertCount, const int threads)
+{
+	std::vector<std::pair<double,double> > hull;
+
+	if (!getHullVertices (points, hull, threads))
+	{
+		return false;
+	}
+
+	return bufferHull (hull, output, radiusMiles, vertCount);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+// Hull vertices only, in hull order. Divide and conquer method above is used (with
+// THREADS threads), Jarvis march when points are spread too wide for it. With DEADLINE,
+// coarse polygon is returned when it expires during divide and conquer (Jarvis march
+// has no such fallback and fails).
+/////////////////////////////////////////////////////////////////////////////////////////
+bool GeoUtils::getHullVertices (const vector<std::pair<double,double> > & points,
+                 vector<std::pair<double,double> > & hull, const int threads)
+{
+	double errorMiles;
+
+	return getHullVertices (points, hull, Deadline(), errorMiles, threads);
+}
+
+bool GeoUtils::getHullVertices (const vector<std::pair<double,double> > & points,
+                 vector<std::pair<double,double> > & hull, const Deadline & deadline,
+                 double & outErrorMiles, const int threads)
+{
+	std::vector<long> indexes;
+
+	outErrorMiles = 0;
+
+	auto source = [&points] (long i)
+	{
+		return MapObject (TLatLong (points[i].second, points[i].first));
+	};
+
+	CoarseHull coarse;
+
+	if (hullIndexes (source, (long) points.size(), indexes, threads, deadline,
+				deadline.isActive() ? &coarse : nullptr))
+	{
+		if (coarse.used)
+		{
+			for (auto & corner : coarse.corners)
+			{
+				TLatLong ll = corner.GetLatLong();
+
+				hull.push_back (make_pair (ll.Longitude(), ll.Latitude()));
+			}
+
+			outErrorMiles = coarse.errorMiles;
+
+			return true;
+		}
+
+		hull.reserve (indexes.size());
+
+		for (long index : indexes)
+		{
+			hull.push_back (points[index]);
+		}
+
+		return true;
+	}
+
+	std::vector<TLatLongSP> latlongs;
+
+	for (auto & pt: points)
+	{
+		auto llsp = std::make_shared<TLatLong>(pt.second, pt.first);
+
+		latlongs.push_back(llsp);
+	}
+
+	std::vector<TLatLongSP> border_latlongs;
+
+	if (!getConvexHull(latlongs, border_latlongs, -1, deadline))
+	{
+		return false;
+	}
+
+	for (auto & llsp : border_latlongs)
+	{
+		hull.push_back (make_pair (llsp->Longitude(), llsp->Latitude()));
+	}
+
+	return true;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+// HULL becomes hull of HULL and BLOCK together. This way hull of input which does not fit
+// into memory is found: input is read in blocks and only hull is kept between them.
+/////////////////////////////////////////////////////////////////////////////////////////
+bool GeoUtils::addToHull (vector<std::pair<double,double> > & hull,
+                 const vector<std::pair<double,double> > & block, const int threads)
+{
+	std::vector<std::pair<double,double> > candidates (hull);
+
+	candidates.insert (candidates.end(), block.begin(), block.end());
+
+	std::vector<std::pair<double,double> > result;
+
+	if (getHullVertices (candidates, result, threads))
+	{
+		hull.swap (result);
+		return true;
+	}
+
+	// no hull yet when there are fewer than two different points.
+
+	sort (candidates.begin(), candidates.end());
+	candidates.erase (unique (candidates.begin(), candidates.end()), candidates.end());
+
+	if (candidates.size() <= 2)
+	{
+		hull.swap (candidates);
+		return true;
+	}
+
+	return false;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+// Second step of getConvexHull: HULL must be in hull order (as returned by getHullVertices).
+/////////////////////////////////////////////////////////////////////////////////////////
+bool GeoUtils::bufferHull (const vector<std::pair<double,double> > & hull,
+                 vector<std::pair<double,double> > & output,
+				 const double radiusMiles, const int vertCount)
+{
+	std::vector<TLatLongSP> temp_output;
+
+	double trueR = MapObject::getTrueRadius(radiusMiles, vertCount);
+
+	for (auto & pt : hull)
+	{
+		MapObject::getNPointsAround (TLatLong (pt.second, pt.first), trueR, vertCount, temp_output);
+	}
+
+	std::vector<TLatLongSP> outline_latlongs;
+
+	bool ok = getConvexHull (temp_output, outline_latlongs, vertCount);
+
+	if (!ok)
+	{
+		outline_latlongs.clear();
+		ok = getConvexHull (temp_output, outline_latlongs, -1);
+	}
+
+	if (ok)
+	{
+		long cnt = outline_latlongs.size();
+
+		output.reserve(cnt);
+
+		for (auto & llsp : outline_latlongs)
+		{
+			output.push_back(make_pair(llsp->Longitude(), llsp->Latitude()));
+		}
+		return true;
+	}
+
+	return false;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+// Hull of circles of different radius.
+//
+// Center O (direction of sum of circle centers) and tangent directions u, v at it are
+// fixed. For direction d(t) = cos(t) u + sin(t) v, the great circle at angle b from O in that
+// direction has normal n = sin(b) O - cos(b) d(t), and circle i (center c, radius r) is on
+// the side of O when n . c >= sin(r), that is when
+//
+//     b >= f(i,t) = atan2 (d(t) . c, O . c) + asin (sin(r) / |(O . c, d(t) . c)|)
+//
+// So hull boundary in direction t is at max over i of f(i,t): upper envelope of the f
+// functions. Two of them are equal only where a great circle touches both circles from
+// outside, which is at most twice, so the envelope has O(n) pieces and is found by divide
+// and conquer in O(n log n), with crossings in closed form.
+//
+// Output polygon is hull of regular polygons around circles (as in bufferHull): of circles
+// on the envelope, and of those others whose polygon still sticks out of it (see
+// addProtrudingRings).
+/////////////////////////////////////////////////////////////////////////////////////////
+
+static void crossVector (const MapObject & a, const MapObject & b, double out[3])
+{
+	out[0] = a.Y() * b.Z() - a.Z() * b.Y();
+	out[1] = a.Z() * b.X() - a.X() * b.Z();
+	out[2] = a.X() * b.Y() - a.Y() * b.X();
+}
+
+struct HullCircle
+{
+	MapObject center;
+	double radius;   // radians.
+	double o, x, y;  // center in the frame of O, u, v.
+	double s;        // sin of radius.
+
+	HullCircle (const MapObject & c, const double r) : center(c), radius(r), o(0), x(0), y(0), s(sin(r)) { }
+};
+
+struct EnvelopePiece
+{
+	double start;    // direction angle t, in [0, 2 PI).
+	int circle;
+
+	EnvelopePiece (const double t, const int c) : start(t), circle(c) { }
+};
+
+static double envelopeValue (const HullCircle & c, const double t)
+{
+	double d = c.x * cos (t) + c.y * sin (t);
+
+	return atan2 (d, c.o) + asin (c.s / sqrt (c.o * c.o + d * d));
+}
+
+static double normalAngle (double t)
+{
+	t = fmod (t, 2 * M_PI);
+
+	return (t < 0) ? t + 2 * M_PI : t;
+}
+
+// directions where a great circle touches both circles from outside: its normal n
+// has n . c(a) = s(a) and n . c(b) = s(b).
+
+static int envelopeCrossings (const HullCircle & a, const HullCircle & b,
+				const MapObject & u, const MapObject & v, double crossings[2])
+{
+	double w[3];
+
+	crossVector (a.center, b.center, w);
+
+	double ww = w[0] * w[0] + w[1] * w[1] + w[2] * w[2];
+
+	if (ww < 1e-30)
+	{
+		return 0;
+	}
+
+	double m = a.center.GetAngleCos (b.center);
+
+	double ka = (a.s - m * b.s) / ww;
+	double kb = (b.s - m * a.s) / ww;
+
+	double g2 = 1 - (ka * ka + kb * kb + 2 * ka * kb * m);
+
+	if (g2 < 0)
+	{
+		return 0;
+	}
+
+	double g = sqrt (g2 / ww);
+
+	int count = 0;
+
+	for (int sign = -1; sign <= 1; sign += 2)
+	{
+		double n[3] =
+		{
+			ka * a.center.X() + kb * b.center.X() + sign * g * w[0],
+			ka * a.center.Y() + kb * b.center.Y() + sign * g * w[1],
+			ka * a.center.Z() + kb * b.center.Z() + sign * g * w[2]
+		};
+
+		double nu = n[0] * u.X() + n[1] * u.Y() + n[2] * u.Z();
+		double nv = n[0] * v.X() + n[1] * v.Y() + n[2] * v.Z();
+
+		crossings[count++] = normalAngle (atan2 (-nv, -nu));
+	}
+
+	return count;
+}
+
+static void mergeEnvelopes (const vector<HullCircle> & circles, const MapObject & u, const MapObject & v,
+				const vector<EnvelopePiece> & first, const vector<EnvelopePiece> & second,
+				vector<EnvelopePiece> & result)
+{
+	result.clear();
+
+	size_t i = 0, j = 0;
+	double t = 0;
+
+	while (t < 2 * M_PI)
+	{
+		while (i + 1 < first.size() && first[i + 1].start <= t) i++;
+		while (j + 1 < second.size() && second[j + 1].start <= t) j++;
+
+		double next = 2 * M_PI;
+
+		if (i + 1 < first.size()) next = min (next, first[i + 1].start);
+		if (j + 1 < second.size()) next = min (next, second[j + 1].start);
+
+		int a = first[i].circle, b = second[j].circle;
+
+		double cuts[4];
+		int count = 0;
+
+		cuts[count++] = t;
+
+		double crossings[2];
+		int found = envelopeCrossings (circles[a], circles[b], u, v, crossings);
+
+		sort (crossings, crossings + found);
+
+		for (int k = 0; k < found; k++)
+		{
+			if (crossings[k] > t && crossings[k] < next) cuts[count++] = crossings[k];
+		}
+
+		cuts[count] = next;
+
+		for (int k = 0; k < count; k++)
+		{
+			double middle = (cuts[k] + cuts[k + 1]) / 2;
+
+			int top = (envelopeValue (circles[a], middle) >= envelopeValue (circles[b], middle)) ? a : b;
+
+			if (result.empty() || result.back().circle != top)
+			{
+				result.push_back (EnvelopePiece (cuts[k], top));
+			}
+		}
+
+		t = next;
+	}
+}
+
+static void circlesEnvelope (const vector<HullCircle> & circles, const MapObject & u, const MapObject & v,
+				const int begin, const int end, vector<EnvelopePiece> & result)
+{
+	if (end - begin == 1)
+	{
+		result.assign (1, EnvelopePiece (0, begin));
+		return;
+	}
+
+	int middle = (begin + end) / 2;
+
+	vector<EnvelopePiece> first, second;
+
+	circlesEnvelope (circles, u, v, begin, middle, first);
+	circlesEnvelope (circles, u, v, middle, end, second);
+
+	mergeEnvelopes (circles, u, v, first, second, result);
+}
+
+// false when circles do not fit into hemisphere around their center.
+
+static bool getCirclesHull (const vector<pair<double,double> > & points, const vector<double> & radiiMiles,
+				vector<pair<double,double> > & ringPoints, const int vertCount)
+{
+	vector<HullCircle> circles;
+
+	double cx = 0, cy = 0, cz = 0;
+
+	for (size_t i = 0; i < points.size(); i++)
+	{
+		MapObject c (TLatLong (points[i].second, points[i].first));
+
+		circles.push_back (HullCircle (c, radiiMiles[i] / MapObject::EARTH_RADIUS));
+
+		cx += c.X();
+		cy += c.Y();
+		cz += c.Z();
+	}
+
+	double n = sqrt (cx * cx + cy * cy + cz * cz);
+
+	if (n == 0)
+	{
+		return false;
+	}
+
+	MapObject center (cx / n, cy / n, cz / n);
+
+	MapObject axis = (fabs (center.Z()) < 0.9) ? MapObject (0, 0, 1) : MapObject (1, 0, 0);
+	MapObject u = MapObject::crossProduct (axis, center);
+	MapObject v = MapObject::crossProduct (center, u);
+
+	for (auto & c : circles)
+	{
+		c.o = c.center.GetAngleCos (center);
+		c.x = c.center.GetAngleCos (u);
+		c.y = c.center.GetAngleCos (v);
+
+		// whole circle must be in the hemisphere.
+
+		if (c.radius >= M_PI / 2 || c.o <= c.s + 1e-9)
+		{
+			return false;
+		}
+	}
+
+	vector<EnvelopePiece> envelope;
+
+	circlesEnvelope (circles, u, v, 0, (int) circles.size(), envelope);
+
+	// first and last piece can be the same circle (across t = 0).
+
+	if (envelope.size() > 1 && envelope.front().circle == envelope.back().circle)
+	{
+		envelope.front().start = envelope.back().start - 2 * M_PI;
+		envelope.pop_back();
+	}
+
+	vector<char> added (circles.size(), 0);
+
+	for (auto & piece : envelope)
+	{
+		if (added[piece.circle]) continue;
+
+		added[piece.circle] = 1;
+
+		const HullCircle & c = circles[piece.circle];
+
+		TLatLong coord = c.center.GetLatLong();
+
+		if (c.radius == 0)
+		{
+			ringPoints.push_back (make_pair (coord.Longitude(), coord.Latitude()));
+		}
+		else
+		{
+			GeoUtils::getPointsAroundCoordinate (coord, c.radius * MapObject::EARTH_RADIUS, vertCount, ringPoints);
+		}
+	}
+
+	return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+// hull of circles is the hull of those on the envelope, but polygon around a circle just
+// inside of it reaches further than the circle (up to its true radius), and may stick out of
+// HULL of envelope polygons. Rings of such circles are added to RINGPOINTS (true when there
+// are any). Circles which are farther inside than their true radius (most of them) take one
+// dot product, others one per edge of HULL.
+//////////////////////////////////////////////////////////////////////////////////////////
+
+static bool addProtrudingRings (const vector<pair<double,double> > & points, const vector<double> & radiiMiles,
+				const int vertCount, const vector<pair<double,double> > & hull,
+				vector<pair<double,double> > & ringPoints)
+{
+	vector<MapObject> vertices;
+
+	double cx = 0, cy = 0, cz = 0;
+
+	for (auto & pt : hull)
+	{
+		vertices.push_back (MapObject (TLatLong (pt.second, pt.first)));
+
+		cx += vertices.back().X();
+		cy += vertices.back().Y();
+		cz += vertices.back().Z();
+	}
+
+	double n = sqrt (cx * cx + cy * cy + cz * cz);
+
+	if (vertices.size() < 3 || n == 0)
+	{
+		return false;
+	}
+
+	MapObject center (cx / n, cy / n, cz / n);
+
+	// edge normals pointing inside, and angle from center to the nearest edge.
+
+	vector<MapObject> normals;
+	double inner = M_PI;
+
+	for (size_t i = 0; i < vertices.size(); i++)
+	{
+		const MapObject & a = vertices[i];
+		const MapObject & b = vertices[(i + 1) % vertices.size()];
+
+		double w[3];
+
+		crossVector (a, b, w);
+
+		double length = sqrt (w[0] * w[0] + w[1] * w[1] + w[2] * w[2]);
+
+		if (length < 1e-15) continue;
+
+		if (w[0] * center.X() + w[1] * center.Y() + w[2] * center.Z() < 0) length = -length;
+
+		MapObject normal (w[0] / length, w[1] / length, w[2] / length);
+
+		normals.push_back (normal);
+		inner = min (inner, asin (normal.GetAngleCos (center)));
+	}
+
+	bool added = false;
+
+	for (size_t i = 0; i < points.size(); i++)
+	{
+		MapObject c (TLatLong (points[i].second, points[i].first));
+
+		double reach = MapObject::getTrueRadius (radiiMiles[i], vertCount) / MapObject::EARTH_RADIUS;
+
+		if (c.GetAngle (center) + reach < inner)
+		{
+			continue;
+		}
+
+		double sinReach = sin (reach);
+		bool near = false;
+
+		for (auto & normal : normals)
+		{
+			if (normal.GetAngleCos (c) < sinReach)
+			{
+				near = true;
+				break;
+			}
+		}
+
+		if (!near) continue;
+
+		// polygon vertices of circles on the envelope are on HULL, not outside.
+
+		vector<pair<double,double> > ring;
+
+		GeoUtils::getPointsAroundCoordinate (TLatLong (points[i].second, points[i].first),
+			radiiMiles[i], vertCount, ring);
+
+		bool outside = false;
+
+		for (size_t k = 0; k < ring.size() && !outside; k++)
+		{
+			MapObject pt (TLatLong (ring[k].second, ring[k].first));
+
+			for (auto & normal : normals)
+			{
+				if (normal.GetAngleCos (pt) < -1e-12)
+				{
+					outside = true;
+					break;
+				}
+			}
+		}
+
+		if (outside)
+		{
+			ringPoints.insert (ringPoints.end(), ring.begin(), ring.end());
+			added = true;
+		}
+	}
+
+	return added;
+}
+
+bool GeoUtils::getConvexHull (const vector<std::pair<double,double> > & points,
+				const vector<double> & radiiMiles,
+				vector<std::pair<double,double> > & output, const int vertCount)
+{
+	vector<pair<double,double> > ringPoints;
+
+	if (points.empty())
+	{
+		return false;
+	}
+
+	if (!getCirclesHull (points, radiiMiles, ringPoints, vertCount))
+	{
+		// too wide, rings around all points.
+
+		ringPoints.clear();
+
+		for (size_t i = 0; i < points.size(); i++)
+		{
+			TLatLong coord (points[i].second, points[i].first);
+
+			getPointsAroundCoordinate (coord, radiiMiles[i], vertCount, ringPoints);
+		}
+
+		return getHullVertices (ringPoints, output);
+	}
+
+	if (!getHullVertices (ringPoints, output))
+	{
+		return false;
+	}
+
+	if (addProtrudingRings (points, radiiMiles, vertCount, output, ringPoints))
+	{
+		output.clear();
+
+		return getHullVertices (ringPoints, output);
+	}
+
+	return true;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+// output pairs have order <longitude,latitude>
+// COUNT is number of vertices in triangle/square/pentagon/hexagon etc.
+/////////////////////////////////////////////////////////////////////////////////////////
+bool GeoUtils::getPointsAroundCoordinate (const TLatLong & coord,
+					const double radiusMiles,
+					const int vertCount, vector <pair<double,double> > & output)
+{
+	std::vector<TLatLongSP> temp_output;
+
+	double trueR = MapObject::getTrueRadius(radiusMiles, vertCount);
+
+	MapObject::getNPointsAround (coord, trueR, vertCount, temp_output);
+
+	for (auto & ll : temp_output)
+	{
+		output.push_back (make_pair (ll->Longitude(), ll->Latitude() ));
+	}
+
+	return true;
+}
+
+// smallest circle containing all three points.
+
+Circle smallestEnclosing (const MapObject &a, const MapObject &b, const MapObject &c)
+{
+	double abCos = a.GetAngleCos (b);
+	double bcCos = b.GetAngleCos (c);
+	double acCos = a.GetAngleCos (c);
+
+	// min value corresponds to maximum distance.
+
+	int minIndex = -1; // 0 - a, 1 - b, 2 - c.
+
+	minIndex = (abCos < bcCos) ? 2 : 0;
+	if (acCos < min(abCos, bcCos)) minIndex = 1;
+
+	if (minIndex == 0)
+	{
+		MapObject m = MapObject::midpoint (b, c);
+		if (m.GetAngleCos(a) > m.GetAngleCos(b)) // distance MA smaller than MB.
+		{
+			double dist = m.GetAirDistance (b);
+			return Circle (m, dist);
+		}
+	}
+	else if (minIndex == 1)
+	{
+		MapObject m = MapObject::midpoint (a, c);
+		if (m.GetAngleCos(b) > m.GetAngleCos(a)) // distance MB smaller than MA.
+		{
+			double dist = m.GetAirDistance (a);
+			return Circle (m, dist);
+		}
+	}
+
+	else if (minIndex == 2)
+	{
+		MapObject m = MapObject::midpoint (a, b);
+		if (m.GetAngleCos(c) > m.GetAngleCos(a)) // distance MC smaller than MA.
+		{
+			double dist = m.GetAirDistance (a);
+			return Circle (m, dist);
+		}
+	}
+
+	MapObject m = GeoUtils::getEquidistantPoint (a, b, c);
+	double dist = m.GetAirDistance (a);
+	return Circle (m, dist);
+}
+
+Circle trivial (const vector <MapObjectEx> & input)
+{
+	const MapObject &cast = (input[0]);
+	const MapObject &cast2 = (input[1]);
+	const MapObject &cast3 = (input[2]);
+
+    return smallestEnclosing(cast, cast2, cast3);
+}
+
+static bool containsPoint (const Circle & c, const MapObject &pt)
+{
+    bool ret = (c.radius > 0 && (pt.GetAirDistance(c.center) <= c.radius + 1e-15)) ;
+
+    return ret;
+}
+
+static int unmarkedIndex (vector <MapObjectEx> & R)
+{
+    for (size_t i=0; i < R.size(); i++)
+    {
+        if (R[i].mark == 0) return i;
+    }
+    return -1;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+// Weizl agorithm.
+// non recursive version, with MSW fix.
+//////////////////////////////////////////////////////////////////////////////////////////
+MapObject GeoUtils::smallestCircle (vector <MapObjectEx> & inputP, double & outRadius,
+				const Deadline & deadline, double & outErrorMiles)
+{
+	vector <MapObjectEx> inputR;
+
+	if (inputP.size() == 2)
+	{
+		MapObject m = MapObject::midpoint (inputP[0], inputP[1]);
+		outRadius = m.GetAirDistance (inputP[0]);
+		outErrorMiles = 0;
+		return m;
+	}
+
+    // 1. pick first three Points and put into inputR (while removing from P).
+
+    for (int i=0; i < 3; i++)
+    {
+        inputR.push_back(inputP[0]);
+        inputP.erase (inputP.begin());
+    }
+
+    size_t index = 0;
+    Circle r = trivial(inputR);
+
+	outErrorMiles = 0;
+
+	long steps = 0;
+
+	while (index < inputP.size())
+	{
+		if ((++steps & 1023) == 0 && deadline.expired())
+		{
+			// r covers inputR and inputP before index. It is the smallest circle of at most three
+			// points, so minimal circle of all points is not smaller.
+
+			double radius = r.radius;
+
+			for (size_t i = index; i < inputP.size(); i++)
+			{
+				radius = max (radius, r.center.GetAirDistance (inputP[i]));
+			}
+
+			outErrorMiles = radius - r.radius;
+			outRadius = radius;
+
+			return r.center;
+		}
+
+		MapObjectEx pt = inputP[index];
+
+		if (containsPoint (r, pt)) { index++; continue; }
+
+		// pt is not in r.
+
+		pt.mark = 1;
+
+		int replace = unmarkedIndex (inputR);
+		if (replace >= 0)
+		{
+			inputP[index] = inputR[replace];
+			inputR[replace] = pt;
+			index = 0;
+			r = trivial(inputR);
+		}
+		else // all indexes required..
+		{
+			Circle c1 = smallestEnclosing(inputR[0], inputR[1], pt);
+			if (containsPoint (c1, inputR[2]))
+			{
+				// remove 2.
+				MapObjectEx pt2 = inputR[2];
+				pt2.mark = 0;
+				inputP[index] = pt2;
+				inputR[2] = pt;
+				index = 0;
+				r = c1;
+				continue;
 			}
 			c1 = smallestEnclosing(inputR[0], inputR[2], pt);
 			if (containsPoint (c1, inputR[1]))
@@ -488,6 +1504,14 @@ MapObject GeoUtils::smallestCircle (vector <MapObjectEx> & inputP, double & outR
 }
 
 TLatLong GeoUtils::mincircle (std::vector<std::pair<double,double> > points, double & outRadius)
+{
+	double errorMiles;
+
+	return mincircle (std::move (points), outRadius, Deadline(), errorMiles);
+}
+
+TLatLong GeoUtils::mincircle (std::vector<std::pair<double,double> > points, double & outRadius,
+				const Deadline & deadline, double & outErrorMiles)
 {
 	vector <MapObjectEx> inputP;
 	for (auto & pair : points)
@@ -495,7 +1519,474 @@ TLatLong GeoUtils::mincircle (std::vector<std::pair<double,double> > points, dou
 		inputP.push_back (MapObjectEx (pair.second, pair.first));
 	}
 
-	MapObject mo = smallestCircle (inputP, outRadius);
+	MapObject mo = smallestCircle (inputP, outRadius, deadline, outErrorMiles);
+
+	return mo.GetLatLong ();
+}
+
+TLatLong GeoUtils::mincircle (const std::vector<MapObject> & points, double & outRadius)
+{
+	vector <MapObjectEx> inputP (points.begin(), points.end());
+
+	double errorMiles;
+
+	MapObject mo = smallestCircle (inputP, outRadius, Deadline(), errorMiles);
 
 	return mo.GetLatLong ();
 }
+
+//////////////////////////////////////////////////////////////////////////////////////////
+// Min circle of circles. Circle A contains circle B when distance between centers plus
+// radius of B is not greater than radius of A. Same LP-type algorithm as for points, only
+// primitive for 2 and 3 circles is different: smallest circle touching them from outside.
+//////////////////////////////////////////////////////////////////////////////////////////
+
+// angle between unit vectors, accurate also for very close ones (unlike acos).
+
+static double preciseAngle (const MapObject & a, const MapObject & b)
+{
+	double c[3];
+
+	crossVector (a, b, c);
+
+	return atan2 (sqrt (c[0] * c[0] + c[1] * c[1] + c[2] * c[2]),
+		a.X() * b.X() + a.Y() * b.Y() + a.Z() * b.Z());
+}
+
+static bool containsCircle (const Circle & c, const Circle & other)
+{
+	double dist = preciseAngle (c.center, other.center) * MapObject::EARTH_RADIUS;
+
+	return dist + other.radius <= c.radius + 1e-7;
+}
+
+// point at ANGLE (radians) from A towards B.
+
+static MapObject pointTowards (const MapObject & a, const MapObject & b, const double angle)
+{
+	double d = a.X() * b.X() + a.Y() * b.Y() + a.Z() * b.Z();
+
+	double wx = b.X() - d * a.X(), wy = b.Y() - d * a.Y(), wz = b.Z() - d * a.Z();
+	double n = sqrt (wx * wx + wy * wy + wz * wz);
+
+	if (n == 0)
+	{
+		return a;
+	}
+
+	double c = cos (angle), s = sin (angle) / n;
+
+	return MapObject (c * a.X() + s * wx, c * a.Y() + s * wy, c * a.Z() + s * wz);
+}
+
+static Circle enclosingPair (const Circle & a, const Circle & b)
+{
+	double dist = preciseAngle (a.center, b.center) * MapObject::EARTH_RADIUS;
+
+	if (dist + b.radius <= a.radius) return a;
+	if (dist + a.radius <= b.radius) return b;
+
+	double radius = (dist + a.radius + b.radius) / 2;
+
+	return Circle (pointTowards (a.center, b.center, (radius - a.radius) / MapObject::EARTH_RADIUS), radius);
+}
+
+// Circle touching all three from inside, in frame where first center is the pole (e3) and
+// d(i) = c(i) - c(0). Center O = (x, y, z) at angle R - r(i) from c(i) means
+// z = cos(R - r(0)) and d(i) . O = cos(R - r(i)) - cos(R - r(0)), linear in x and y,
+// and the only equation left is x^2 + y^2 = sin(R - r(0))^2. Everything is computed
+// from small differences (no 1 - cos), so it stays accurate for close centers. Roots are
+// looked for between largest radius and UPPER (radius of some circle containing all three).
+
+static bool touchingCircle (const Circle & a, const Circle & b, const Circle & c, const double upper,
+			Circle & result)
+{
+	const Circle * circles[3] = { &a, &b, &c };
+
+	const MapObject & pole = a.center;
+
+	double e1[3], e2[3];
+	MapObject axis = (fabs (pole.Z()) < 0.9) ? MapObject (0, 0, 1) : MapObject (1, 0, 0);
+
+	crossVector (axis, pole, e1);
+	double n = sqrt (e1[0] * e1[0] + e1[1] * e1[1] + e1[2] * e1[2]);
+	for (int k = 0; k < 3; k++) e1[k] /= n;
+
+	crossVector (pole, MapObject (e1[0], e1[1], e1[2]), e2);
+
+	double dx[3], dy[3], dz[3], r[3];
+
+	for (int i = 0; i < 3; i++)
+	{
+		const MapObject & ci = circles[i]->center;
+
+		dx[i] = ci.X() * e1[0] + ci.Y() * e1[1] + ci.Z() * e1[2];
+		dy[i] = ci.X() * e2[0] + ci.Y() * e2[1] + ci.Z() * e2[2];
+
+		double cz = ci.GetAngleCos (pole);
+		dz[i] = -(dx[i] * dx[i] + dy[i] * dy[i]) / (1 + cz);
+
+		r[i] = circles[i]->radius / MapObject::EARTH_RADIUS;
+	}
+
+	double det = dx[1] * dy[2] - dy[1] * dx[2];
+
+	if (fabs (det) < 1e-300)
+	{
+		return false;
+	}
+
+	// x^2 + y^2 - sin(R - r(0))^2 for given R, and center for it.
+
+	auto solve = [&] (const double R, double & x, double & y, double & z)
+	{
+		z = cos (R - r[0]);
+
+		double rhs1 = -2 * sin ((2 * R - r[1] - r[0]) / 2) * sin ((r[0] - r[1]) / 2) - dz[1] * z;
+		double rhs2 = -2 * sin ((2 * R - r[2] - r[0]) / 2) * sin ((r[0] - r[2]) / 2) - dz[2] * z;
+
+		x = (rhs1 * dy[2] - dy[1] * rhs2) / det;
+		y = (dx[1] * rhs2 - rhs1 * dx[2]) / det;
+
+		double s = sin (R - r[0]);
+
+		return x * x + y * y - s * s;
+	};
+
+	double lower = max (r[0], max (r[1], r[2]));
+	double top = min (upper / MapObject::EARTH_RADIUS, M_PI);
+
+	if (top <= lower)
+	{
+		return false;
+	}
+
+	const int steps = 64;
+
+	double x, y, z;
+	double prevR = lower;
+	double prevValue = solve (lower, x, y, z);
+
+	for (int step = 1; step <= steps; step++)
+	{
+		double R = lower + (top - lower) * step / steps;
+		double value = solve (R, x, y, z);
+
+		if ((prevValue <= 0) != (value <= 0))
+		{
+			double lo = prevR, hi = R, loValue = prevValue;
+
+			for (int iteration = 0; iteration < 100 && hi - lo > 1e-16; iteration++)
+			{
+				double mid = (lo + hi) / 2;
+				double midValue = solve (mid, x, y, z);
+
+				if ((midValue <= 0) == (loValue <= 0))
+				{
+					lo = mid;
+					loValue = midValue;
+				}
+				else
+				{
+					hi = mid;
+				}
+			}
+
+			solve ((lo + hi) / 2, x, y, z);
+
+			double ox = x * e1[0] + y * e2[0] + z * pole.X();
+			double oy = x * e1[1] + y * e2[1] + z * pole.Y();
+			double oz = x * e1[2] + y * e2[2] + z * pole.Z();
+			double on = sqrt (ox * ox + oy * oy + oz * oz);
+
+			MapObject center (ox / on, oy / on, oz / on);
+
+			double lowest = M_PI, highest = 0;
+
+			for (int i = 0; i < 3; i++)
+			{
+				double reach = preciseAngle (center, circles[i]->center) + r[i];
+
+				lowest = min (lowest, reach);
+				highest = max (highest, reach);
+			}
+
+			// also false roots, where some circle touches from outside.
+
+			if (highest - lowest < 1e-9)
+			{
+				result = Circle (center, highest * MapObject::EARTH_RADIUS);
+				return true;
+			}
+		}
+
+		prevR = R;
+		prevValue = value;
+	}
+
+	return false;
+}
+
+// smallest circle containing all three circles (each of them whole).
+
+Circle smallestEnclosing (const Circle &a, const Circle &b, const Circle &c)
+{
+	const Circle * circles[3] = { &a, &b, &c };
+
+	bool found = false;
+	Circle best (a.center, 0);
+
+	// smallest circle around two of them, enlarged to cover the third one, is upper bound.
+
+	Circle upper (a.center, 0);
+
+	for (int i = 0; i < 3; i++)
+	{
+		Circle pair = enclosingPair (*circles[(i + 1) % 3], *circles[(i + 2) % 3]);
+
+		if (containsCircle (pair, *circles[i]) && (!found || pair.radius < best.radius))
+		{
+			found = true;
+			best = pair;
+		}
+
+		pair.radius = max (pair.radius, preciseAngle (pair.center, circles[i]->center) * MapObject::EARTH_RADIUS +
+			circles[i]->radius);
+
+		if (i == 0 || pair.radius < upper.radius) upper = pair;
+	}
+
+	if (found || touchingCircle (a, b, c, upper.radius, best))
+	{
+		return best;
+	}
+
+	return upper;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+// Basis of up to three circles. Circle outside of current one replaces a basis circle
+// when the rest still fits into the new circle, and the scan starts over (as in
+// smallestCircle for points). Input is shuffled first, for expected linear time.
+//////////////////////////////////////////////////////////////////////////////////////////
+
+Circle GeoUtils::smallestCircle (vector <Circle> & circles)
+{
+	std::mt19937 random (1);
+
+	shuffle (circles.begin(), circles.end(), random);
+
+	vector <Circle> basis;
+	basis.push_back (circles[0]);
+
+	Circle r = circles[0];
+
+	size_t index = 1;
+
+	while (index < circles.size())
+	{
+		const Circle & circle = circles[index];
+
+		if (containsCircle (r, circle)) { index++; continue; }
+
+		Circle next = r;
+		bool replaced = false;
+
+		if (basis.size() == 1)
+		{
+			next = enclosingPair (basis[0], circle);
+			basis.push_back (circle);
+			replaced = true;
+		}
+		else if (basis.size() == 2)
+		{
+			next = smallestEnclosing (basis[0], basis[1], circle);
+			basis.push_back (circle);
+			replaced = true;
+		}
+		else
+		{
+			for (int drop = 2; drop >= 0 && !replaced; drop--)
+			{
+				Circle c1 = smallestEnclosing (basis[(drop + 1) % 3], basis[(drop + 2) % 3], circle);
+
+				if (containsCircle (c1, basis[drop]))
+				{
+					basis[drop] = circle;
+					next = c1;
+					replaced = true;
+				}
+			}
+		}
+
+		if (!replaced || next.radius <= r.radius)
+		{
+			// rounding, circle is only slightly outside: enlarge current one to cover it.
+
+			r.radius = max (r.radius, preciseAngle (r.center, circle.center) * MapObject::EARTH_RADIUS + circle.radius);
+			index++;
+			continue;
+		}
+
+		r = next;
+		index = 0;
+	}
+
+	return r;
+}
+
+Circle GeoUtils::mincircle (std::vector<Circle> circles)
+{
+	if (circles.empty())
+	{
+		return Circle (MapObject (0, 0, 1), -1);
+	}
+
+	return smallestCircle (circles);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+// twice the area of RING (in the plane touching the sphere at its center), positive when
+// counterclockwise.
+//////////////////////////////////////////////////////////////////////////////////////////
+
+double GeoUtils::ringArea (const vector<MapObject> & ring)
+{
+	double x = 0, y = 0, z = 0;
+
+	for (auto & pt : ring)
+	{
+		x += pt.X(); y += pt.Y(); z += pt.Z();
+	}
+
+	double area = 0;
+
+	for (size_t i = 0; i < ring.size(); i++)
+	{
+		const MapObject & a = ring[i];
+		const MapObject & b = ring[(i + 1) % ring.size()];
+
+		area += x * (a.Y() * b.Z() - a.Z() * b.Y()) +
+			y * (a.Z() * b.X() - a.X() * b.Z()) +
+			z * (a.X() * b.Y() - a.Y() * b.X());
+	}
+
+	return area / sqrt (x * x + y * y + z * z);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+// point in polygon (not convex), on the plane touching the sphere at center of RING: edges
+// crossed by the ray from PT.
+//////////////////////////////////////////////////////////////////////////////////////////
+
+bool GeoUtils::ringContains (const vector<MapObject> & ring, const MapObject & pt)
+{
+	double x = 0, y = 0, z = 0;
+
+	for (auto & p : ring)
+	{
+		x += p.X(); y += p.Y(); z += p.Z();
+	}
+
+	double n = sqrt (x * x + y * y + z * z);
+
+	MapObject center (x / n, y / n, z / n);
+
+	if (pt.GetAngleCos (center) <= 0)
+	{
+		return false;
+	}
+
+	MapObject axis = (fabs (center.Z()) < 0.9) ? MapObject (0, 0, 1) : MapObject (1, 0, 0);
+	MapObject u = MapObject::crossProduct (axis, center);
+	MapObject v = MapObject::crossProduct (center, u);
+
+	double d = pt.GetAngleCos (center);
+	double px = pt.GetAngleCos (u) / d, py = pt.GetAngleCos (v) / d;
+
+	bool inside = false;
+
+	for (size_t i = 0, j = ring.size() - 1; i < ring.size(); j = i++)
+	{
+		double di = ring[i].GetAngleCos (center), dj = ring[j].GetAngleCos (center);
+
+		double xi = ring[i].GetAngleCos (u) / di, yi = ring[i].GetAngleCos (v) / di;
+		double xj = ring[j].GetAngleCos (u) / dj, yj = ring[j].GetAngleCos (v) / dj;
+
+		if ((yi > py) != (yj > py) && px < (xj - xi) * (py - yi) / (yj - yi) + xi)
+		{
+			inside = !inside;
+		}
+	}
+
+	return inside;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+// sum of many small terms of both signs (Kahan-Babuska): error of the sum does not grow
+// with their count.
+//////////////////////////////////////////////////////////////////////////////////////////
+
+struct CompensatedSum
+{
+	double sum, compensation;
+
+	CompensatedSum () : sum(0), compensation(0) { }
+
+	void add (const double value)
+	{
+		double t = sum + value;
+
+		if (fabs (sum) >= fabs (value))
+		{
+			compensation += (sum - t) + value;
+		}
+		else
+		{
+			compensation += (value - t) + sum;
+		}
+
+		sum = t;
+	}
+
+	double value () const { return sum + compensation; }
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////
+// excess of triangle A, B, C is 2 * atan2 (A . (B x C), 1 + A . B + B . C + C . A), with
+// sign of its orientation (Van Oosterom and Strackee). Triangles of the fan from the first
+// vertex add up to the area of any simple ring, convex or not.
+//////////////////////////////////////////////////////////////////////////////////////////
+
+double GeoUtils::sphericalArea (const vector<MapObject> & ring)
+{
+	CompensatedSum excess;
+
+	for (size_t i = 1; i + 1 < ring.size(); i++)
+	{
+		const MapObject & a = ring[0];
+		const MapObject & b = ring[i];
+		const MapObject & c = ring[i + 1];
+
+		double triple = a.X() * (b.Y() * c.Z() - b.Z() * c.Y()) +
+			a.Y() * (b.Z() * c.X() - b.X() * c.Z()) +
+			a.Z() * (b.X() * c.Y() - b.Y() * c.X());
+		double denominator = 1 + a.GetAngleCos (b) + b.GetAngleCos (c) + c.GetAngleCos (a);
+
+		excess.add (2 * atan2 (triple, denominator));
+	}
+
+	return excess.value() * MapObject::EARTH_RADIUS * MapObject::EARTH_RADIUS;
+}
+
+double GeoUtils::ringLength (const vector<MapObject> & ring)
+{
+	CompensatedSum length;
+
+	for (size_t i = 0; i < ring.size(); i++)
+	{
+		length.add (ring[i].GetAirDistance (ring[(i + 1) % ring.size()]));
+	}
+
+	return length.value();
+}
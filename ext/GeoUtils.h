@@ -14,37 +14,115 @@
 #include <vector>
 #include "LatLong.h"
 #include "MapObject.h"
+#include "Deadline.h"
 
 class MapObjectEx : public MapObject
 {
 public:
     int mark;
 	MapObjectEx (double lat, double lon) : MapObject (TLatLong (lat,lon)), mark(0) { }
+	MapObjectEx (const MapObject & obj) : MapObject (obj), mark(0) { }
+};
+
+// circle on the sphere (spherical cap), radius in miles.
+struct Circle
+{
+    MapObject center;
+    double radius;
+    Circle (double lat, double lon, const double r) : center(TLatLong(lat,lon))
+    {
+        radius = r;
+    }
+	Circle (MapObject obj, const double r) : center (obj)
+	{
+		radius = r;
+	}
 };
 
 class GeoUtils
 {
 private:
     static bool getConvexHull (std::vector<TLatLongSP> latlongs, std::vector<TLatLongSP> & border_latlongs,
-        const int batchCount);
+        const int batchCount, const Deadline & deadline = Deadline());
 
     static bool sameHemisphereUsingIndexedPair (const int indexA, const int indexB,
         const std::vector <MapObject> & points);
 
-    static MapObject smallestCircle (std::vector <MapObjectEx> & inputP, double & outradius);
+    static MapObject smallestCircle (std::vector <MapObjectEx> & inputP, double & outradius,
+        const Deadline & deadline, double & outErrorMiles);
+
+    static Circle smallestCircle (std::vector <Circle> & circles);
 
 
 public:
     static MapObject getEquidistantPoint (const MapObject & a, const MapObject & b, const MapObject & c);
 
-    static bool getConvexHull (std::vector<std::pair<double,double> > points,
+    // indexes of convex hull vertices (without buffering), in hull order. Input is split
+    // between THREADS threads (0 - all cores), result does not depend on their number.
+    // Returns false when points do not fit into a hemisphere.
+    static bool getHullIndexes (const std::vector<std::pair<double,double> > & points,
+                 std::vector<long> & hull, const int threads = 1);
+
+    static bool getHullIndexes (const std::vector<MapObject> & points,
+                 std::vector<long> & hull, const int threads = 1);
+
+    static bool getConvexHull (const std::vector<std::pair<double,double> > & points,
+                 std::vector<std::pair<double,double> > & output,
+                 const double radiusMiles, const int vertCount, const int threads = 1);
+
+    // two steps of getConvexHull: hull of points itself, and its buffering by radiusMiles.
+    static bool getHullVertices (const std::vector<std::pair<double,double> > & points,
+                 std::vector<std::pair<double,double> > & hull, const int threads = 1);
+
+    // same, but stops at DEADLINE. HULL is then a coarse polygon around all points (its vertices
+    // are not input points), outErrorMiles is how far it may be from the exact hull (0 if exact).
+    static bool getHullVertices (const std::vector<std::pair<double,double> > & points,
+                 std::vector<std::pair<double,double> > & hull, const Deadline & deadline,
+                 double & outErrorMiles, const int threads = 1);
+
+    // HULL becomes hull of HULL and BLOCK, for input read block by block.
+    static bool addToHull (std::vector<std::pair<double,double> > & hull,
+                 const std::vector<std::pair<double,double> > & block, const int threads = 1);
+
+    static bool bufferHull (const std::vector<std::pair<double,double> > & hull,
                  std::vector<std::pair<double,double> > & output,
                  const double radiusMiles, const int vertCount);
 
+    // getConvexHull with radius for each point (RADIIMILES, same size as POINTS): hull of
+    // circles of different size, found directly from circles (see getCirclesHull in .cpp).
+    static bool getConvexHull (const std::vector<std::pair<double,double> > & points,
+                 const std::vector<double> & radiiMiles,
+                 std::vector<std::pair<double,double> > & output, const int vertCount);
+
     // creates regular polygon centered at coordinate with COUNT vertices.
     static bool getPointsAroundCoordinate (const TLatLong & coord,
                     const double radiusMiles, const int vertCount,
                     std::vector <std::pair<double,double> > & output);
 
     static TLatLong mincircle (std::vector<std::pair<double,double> > points, double & outRadius);
+
+    // stops at DEADLINE with the circle found so far, enlarged to cover points not yet checked.
+    // outErrorMiles is how much larger than minimal outRadius may be (0 if exact).
+    static TLatLong mincircle (std::vector<std::pair<double,double> > points, double & outRadius,
+                    const Deadline & deadline, double & outErrorMiles);
+
+    // smallest circle containing all CIRCLES (radius in miles, may be 0), each of them whole.
+    static Circle mincircle (std::vector<Circle> circles);
+
+    // same for points already converted to unit vectors.
+    static TLatLong mincircle (const std::vector<MapObject> & points, double & outRadius);
+
+    // twice the area of RING (not convex) in the plane touching the sphere at its center:
+    // positive when counterclockwise. For orientation of rings, not for real area.
+    static double ringArea (const std::vector<MapObject> & ring);
+
+    // PT is inside of RING (not convex, smaller than hemisphere).
+    static bool ringContains (const std::vector<MapObject> & ring, const MapObject & pt);
+
+    // real area of RING in square miles: spherical excess of triangles from its first vertex,
+    // summed with compensation. Positive when counterclockwise.
+    static double sphericalArea (const std::vector<MapObject> & ring);
+
+    // length of RING (last vertex joined to the first) in miles.
+    static double ringLength (const std::vector<MapObject> & ring);
 };
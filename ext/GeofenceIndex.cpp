@@ -0,0 +1,186 @@
+/* geojson, Copyright (c) 2013-2020 Yuriy Yakimenko
+ *
+ * Permission to use, copy, modify, distribute, and sell this software and its
+ * documentation for any purpose is hereby granted without fee, provided that
+ * the above copyright notice appear in all copies and that both that
+ * copyright notice and this permission notice appear in supporting
+ * documentation.  No representations are made about the suitability of this
+ * software for any purpose.  It is provided "as is" without express or
+ * implied warranty.
+ */
+
+#include "GeofenceIndex.h"
+
+#include <algorithm>
+
+using namespace std;
+
+static inline double dot (const MapObject & a, const MapObject & b)
+{
+	return a.X() * b.X() + a.Y() * b.Y() + a.Z() * b.Z();
+}
+
+static long cellRow (const double latitude, const int level)
+{
+	long count = 1L << level;
+	long row = (long) floor ((latitude + 90) * count / 180);
+
+	return max (0L, min (count - 1, row));
+}
+
+static long cellColumn (const double longitude, const int level)
+{
+	long count = 1L << level;
+	long column = (long) floor ((longitude + 180) * count / 360);
+
+	return ((column % count) + count) % count;
+}
+
+GeofenceIndex::GeofenceIndex () : cells(MAX_LEVEL + 1)
+{
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+// RADIUS is angle (radians). Cap which reaches a pole, or is too wide for its latitude,
+// spans all longitudes and goes to level 0 (one cell for whole earth).
+//////////////////////////////////////////////////////////////////////////////////////////
+
+void GeofenceIndex::addCap (const int fence, const double latitude, const double longitude, const double radius)
+{
+	double latitudeHalf = radius * 180 / M_PI;
+	double longitudeHalf = 180;
+
+	if (latitude + latitudeHalf < 90 && latitude - latitudeHalf > -90)
+	{
+		double s = sin (radius) / cos (latitude * M_PI / 180);
+
+		if (s < 1) longitudeHalf = asin (s) * 180 / M_PI;
+	}
+
+	int level = 0;
+
+	if (longitudeHalf < 180)
+	{
+		while (level < MAX_LEVEL && 180.0 / (1L << (level + 1)) >= 2 * latitudeHalf &&
+			360.0 / (1L << (level + 1)) >= 2 * longitudeHalf)
+		{
+			level++;
+		}
+	}
+
+	long count = 1L << level;
+
+	long rowLow = cellRow (latitude - latitudeHalf, level);
+	long rowHigh = cellRow (latitude + latitudeHalf, level);
+
+	long columnLow = cellColumn (longitude - longitudeHalf, level);
+	long columnHigh = cellColumn (longitude + longitudeHalf, level);
+
+	if (level == 0)
+	{
+		rowLow = rowHigh = columnLow = columnHigh = 0;
+	}
+
+	for (long row = rowLow; row <= rowHigh; row++)
+	{
+		// columns may wrap around 180th meridian.
+
+		for (long column = columnLow; ; column = (column + 1) % count)
+		{
+			cells[level][row * count + column].push_back (fence);
+
+			if (column == columnHigh) break;
+		}
+	}
+
+	if (std::find (usedLevels.begin(), usedLevels.end(), level) == usedLevels.end())
+	{
+		usedLevels.push_back (level);
+		sort (usedLevels.begin(), usedLevels.end());
+	}
+}
+
+int GeofenceIndex::addCircle (const string & name, const TLatLong & center, const double radiusMiles)
+{
+	double radius = min (M_PI, max (0.0, radiusMiles / MapObject::EARTH_RADIUS));
+
+	int fence = (int) fences.size();
+
+	fences.push_back (Fence (name, MapObject (center), cos (radius), -1));
+
+	addCap (fence, center.Latitude(), center.Longitude(), radius);
+
+	return fence;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+// cap of polygon is around average of its vertices, through the farthest one.
+//////////////////////////////////////////////////////////////////////////////////////////
+
+int GeofenceIndex::addPolygon (const string & name, const vector<MapObject> & polygon)
+{
+	ConvexPolygon convex;
+
+	if (!convex.build (polygon))
+	{
+		return -1;
+	}
+
+	double x = 0, y = 0, z = 0;
+
+	for (auto & v : polygon)
+	{
+		x += v.X(); y += v.Y(); z += v.Z();
+	}
+
+	double length = sqrt (x * x + y * y + z * z);
+
+	MapObject center (x / length, y / length, z / length);
+
+	double cosRadius = 1;
+
+	for (auto & v : polygon)
+	{
+		cosRadius = min (cosRadius, dot (center, v));
+	}
+
+	int fence = (int) fences.size();
+
+	fences.push_back (Fence (name, center, cosRadius - 1e-12, (int) polygons.size()));
+	polygons.push_back (convex);
+
+	TLatLong ll = center.GetLatLong();
+
+	addCap (fence, ll.Latitude(), ll.Longitude(), acos (max (-1.0, cosRadius)));
+
+	return fence;
+}
+
+void GeofenceIndex::find (const double longitude, const double latitude, vector<int> & output) const
+{
+	output.clear();
+
+	MapObject pt (TLatLong (latitude, longitude));
+
+	for (int level : usedLevels)
+	{
+		long count = 1L << level;
+
+		auto it = cells[level].find (cellRow (latitude, level) * count + cellColumn (longitude, level));
+
+		if (it == cells[level].end()) continue;
+
+		for (int fence : it->second)
+		{
+			const Fence & f = fences[fence];
+
+			if (dot (pt, f.center) < f.cosRadius) continue;
+
+			if (f.polygon >= 0 && !polygons[f.polygon].contains (pt)) continue;
+
+			output.push_back (fence);
+		}
+	}
+
+	sort (output.begin(), output.end());
+}
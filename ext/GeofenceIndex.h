@@ -0,0 +1,72 @@
+/* geojson, Copyright (c) 2013-2020 Yuriy Yakimenko
+ *
+ * Permission to use, copy, modify, distribute, and sell this software and its
+ * documentation for any purpose is hereby granted without fee, provided that
+ * the above copyright notice appear in all copies and that both that
+ * copyright notice and this permission notice appear in supporting
+ * documentation.  No representations are made about the suitability of this
+ * software for any purpose.  It is provided "as is" without express or
+ * implied warranty.
+ */
+
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "MapObject.h"
+#include "ConvexPolygon.h"
+
+//////////////////////////////////////////////////////////////////////////////////////////
+// Many geofences (circles, like from mincircle or eqdist, and convex polygons, like from
+// area) and which of them contain a point.
+//
+// Every fence has bounding cap: center and cosine of its radius, so point is in the cap
+// when its dot product with the center is not smaller (circle fence is its cap). Caps are
+// kept in grid of latitude/longitude cells, halved at every level: each cap is in the
+// level where it spans at most 2 x 2 cells, in all of them. Point is then looked up in its
+// cell of every level used, and only caps found there are tested.
+//////////////////////////////////////////////////////////////////////////////////////////
+
+class GeofenceIndex
+{
+public:
+	static const int MAX_LEVEL = 20;
+
+private:
+	struct Fence
+	{
+		std::string name;
+		MapObject center;
+		double cosRadius;
+		int polygon;      // index in polygons, -1 for circle.
+
+		Fence (const std::string & n, const MapObject & c, const double cr, const int p) :
+			name(n), center(c), cosRadius(cr), polygon(p) { }
+	};
+
+	std::vector<Fence> fences;
+	std::vector<ConvexPolygon> polygons;
+
+	// cells of each level: key is row * 2^level + column.
+	std::vector<std::unordered_map<long, std::vector<int> > > cells;
+	std::vector<int> usedLevels;
+
+	void addCap (const int fence, const double latitude, const double longitude, const double radius);
+
+public:
+	GeofenceIndex ();
+
+	// circle of RADIUSMILES around CENTER.
+	int addCircle (const std::string & name, const TLatLong & center, const double radiusMiles);
+
+	// convex POLYGON, -1 when it is not convex (or larger than hemisphere).
+	int addPolygon (const std::string & name, const std::vector<MapObject> & polygon);
+
+	size_t size () const { return fences.size(); }
+
+	const std::string & name (const int fence) const { return fences[fence].name; }
+
+	// fences containing point, ascending.
+	void find (const double longitude, const double latitude, std::vector<int> & output) const;
+};
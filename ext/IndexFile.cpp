@@ -0,0 +1,214 @@
+/* geojson, Copyright (c) 2013-2020 Yuriy Yakimenko
+ *
+ * Permission to use, copy, modify, distribute, and sell this software and its
+ * documentation for any purpose is hereby granted without fee, provided that
+ * the above copyright notice appear in all copies and that both that
+ * copyright notice and this permission notice appear in supporting
+ * documentation.  No representations are made about the suitability of this
+ * software for any purpose.  It is provided "as is" without express or
+ * implied warranty.
+ */
+
+#include "IndexFile.h"
+
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+static const char MAGIC[8] = { 'G', 'E', 'O', 'J', 'S', 'I', 'D', 'X' };
+static const uint32_t VERSION = 1;
+static const uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+struct IndexHeader
+{
+	char magic[8];
+	uint32_t version;
+	uint32_t byteOrder;
+	uint32_t pointSize;         // sizeof (MapObject)
+	uint32_t coordinateSize;    // sizeof (pair<double,double>)
+	int64_t count;
+	int64_t axisCount;
+	int64_t pointsOffset;
+	int64_t indexesOffset;
+	int64_t axesOffset;
+	int64_t coordinatesOffset;
+	int64_t fileSize;
+};
+
+// arrays start at multiples of 64 (cache line).
+static int64_t aligned (const int64_t offset)
+{
+	return (offset + 63) / 64 * 64;
+}
+
+// COUNT items of ITEMSIZE bytes at OFFSET are within the file, where write puts arrays
+// (multiplying first could overflow for damaged header).
+static bool validArray (const IndexHeader & header, const int64_t offset, const int64_t count,
+                        const int64_t itemSize)
+{
+	return offset >= (int64_t) sizeof (IndexHeader) && offset % 64 == 0 && offset <= header.fileSize &&
+		count <= (header.fileSize - offset) / itemSize;
+}
+
+static bool writeAt (FILE * file, const int64_t offset, const void * data, const size_t size)
+{
+	if (fseek (file, (long) offset, SEEK_SET) != 0)
+	{
+		return false;
+	}
+
+	return size == 0 || fwrite (data, 1, size, file) == size;
+}
+
+IndexFile::IndexFile () : mapped(nullptr), mappedSize(0), coordinates(nullptr)
+{
+}
+
+IndexFile::~IndexFile ()
+{
+	close();
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+bool IndexFile::write (const char * filename, const vector<pair<double,double> > & input)
+{
+	KdTree tree;
+
+	tree.build (input);
+
+	IndexHeader header;
+
+	memset (&header, 0, sizeof (header));
+	memcpy (header.magic, MAGIC, sizeof (MAGIC));
+
+	header.version = VERSION;
+	header.byteOrder = BYTE_ORDER_MARK;
+	header.pointSize = sizeof (MapObject);
+	header.coordinateSize = sizeof (pair<double,double>);
+	header.count = tree.size();
+	header.axisCount = KdTree::axisCount (tree.size());
+
+	header.pointsOffset = aligned (sizeof (header));
+	header.indexesOffset = aligned (header.pointsOffset + header.count * header.pointSize);
+	header.axesOffset = aligned (header.indexesOffset + header.count * (int64_t) sizeof (int));
+	header.coordinatesOffset = aligned (header.axesOffset + header.axisCount);
+	header.fileSize = header.coordinatesOffset + header.count * header.coordinateSize;
+
+	FILE * file = fopen (filename, "wb");
+
+	if (!file)
+	{
+		return false;
+	}
+
+	bool ok = writeAt (file, 0, &header, sizeof (header)) &&
+		writeAt (file, header.pointsOffset, tree.pointArray(), header.count * header.pointSize) &&
+		writeAt (file, header.indexesOffset, tree.indexArray(), header.count * sizeof (int)) &&
+		writeAt (file, header.axesOffset, tree.axisArray(), header.axisCount) &&
+		writeAt (file, header.coordinatesOffset, input.data(), header.count * header.coordinateSize);
+
+	if (fclose (file) != 0)
+	{
+		ok = false;
+	}
+
+	return ok;
+}
+
+bool IndexFile::isIndexFile (const char * filename)
+{
+	FILE * file = fopen (filename, "rb");
+
+	if (!file)
+	{
+		return false;
+	}
+
+	char magic[sizeof (MAGIC)];
+
+	bool result = fread (magic, 1, sizeof (magic), file) == sizeof (magic) &&
+		memcmp (magic, MAGIC, sizeof (MAGIC)) == 0;
+
+	fclose (file);
+
+	return result;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+// file is mapped shared and read only, tree uses its arrays in place.
+//////////////////////////////////////////////////////////////////////////////////////////
+
+bool IndexFile::open (const char * filename)
+{
+	close();
+
+	int fd = ::open (filename, O_RDONLY);
+
+	if (fd < 0)
+	{
+		return false;
+	}
+
+	struct stat st;
+
+	if (fstat (fd, &st) != 0 || !S_ISREG (st.st_mode) || st.st_size < (off_t) sizeof (IndexHeader))
+	{
+		::close (fd);
+		return false;
+	}
+
+	void * ptr = mmap (nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+
+	::close (fd);
+
+	if (ptr == MAP_FAILED)
+	{
+		return false;
+	}
+
+	mapped = (const char *) ptr;
+	mappedSize = st.st_size;
+
+	const IndexHeader * header = (const IndexHeader *) mapped;
+
+	if (memcmp (header->magic, MAGIC, sizeof (MAGIC)) != 0 || header->version != VERSION ||
+		header->byteOrder != BYTE_ORDER_MARK || header->pointSize != sizeof (MapObject) ||
+		header->coordinateSize != sizeof (pair<double,double>) || header->count < 0 ||
+		header->axisCount != KdTree::axisCount (header->count) || header->fileSize != (int64_t) mappedSize ||
+		!validArray (*header, header->pointsOffset, header->count, header->pointSize) ||
+		!validArray (*header, header->indexesOffset, header->count, sizeof (int)) ||
+		!validArray (*header, header->axesOffset, header->axisCount, 1) ||
+		!validArray (*header, header->coordinatesOffset, header->count, header->coordinateSize))
+	{
+		close();
+		return false;
+	}
+
+	tree.attach ((const MapObject *) (mapped + header->pointsOffset), (const int *) (mapped + header->indexesOffset),
+		(const unsigned char *) (mapped + header->axesOffset), header->count);
+
+	coordinates = (const pair<double,double> *) (mapped + header->coordinatesOffset);
+
+	return true;
+}
+
+void IndexFile::close ()
+{
+	if (mapped)
+	{
+		munmap ((void *) mapped, mappedSize);
+	}
+
+	mapped = nullptr;
+	mappedSize = 0;
+	coordinates = nullptr;
+
+	tree.attach (nullptr, nullptr, nullptr, 0);
+}
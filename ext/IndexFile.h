@@ -0,0 +1,56 @@
+/* geojson, Copyright (c) 2013-2020 Yuriy Yakimenko
+ *
+ * Permission to use, copy, modify, distribute, and sell this software and its
+ * documentation for any purpose is hereby granted without fee, provided that
+ * the above copyright notice appear in all copies and that both that
+ * copyright notice and this permission notice appear in supporting
+ * documentation.  No representations are made about the suitability of this
+ * software for any purpose.  It is provided "as is" without express or
+ * implied warranty.
+ */
+
+#pragma once
+
+#include <vector>
+#include "KdTree.h"
+
+//////////////////////////////////////////////////////////////////////////////////////////
+// KdTree saved to file in the same layout it has in memory, so it is used directly from
+// mapped file: opening takes no time whatever the size, nothing is read until queries
+// touch it, and processes using the same file share its pages.
+//
+// File is header and arrays at offsets written in it: points (MapObject), input index of
+// each point, split axes, and input coordinates <longitude,latitude> in input order (for
+// output). Byte order and type sizes are those of the machine which wrote it, open checks
+// them.
+//////////////////////////////////////////////////////////////////////////////////////////
+
+class IndexFile
+{
+private:
+	const char * mapped;
+	size_t mappedSize;
+
+	KdTree tree;
+	const std::pair<double,double> * coordinates;
+
+public:
+	IndexFile ();
+	~IndexFile ();
+
+	// builds tree of INPUT and writes it.
+	static bool write (const char * filename, const std::vector<std::pair<double,double> > & input);
+
+	// file starts as index file (and is not CSV).
+	static bool isIndexFile (const char * filename);
+
+	bool open (const char * filename);
+	void close ();
+
+	const KdTree & index () const { return tree; }
+
+	long size () const { return tree.size(); }
+
+	// input points <longitude,latitude>, in input order.
+	const std::pair<double,double> * coordinateArray () const { return coordinates; }
+};
@@ -0,0 +1,331 @@
+/* geojson, Copyright (c) 2013-2020 Yuriy Yakimenko
+ *
+ * Permission to use, copy, modify, distribute, and sell this software and its
+ * documentation for any purpose is hereby granted without fee, provided that
+ * the above copyright notice appear in all copies and that both that
+ * copyright notice and this permission notice appear in supporting
+ * documentation.  No representations are made about the suitability of this
+ * software for any purpose.  It is provided "as is" without express or
+ * implied warranty.
+ */
+
+#include "KdTree.h"
+
+#include <algorithm>
+
+using namespace std;
+
+static inline double coord (const MapObject & p, const int axis)
+{
+	return (axis == 0) ? p.X() : (axis == 1) ? p.Y() : p.Z();
+}
+
+static inline double distance2 (const MapObject & a, const MapObject & b)
+{
+	double dx = a.X() - b.X(), dy = a.Y() - b.Y(), dz = a.Z() - b.Z();
+
+	return dx * dx + dy * dy + dz * dz;
+}
+
+KdTree::KdTree () : points(nullptr), indexes(nullptr), axes(nullptr), count(0)
+{
+}
+
+double KdTree::chord2 (const double miles)
+{
+	double angle = min (M_PI, miles / MapObject::EARTH_RADIUS);
+	double chord = 2 * sin (angle / 2);
+
+	return chord * chord;
+}
+
+double KdTree::miles (const double chord2)
+{
+	double half = min (1.0, sqrt (chord2) / 2);
+
+	return 2 * asin (half) * MapObject::EARTH_RADIUS;
+}
+
+static long lastNode (const long begin, const long end, const long node)
+{
+	if (end - begin <= KdTree::LEAF_SIZE)
+	{
+		return -1;
+	}
+
+	long middle = (begin + end) / 2;
+
+	return max (node, max (lastNode (begin, middle, 2 * node + 1), lastNode (middle + 1, end, 2 * node + 2)));
+}
+
+long KdTree::axisCount (const long count)
+{
+	return lastNode (0, count, 0) + 1;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+// split axis is the one along which points of the node spread most.
+//////////////////////////////////////////////////////////////////////////////////////////
+
+void KdTree::build (vector<int> & order, vector<MapObject> & objects, const long begin,
+				const long end, const long node)
+{
+	if (end - begin <= LEAF_SIZE)
+	{
+		return;
+	}
+
+	double low[3] = { 2, 2, 2 }, high[3] = { -2, -2, -2 };
+
+	for (long i = begin; i < end; i++)
+	{
+		for (int axis = 0; axis < 3; axis++)
+		{
+			double c = coord (objects[order[i]], axis);
+
+			low[axis] = min (low[axis], c);
+			high[axis] = max (high[axis], c);
+		}
+	}
+
+	int axis = 0;
+
+	for (int a = 1; a < 3; a++)
+	{
+		if (high[a] - low[a] > high[axis] - low[axis]) axis = a;
+	}
+
+	ownAxes[node] = (unsigned char) axis;
+
+	long middle = (begin + end) / 2;
+
+	nth_element (order.begin() + begin, order.begin() + middle, order.begin() + end, [&] (int a, int b)
+	{
+		return coord (objects[a], axis) < coord (objects[b], axis);
+	});
+
+	build (order, objects, begin, middle, 2 * node + 1);
+	build (order, objects, middle + 1, end, 2 * node + 2);
+}
+
+void KdTree::build (const vector<pair<double,double> > & input)
+{
+	vector<MapObject> objects;
+	vector<int> order;
+
+	for (size_t i = 0; i < input.size(); i++)
+	{
+		objects.push_back (MapObject (TLatLong (input[i].second, input[i].first)));
+		order.push_back ((int) i);
+	}
+
+	ownAxes.assign (axisCount ((long) input.size()), 0);
+
+	build (order, objects, 0, (long) order.size(), 0);
+
+	ownPoints.clear();
+	ownIndexes.clear();
+
+	for (int i : order)
+	{
+		ownPoints.push_back (objects[i]);
+		ownIndexes.push_back (i);
+	}
+
+	attach (ownPoints.data(), ownIndexes.data(), ownAxes.data(), (long) ownPoints.size());
+}
+
+void KdTree::attach (const MapObject * points, const int * indexes, const unsigned char * axes, const long count)
+{
+	this->points = points;
+	this->indexes = indexes;
+	this->axes = axes;
+	this->count = count;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+// HEAP keeps K nearest found so far (farthest of them on top). OFFSET is distance from Q
+// to box of the node along each axis, BOX2 is its squared length: other side of a split
+// is visited only when its box can be closer than farthest found. Split plane alone is
+// not enough for queries far from all points, they would visit most of the tree.
+//////////////////////////////////////////////////////////////////////////////////////////
+
+void KdTree::nearest (const MapObject & q, const long begin, const long end, const long node,
+				const size_t k, double offset[3], const double box2, vector<pair<double, int> > & heap) const
+{
+	auto consider = [&] (const long i)
+	{
+		double d = distance2 (q, points[i]);
+
+		if (heap.size() < k)
+		{
+			heap.push_back (make_pair (d, indexes[i]));
+			push_heap (heap.begin(), heap.end());
+		}
+		else if (d < heap.front().first)
+		{
+			pop_heap (heap.begin(), heap.end());
+			heap.back() = make_pair (d, indexes[i]);
+			push_heap (heap.begin(), heap.end());
+		}
+	};
+
+	if (end - begin <= LEAF_SIZE)
+	{
+		for (long i = begin; i < end; i++) consider (i);
+		return;
+	}
+
+	long middle = (begin + end) / 2;
+	int axis = axes[node];
+
+	double diff = coord (q, axis) - coord (points[middle], axis);
+
+	consider (middle);
+
+	long nearBegin = begin, nearEnd = middle, nearNode = 2 * node + 1;
+	long farBegin = middle + 1, farEnd = end, farNode = 2 * node + 2;
+
+	if (diff >= 0)
+	{
+		swap (nearBegin, farBegin);
+		swap (nearEnd, farEnd);
+		swap (nearNode, farNode);
+	}
+
+	nearest (q, nearBegin, nearEnd, nearNode, k, offset, box2, heap);
+
+	double old = offset[axis];
+	double farBox2 = box2 - old * old + diff * diff;
+
+	if (heap.size() < k || farBox2 < heap.front().first)
+	{
+		offset[axis] = diff;
+		nearest (q, farBegin, farEnd, farNode, k, offset, farBox2, heap);
+		offset[axis] = old;
+	}
+}
+
+void KdTree::nearest (const MapObject & q, const int k, vector<Result> & output) const
+{
+	vector<pair<double, int> > heap;
+
+	output.clear();
+
+	if (k <= 0 || count == 0)
+	{
+		return;
+	}
+
+	double offset[3] = { 0, 0, 0 };
+
+	nearest (q, 0, count, 0, (size_t) k, offset, 0, heap);
+
+	sort_heap (heap.begin(), heap.end());
+
+	for (auto & h : heap)
+	{
+		output.push_back (Result (miles (h.first), h.second));
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+// calls VISIT (squared chord, position in tree) for every point not farther than
+// MAXCHORD2 from Q. Squared chord is 2 - 2 * cosine of the angle, so this is the same as
+// comparing cosines, without any arccos per point.
+//////////////////////////////////////////////////////////////////////////////////////////
+
+template <class Visit>
+void KdTree::within (const MapObject & q, const double maxChord2, const long begin, const long end,
+				const long node, double offset[3], const double box2, Visit & visit) const
+{
+	if (end - begin <= LEAF_SIZE)
+	{
+		for (long i = begin; i < end; i++)
+		{
+			double d = distance2 (q, points[i]);
+
+			if (d <= maxChord2) visit (d, i);
+		}
+
+		return;
+	}
+
+	long middle = (begin + end) / 2;
+	int axis = axes[node];
+
+	double diff = coord (q, axis) - coord (points[middle], axis);
+	double d = distance2 (q, points[middle]);
+
+	if (d <= maxChord2) visit (d, middle);
+
+	double old = offset[axis];
+	double farBox2 = box2 - old * old + diff * diff;
+
+	if (diff < 0 || farBox2 <= maxChord2)
+	{
+		if (diff >= 0) offset[axis] = diff;
+		within (q, maxChord2, begin, middle, 2 * node + 1, offset, diff < 0 ? box2 : farBox2, visit);
+		offset[axis] = old;
+	}
+
+	if (diff >= 0 || farBox2 <= maxChord2)
+	{
+		if (diff < 0) offset[axis] = diff;
+		within (q, maxChord2, middle + 1, end, 2 * node + 2, offset, diff >= 0 ? box2 : farBox2, visit);
+		offset[axis] = old;
+	}
+}
+
+void KdTree::within (const MapObject & q, const double radiusMiles, vector<Result> & output) const
+{
+	vector<pair<double, int> > found;
+
+	output.clear();
+
+	double offset[3] = { 0, 0, 0 };
+
+	auto visit = [&] (const double d, const long i)
+	{
+		found.push_back (make_pair (d, indexes[i]));
+	};
+
+	within (q, chord2 (radiusMiles), 0, count, 0, offset, 0, visit);
+
+	sort (found.begin(), found.end());
+
+	for (auto & f : found)
+	{
+		output.push_back (Result (miles (f.first), f.second));
+	}
+}
+
+void KdTree::indexesWithin (const MapObject & q, const double radiusMiles, vector<int> & output) const
+{
+	output.clear();
+
+	double offset[3] = { 0, 0, 0 };
+
+	auto visit = [&] (const double, const long i)
+	{
+		output.push_back (indexes[i]);
+	};
+
+	within (q, chord2 (radiusMiles), 0, count, 0, offset, 0, visit);
+}
+
+long KdTree::countWithin (const MapObject & q, const double radiusMiles) const
+{
+	long result = 0;
+
+	double offset[3] = { 0, 0, 0 };
+
+	auto visit = [&] (const double, const long)
+	{
+		result++;
+	};
+
+	within (q, chord2 (radiusMiles), 0, count, 0, offset, 0, visit);
+
+	return result;
+}
@@ -0,0 +1,92 @@
+/* geojson, Copyright (c) 2013-2020 Yuriy Yakimenko
+ *
+ * Permission to use, copy, modify, distribute, and sell this software and its
+ * documentation for any purpose is hereby granted without fee, provided that
+ * the above copyright notice appear in all copies and that both that
+ * copyright notice and this permission notice appear in supporting
+ * documentation.  No representations are made about the suitability of this
+ * software for any purpose.  It is provided "as is" without express or
+ * implied warranty.
+ */
+
+#pragma once
+
+#include <vector>
+#include "MapObject.h"
+
+//////////////////////////////////////////////////////////////////////////////////////////
+// Index of points for nearest and within-radius queries: 3D kd-tree over unit vectors.
+// Straight line (chord) distance between unit vectors grows with distance on the sphere,
+// so queries compare squared chords and take arccos only of results.
+//
+// Tree has no node objects: points are reordered so that every node is a range of them,
+// split at its middle point, with children [begin, middle) and [middle + 1, end). Only
+// split axis of each node is stored, in heap order (children of node N are 2N + 1 and
+// 2N + 2). Ranges of up to LEAF_SIZE points are leaves and are scanned. Build is
+// O(n log n), queries walk contiguous memory.
+//
+// Arrays are used through pointers, so they may also be owned by someone else (for
+// example mapped from a file, see attach).
+//////////////////////////////////////////////////////////////////////////////////////////
+
+class KdTree
+{
+public:
+	static const int LEAF_SIZE = 8;
+
+	// <distance in miles, index of point in input>
+	typedef std::pair<double, int> Result;
+
+private:
+	std::vector<MapObject> ownPoints;
+	std::vector<int> ownIndexes;
+	std::vector<unsigned char> ownAxes;
+
+	const MapObject * points;
+	const int * indexes;
+	const unsigned char * axes;
+	long count;
+
+	void build (std::vector<int> & order, std::vector<MapObject> & objects, const long begin,
+		const long end, const long node);
+
+	void nearest (const MapObject & q, const long begin, const long end, const long node,
+		const size_t k, double offset[3], const double box2, std::vector<std::pair<double, int> > & heap) const;
+
+	template <class Visit>
+	void within (const MapObject & q, const double maxChord2, const long begin, const long end,
+		const long node, double offset[3], const double box2, Visit & visit) const;
+
+public:
+	KdTree ();
+
+	// points have order <longitude,latitude>.
+	void build (const std::vector<std::pair<double,double> > & input);
+
+	// uses arrays made by build (as returned by pointArray, indexArray, axisArray) without
+	// copying them; they must stay valid while tree is used.
+	void attach (const MapObject * points, const int * indexes, const unsigned char * axes, const long count);
+
+	long size () const { return count; }
+
+	const MapObject * pointArray () const { return points; }
+	const int * indexArray () const { return indexes; }
+	const unsigned char * axisArray () const { return axes; }
+
+	// length of axis array for COUNT points.
+	static long axisCount (const long count);
+
+	// K nearest points to Q, nearest first.
+	void nearest (const MapObject & q, const int k, std::vector<Result> & output) const;
+
+	// points not farther than RADIUSMILES from Q, nearest first.
+	void within (const MapObject & q, const double radiusMiles, std::vector<Result> & output) const;
+
+	// same points, only their input indexes (in no order), or only how many of them there are.
+	void indexesWithin (const MapObject & q, const double radiusMiles, std::vector<int> & output) const;
+	long countWithin (const MapObject & q, const double radiusMiles) const;
+
+	// squared chord for distance in miles, and back.
+	static double chord2 (const double miles);
+	static double miles (const double chord2);
+};
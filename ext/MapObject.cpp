@@ -13,6 +13,8 @@
 #include "MMath.h"
 #include "LatLong.h"
 
+#include <cfloat>
+
 using namespace std;
 
 const double MapObject::EARTH_RADIUS = 3958.76; // Authalic/Volumetric radius in miles
@@ -123,6 +125,182 @@ MapObject MapObject::crossProduct (const MapObject &a, const MapObject &b)
 	return MapObject (x1/n, y1/n, z1/n);
 }
 
+///////////////////////////////////////////////////////////////////////////////////
+// Helpers for exact evaluation of sign of determinant, see J. R. Shewchuk
+// "Adaptive Precision Floating-Point Arithmetic and Fast Robust Geometric Predicates".
+// Value is kept as expansion - sum of non-overlapping doubles sorted by magnitude.
+///////////////////////////////////////////////////////////////////////////////////
+
+static inline void twoSum (const double a, const double b, double & sum, double & err)
+{
+	sum = a + b;
+	double bv = sum - a;
+	double av = sum - bv;
+	err = (a - av) + (b - bv);
+}
+
+static inline void twoProduct (const double a, const double b, double & product, double & err)
+{
+	product = a * b;
+	err = fma (a, b, -product);
+}
+
+static void growExpansion (vector<double> & e, const double b)
+{
+	double q = b;
+	size_t n = 0;
+
+	for (size_t i=0; i < e.size(); i++)
+	{
+		double sum, err;
+		twoSum (q, e[i], sum, err);
+		q = sum;
+
+		if (err != 0) e[n++] = err;
+	}
+
+	e.resize (n);
+
+	if (q != 0) e.push_back (q);
+}
+
+// adds (or subtracts when negate is set) exact value of a * b * c to the expansion.
+
+static void addTripleProduct (vector<double> & e, const double a, const double b, const double c,
+                              const bool negate)
+{
+	double h, l, h1, l1, h2, l2;
+
+	twoProduct (a, b, h, l);
+	twoProduct (h, c, h1, l1);
+	twoProduct (l, c, h2, l2);
+
+	double s = negate ? -1 : 1;
+
+	growExpansion (e, s * l2);
+	growExpansion (e, s * h2);
+	growExpansion (e, s * l1);
+	growExpansion (e, s * h1);
+}
+
+static int expansionSign (const vector<double> & e)
+{
+	// largest component is the last one and it defines the sign.
+	if (e.empty()) return 0;
+
+	return (e.back() > 0) ? 1 : -1;
+}
+
+///////////////////////////////////////////////////////////////////////////////////
+// Floating-point filter: determinant is computed in doubles first, and trusted when it
+// is larger than the worst case rounding error. Only nearly degenerate triples
+// (for example three stations along a straight rail corridor) are evaluated exactly.
+///////////////////////////////////////////////////////////////////////////////////
+
+int MapObject::orientation (const MapObject &a, const MapObject &b, const MapObject &c)
+{
+	double abx = a.y * b.z;
+	double aby = a.z * b.x;
+	double abz = a.x * b.y;
+
+	double bax = a.z * b.y;
+	double bay = a.x * b.z;
+	double baz = a.y * b.x;
+
+	double det = c.x * (abx - bax) + c.y * (aby - bay) + c.z * (abz - baz);
+
+	double permanent = fabs(c.x) * (fabs(abx) + fabs(bax)) +
+	                   fabs(c.y) * (fabs(aby) + fabs(bay)) +
+	                   fabs(c.z) * (fabs(abz) + fabs(baz));
+
+	// error of the double evaluation stays below 5 * (DBL_EPSILON / 2) * permanent,
+	// bound below leaves a safe margin for rounding of the permanent itself.
+	const double errBound = 8.0 * DBL_EPSILON * permanent;
+
+	if (det > errBound) return 1;
+	if (-det > errBound) return -1;
+
+	vector<double> e;
+
+	addTripleProduct (e, c.x, a.y, b.z, false);
+	addTripleProduct (e, c.x, a.z, b.y, true);
+	addTripleProduct (e, c.y, a.z, b.x, false);
+	addTripleProduct (e, c.y, a.x, b.z, true);
+	addTripleProduct (e, c.z, a.x, b.y, false);
+	addTripleProduct (e, c.z, a.y, b.x, true);
+
+	return expansionSign (e);
+}
+
+///////////////////////////////////////////////////////////////////////////////////
+// in-circle test in the plane, with the same kind of filter (Shewchuk's incircle, bound
+// (10 + 96 * DBL_EPSILON) * DBL_EPSILON times permanent). Exactly, determinant of rows
+// (x, y, x * x + y * y, 1) is expanded by its third column into products of four doubles.
+///////////////////////////////////////////////////////////////////////////////////
+
+// adds exact value of a * b * c * d.
+
+static void addQuadProduct (vector<double> & e, const double a, const double b, const double c, const double d,
+                            const bool negate)
+{
+	double h, l;
+
+	twoProduct (a, b, h, l);
+
+	addTripleProduct (e, h, c, d, negate);
+	addTripleProduct (e, l, c, d, negate);
+}
+
+// adds (x * x + y * y of P) * det ((Q, 1), (R, 1), (S, 1)).
+
+static void addLiftedMinor (vector<double> & e, const pair<double,double> & p, const pair<double,double> & q,
+                            const pair<double,double> & r, const pair<double,double> & s, const bool negate)
+{
+	const double * coords[2] = { &p.first, &p.second };
+
+	for (auto c : coords)
+	{
+		addQuadProduct (e, *c, *c, q.first, r.second, negate);
+		addQuadProduct (e, *c, *c, q.first, s.second, !negate);
+		addQuadProduct (e, *c, *c, q.second, r.first, !negate);
+		addQuadProduct (e, *c, *c, q.second, s.first, negate);
+		addQuadProduct (e, *c, *c, r.first, s.second, negate);
+		addQuadProduct (e, *c, *c, r.second, s.first, !negate);
+	}
+}
+
+int MapObject::inCircle (const pair<double,double> & a, const pair<double,double> & b,
+                         const pair<double,double> & c, const pair<double,double> & d)
+{
+	double adx = a.first - d.first, ady = a.second - d.second;
+	double bdx = b.first - d.first, bdy = b.second - d.second;
+	double cdx = c.first - d.first, cdy = c.second - d.second;
+
+	double alift = adx * adx + ady * ady;
+	double blift = bdx * bdx + bdy * bdy;
+	double clift = cdx * cdx + cdy * cdy;
+
+	double det = alift * (bdx * cdy - cdx * bdy) + blift * (cdx * ady - adx * cdy) + clift * (adx * bdy - bdx * ady);
+
+	double permanent = (fabs(bdx * cdy) + fabs(cdx * bdy)) * alift +
+	                   (fabs(cdx * ady) + fabs(adx * cdy)) * blift +
+	                   (fabs(adx * bdy) + fabs(bdx * ady)) * clift;
+
+	const double errBound = 12.0 * DBL_EPSILON * permanent;
+
+	if (det > errBound) return 1;
+	if (-det > errBound) return -1;
+
+	vector<double> e;
+
+	addLiftedMinor (e, a, b, c, d, false);
+	addLiftedMinor (e, b, a, c, d, true);
+	addLiftedMinor (e, c, a, b, d, false);
+	addLiftedMinor (e, d, a, b, c, true);
+
+	return expansionSign (e);
+}
+
 ///////////////////////////////////////////////////////////////////////////////////
 
 double MapObject::distanceToSegment (const MapObject & a, const MapObject & b,
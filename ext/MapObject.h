@@ -15,6 +15,7 @@
 #include <cstring>
 #include <memory>
 #include <vector>
+#include <utility>
 #include <stdio.h>
 #include <cmath>
 
@@ -52,6 +53,16 @@ public:
     }
 
     static MapObject crossProduct (const MapObject &a, const MapObject &b);
+
+    // sign of the triple product c . (a x b): 1 when c is to the left of the great circle
+    // going from a to b, -1 when it is to the right and 0 only when exactly on it.
+    static int orientation (const MapObject &a, const MapObject &b, const MapObject &c);
+
+    // sign of in-circle determinant of <x,y> points: 1 when d is inside of circle through a, b
+    // and c (counterclockwise), -1 when outside, 0 only when exactly on it.
+    static int inCircle (const std::pair<double,double> &a, const std::pair<double,double> &b,
+                         const std::pair<double,double> &c, const std::pair<double,double> &d);
+
     void transform (double gamma, double theta);
     void inverse_transform (double gamma, double theta);
 	static MapObject midpoint (const MapObject &a, const MapObject &b);
@@ -0,0 +1,613 @@
+/* geojson, Copyright (c) 2013-2020 Yuriy Yakimenko
+ *
+ * Permission to use, copy, modify, distribute, and sell this software and its
+ * documentation for any purpose is hereby granted without fee, provided that
+ * the above copyright notice appear in all copies and that both that
+ * copyright notice and this permission notice appear in supporting
+ * documentation.  No representations are made about the suitability of this
+ * software for any purpose.  It is provided "as is" without express or
+ * implied warranty.
+ */
+
+#include "Overlay.h"
+#include "GeoUtils.h"
+#include "Parallel.h"
+#include "SegmentIndex.h"
+
+#include <algorithm>
+
+using namespace std;
+
+static inline double dot (const MapObject & a, const MapObject & b)
+{
+	return a.X() * b.X() + a.Y() * b.Y() + a.Z() * b.Z();
+}
+
+static inline bool lessXYZ (const MapObject & a, const MapObject & b)
+{
+	if (a.X() != b.X()) return a.X() < b.X();
+	if (a.Y() != b.Y()) return a.Y() < b.Y();
+
+	return a.Z() < b.Z();
+}
+
+// direction from C towards A, as angle counterclockwise in plane touching the sphere at C.
+
+static double direction (const MapObject & c, const MapObject & a)
+{
+	double ax = (fabs (c.Z()) < 0.9) ? 0 : 1;
+	double az = 1 - ax;
+
+	MapObject f1 = MapObject::crossProduct (MapObject (ax, 0, az), c);
+	MapObject f2 = MapObject::crossProduct (c, f1);
+
+	return atan2 (dot (a, f2), dot (a, f1));
+}
+
+// where a piece is, compared to the other area: SAME and OPPOSITE are on its boundary,
+// going the same or opposite way.
+
+static const int INSIDE = 0;
+static const int OUTSIDE = 1;
+static const int SAME = 2;
+static const int OPPOSITE = 3;
+
+// rings (inside on the left) and their edges.
+
+struct OverlayArea
+{
+	vector<vector<MapObject> > rings;
+	SegmentIndex index;
+};
+
+// piece of ring between two cuts (or whole ring, CLOSED, when it has none).
+
+struct OverlayRun
+{
+	vector<MapObject> points;
+	bool closed;
+	int status;
+
+	OverlayRun () : closed(false), status(OUTSIDE) { }
+};
+
+struct OverlayCut
+{
+	int line, edge;
+	double along;            // grows from start of the edge to its end.
+	MapObject point;
+
+	OverlayCut (const int l, const int e, const double a, const MapObject & p) :
+		line(l), edge(e), along(a), point(p) { }
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+static void prepare (const vector<vector<vector<MapObject> > > & polygons, OverlayArea & area)
+{
+	for (auto & polygon : polygons)
+	{
+		for (size_t r = 0; r < polygon.size(); r++)
+		{
+			vector<MapObject> ring;
+
+			for (auto & pt : polygon[r])
+			{
+				if (ring.empty() || !(pt == ring.back())) ring.push_back (pt);
+			}
+
+			while (ring.size() > 1 && ring.back() == ring.front()) ring.pop_back();
+
+			if (ring.size() < 3) continue;
+
+			// outer ring counterclockwise, holes clockwise.
+
+			if ((GeoUtils::ringArea (ring) > 0) != (r == 0))
+			{
+				reverse (ring.begin(), ring.end());
+			}
+
+			area.rings.push_back (ring);
+		}
+	}
+
+	for (size_t line = 0; line < area.rings.size(); line++)
+	{
+		vector<MapObject> closed (area.rings[line]);
+
+		closed.push_back (closed.front());
+
+		area.index.addPolyline ((int) line, closed);
+	}
+
+	area.index.build();
+}
+
+// cut at P of SEGMENT: at its end, that vertex becomes a node.
+
+static void addCut (const OverlayArea & area, const int segment, const MapObject & p, vector<OverlayCut> & cuts,
+			vector<vector<char> > & nodes)
+{
+	int line = area.index.line (segment);
+	int edge = area.index.index (segment);
+
+	const vector<MapObject> & ring = area.rings[line];
+
+	int next = (edge + 1) % (int) ring.size();
+
+	if (p == ring[edge])
+	{
+		nodes[line][edge] = 1;
+	}
+	else if (p == ring[next])
+	{
+		nodes[line][next] = 1;
+	}
+	else
+	{
+		cuts.push_back (OverlayCut (line, edge, dot (p, ring[next]) - dot (p, ring[edge]), p));
+	}
+}
+
+static void cutRings (const OverlayArea & area, vector<OverlayCut> & cuts, const vector<vector<char> > & nodes,
+			vector<OverlayRun> & runs)
+{
+	sort (cuts.begin(), cuts.end(), [] (const OverlayCut & a, const OverlayCut & b)
+	{
+		if (a.line != b.line) return a.line < b.line;
+		if (a.edge != b.edge) return a.edge < b.edge;
+
+		return a.along < b.along;
+	});
+
+	size_t k = 0;
+
+	vector<MapObject> points;
+	vector<char> node;
+
+	for (size_t line = 0; line < area.rings.size(); line++)
+	{
+		const vector<MapObject> & ring = area.rings[line];
+
+		points.clear();
+		node.clear();
+
+		for (size_t i = 0; i < ring.size(); i++)
+		{
+			points.push_back (ring[i]);
+			node.push_back (nodes[line][i]);
+
+			for (; k < cuts.size() && cuts[k].line == (int) line && cuts[k].edge == (int) i; k++)
+			{
+				if (cuts[k].point == points.back())
+				{
+					node.back() = 1;
+					continue;
+				}
+
+				points.push_back (cuts[k].point);
+				node.push_back (1);
+			}
+		}
+
+		size_t first = find (node.begin(), node.end(), 1) - node.begin();
+
+		if (first == node.size())
+		{
+			runs.push_back (OverlayRun ());
+			runs.back().points = points;
+			runs.back().closed = true;
+			continue;
+		}
+
+		// from node to node, around from the first one.
+
+		size_t m = points.size();
+
+		runs.push_back (OverlayRun ());
+		runs.back().points.push_back (points[first]);
+
+		for (size_t j = first + 1; j <= first + m; j++)
+		{
+			runs.back().points.push_back (points[j % m]);
+
+			if (node[j % m] && j < first + m)
+			{
+				runs.push_back (OverlayRun ());
+				runs.back().points.push_back (points[j % m]);
+			}
+		}
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+// where is the piece from A to B compared to OTHER area: side of the nearest edge to its
+// middle, or of the two edges when the nearest point is their common vertex.
+//////////////////////////////////////////////////////////////////////////////////////////
+
+static int classify (const MapObject & a, const MapObject & b, const OverlayArea & other)
+{
+	MapObject p = MapObject::midpoint (a, b);
+
+	SegmentIndex::Match match;
+
+	if (!other.index.nearest (p, 0, match))
+	{
+		return OUTSIDE;
+	}
+
+	const vector<MapObject> & ring = other.rings[other.index.line (match.segment)];
+
+	int n = (int) ring.size();
+	int i = other.index.index (match.segment);
+
+	const MapObject & start = ring[i];
+	const MapObject & end = ring[(i + 1) % n];
+
+	if (match.closest == start || match.closest == end)
+	{
+		int v = (match.closest == start) ? i : (i + 1) % n;
+
+		const MapObject & u = ring[(v + n - 1) % n];
+		const MapObject & w = ring[(v + 1) % n];
+
+		bool left1 = MapObject::orientation (u, ring[v], p) > 0;
+		bool left2 = MapObject::orientation (ring[v], w, p) > 0;
+
+		// inside of convex corner is left of both edges, of concave one left of either.
+
+		if (MapObject::orientation (u, ring[v], w) > 0)
+		{
+			return (left1 && left2) ? INSIDE : OUTSIDE;
+		}
+
+		return (left1 || left2) ? INSIDE : OUTSIDE;
+	}
+
+	// on the edge: pieces of edges which are the same (up to rounding).
+
+	double c = dot (MapObject::crossProduct (a, b), MapObject::crossProduct (start, end));
+
+	if (match.distanceMiles < 1e-9 * MapObject::EARTH_RADIUS && fabs (c) > 1 - 1e-12)
+	{
+		return (c > 0) ? SAME : OPPOSITE;
+	}
+
+	return (MapObject::orientation (start, end, p) > 0) ? INSIDE : OUTSIDE;
+}
+
+static void classify (vector<OverlayRun> & runs, const OverlayArea & other, const int threads)
+{
+	Parallel::forEachPart ((long) runs.size(), Parallel::threadCount (threads), [&] (int, long begin, long end)
+	{
+		for (long r = begin; r < end; r++)
+		{
+			const vector<MapObject> & points = runs[r].points;
+
+			size_t count = points.size() - (runs[r].closed ? 0 : 1);
+
+			// the longest piece, farthest from other edges.
+
+			size_t best = 0;
+			double bestDot = 2;
+
+			for (size_t i = 0; i < count; i++)
+			{
+				double d = dot (points[i], points[(i + 1) % points.size()]);
+
+				if (d < bestDot)
+				{
+					bestDot = d;
+					best = i;
+				}
+			}
+
+			runs[r].status = classify (points[best], points[(best + 1) % points.size()], other);
+		}
+	});
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+// kept runs joined at their ends into rings.
+//////////////////////////////////////////////////////////////////////////////////////////
+
+static void join (vector<OverlayRun> & runs, vector<vector<MapObject> > & rings)
+{
+	vector<pair<MapObject,int> > starts;
+
+	for (size_t r = 0; r < runs.size(); r++)
+	{
+		if (runs[r].closed)
+		{
+			rings.push_back (runs[r].points);
+		}
+		else
+		{
+			starts.push_back (make_pair (runs[r].points.front(), (int) r));
+		}
+	}
+
+	sort (starts.begin(), starts.end(), [] (const pair<MapObject,int> & a, const pair<MapObject,int> & b)
+	{
+		return lessXYZ (a.first, b.first) || (a.first == b.first && a.second < b.second);
+	});
+
+	vector<char> used (runs.size(), 0);
+
+	for (auto & s : starts)
+	{
+		if (used[s.second]) continue;
+
+		vector<MapObject> ring;
+
+		int current = s.second;
+
+		const MapObject start = runs[current].points.front();
+
+		while (true)
+		{
+			const vector<MapObject> & points = runs[current].points;
+
+			used[current] = 1;
+
+			ring.insert (ring.end(), points.begin(), points.end() - 1);
+
+			const MapObject & node = points.back();
+
+			if (node == start) break;
+
+			// runs going on from NODE: the first clockwise from where this one came.
+
+			auto from = lower_bound (starts.begin(), starts.end(), make_pair (node, -1),
+				[] (const pair<MapObject,int> & a, const pair<MapObject,int> & b)
+			{
+				return lessXYZ (a.first, b.first) || (a.first == b.first && a.second < b.second);
+			});
+
+			int next = -1;
+			double bestTurn = 0;
+
+			double back = direction (node, points[points.size() - 2]);
+
+			for (auto it = from; it != starts.end() && it->first == node; it++)
+			{
+				if (used[it->second]) continue;
+
+				double turn = back - direction (node, runs[it->second].points[1]);
+
+				while (turn <= 0) turn += 2 * M_PI;
+				while (turn > 2 * M_PI) turn -= 2 * M_PI;
+
+				if (next < 0 || turn < bestTurn)
+				{
+					next = it->second;
+					bestTurn = turn;
+				}
+			}
+
+			// only with rounding of crossings very close to each other.
+
+			if (next < 0) break;
+
+			current = next;
+		}
+
+		if (ring.size() > 2)
+		{
+			rings.push_back (ring);
+		}
+	}
+}
+
+// side of P at its nearest point CLOSEST on RING (inside on the left), which is on the edge
+// from vertex INDEX: 1 inside, -1 outside, 0 when P is on the ring or it is not clear.
+
+static int sideOfNearest (const vector<MapObject> & ring, const int index, const MapObject & closest,
+			const MapObject & p)
+{
+	int n = (int) ring.size();
+
+	const MapObject & a = ring[index % n];
+	const MapObject & b = ring[(index + 1) % n];
+
+	if (!(closest == a) && !(closest == b))
+	{
+		return MapObject::orientation (a, b, p);
+	}
+
+	// nearest to vertex V: inside is left of both its edges at convex vertex, left of either
+	// at reflex one.
+
+	int v = (closest == a) ? index % n : (index + 1) % n;
+	int u = v, w = v;
+
+	do u = (u + n - 1) % n; while (u != v && ring[u] == ring[v]);
+	do w = (w + 1) % n; while (w != v && ring[w] == ring[v]);
+
+	int in = MapObject::orientation (ring[u], ring[v], p);
+	int out = MapObject::orientation (ring[v], ring[w], p);
+	int turn = MapObject::orientation (ring[u], ring[v], ring[w]);
+
+	if (in == 0 || out == 0 || turn == 0)
+	{
+		return 0;
+	}
+
+	if (turn > 0)
+	{
+		return (in > 0 && out > 0) ? 1 : -1;
+	}
+
+	return (in > 0 || out > 0) ? 1 : -1;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+void Overlay::compute (const int operation, const vector<vector<vector<MapObject> > > & a,
+			const vector<vector<vector<MapObject> > > & b, vector<vector<vector<MapObject> > > & output,
+			const int threads)
+{
+	OverlayArea areas[2];
+
+	prepare (a, areas[0]);
+	prepare (b, areas[1]);
+
+	vector<SegmentIndex::Crossing> crossings;
+
+	areas[0].index.crossings (areas[1].index, crossings, threads);
+
+	vector<OverlayRun> runs[2];
+
+	for (int side = 0; side < 2; side++)
+	{
+		vector<OverlayCut> cuts;
+		vector<vector<char> > nodes;
+
+		for (auto & ring : areas[side].rings)
+		{
+			nodes.push_back (vector<char> (ring.size(), 0));
+		}
+
+		for (auto & c : crossings)
+		{
+			addCut (areas[side], (side == 0) ? c.first : c.second, c.point, cuts, nodes);
+		}
+
+		cutRings (areas[side], cuts, nodes, runs[side]);
+
+		classify (runs[side], areas[1 - side], threads);
+	}
+
+	// pieces of the result: of A outside of B for union, inside for intersection, ...
+	// boundary they have in common is taken from A.
+
+	vector<OverlayRun> kept;
+
+	for (int side = 0; side < 2; side++)
+	{
+		for (auto & run : runs[side])
+		{
+			int s = run.status;
+
+			bool keep = (operation == UNION) ? (s == OUTSIDE || (side == 0 && s == SAME)) :
+				(operation == INTERSECTION) ? (s == INSIDE || (side == 0 && s == SAME)) :
+				(side == 0) ? (s == OUTSIDE || s == OPPOSITE) : (s == INSIDE);
+
+			if (!keep) continue;
+
+			kept.push_back (OverlayRun ());
+			kept.back().points.swap (run.points);
+			kept.back().closed = run.closed;
+
+			// ... and of B inside of A, turned around, for difference.
+
+			if (operation == DIFFERENCE && side == 1)
+			{
+				reverse (kept.back().points.begin(), kept.back().points.end());
+			}
+		}
+	}
+
+	vector<vector<MapObject> > rings;
+
+	join (kept, rings);
+
+	// outer rings and holes, like in SphericalDelaunay::circlesUnion: hole goes to the
+	// smallest outer ring around it. Nothing is between a hole and the nearest outer edge
+	// (rings do not cross), so when the hole is on its inner side, that is the ring. Only
+	// hole around an island of another polygon, or touching an outer ring, is tested against
+	// outer rings one by one. Outer ring within a hemisphere is inside of the circle around
+	// its vertices, which skips most of them.
+
+	vector<double> areasOf;
+	vector<int> outer, holes;
+	vector<MapObject> centers;
+	vector<double> spans;
+
+	SegmentIndex outerEdges;
+
+	for (size_t r = 0; r < rings.size(); r++)
+	{
+		areasOf.push_back (GeoUtils::ringArea (rings[r]));
+
+		if (areasOf.back() <= 0)
+		{
+			holes.push_back ((int) r);
+			continue;
+		}
+
+		double x = 0, y = 0, z = 0;
+
+		for (auto & pt : rings[r])
+		{
+			x += pt.X(); y += pt.Y(); z += pt.Z();
+		}
+
+		double n = sqrt (x * x + y * y + z * z);
+
+		MapObject center (x / n, y / n, z / n);
+
+		double span = 1;
+
+		for (auto & pt : rings[r]) span = min (span, dot (pt, center));
+
+		vector<MapObject> closed (rings[r]);
+		closed.push_back (closed.front());
+
+		outerEdges.addPolyline ((int) outer.size(), closed);
+
+		outer.push_back ((int) r);
+		centers.push_back (center);
+		spans.push_back (span);
+
+		output.push_back (vector<vector<MapObject> > (1, rings[r]));
+	}
+
+	outerEdges.build();
+
+	vector<int> holeOuter (holes.size(), -1);
+
+	Parallel::forEachPart ((long) holes.size(), Parallel::threadCount (threads), [&] (int, long begin, long end)
+	{
+		for (long h = begin; h < end; h++)
+		{
+			const MapObject & p = rings[holes[h]].front();
+
+			SegmentIndex::Match match;
+
+			if (outerEdges.nearest (p, 0, match))
+			{
+				int o = outerEdges.line (match.segment);
+
+				if (sideOfNearest (rings[outer[o]], outerEdges.index (match.segment), match.closest, p) > 0)
+				{
+					holeOuter[h] = o;
+					continue;
+				}
+			}
+
+			int best = -1;
+
+			for (size_t o = 0; o < outer.size(); o++)
+			{
+				if (spans[o] > 0 && dot (p, centers[o]) < spans[o] - 1e-9) continue;
+
+				if (GeoUtils::ringContains (rings[outer[o]], p) &&
+					(best < 0 || areasOf[outer[o]] < areasOf[outer[best]]))
+				{
+					best = (int) o;
+				}
+			}
+
+			holeOuter[h] = best;
+		}
+	});
+
+	for (size_t h = 0; h < holes.size(); h++)
+	{
+		if (holeOuter[h] >= 0)
+		{
+			output[holeOuter[h]].push_back (rings[holes[h]]);
+		}
+	}
+}
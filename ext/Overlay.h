@@ -0,0 +1,43 @@
+/* geojson, Copyright (c) 2013-2020 Yuriy Yakimenko
+ *
+ * Permission to use, copy, modify, distribute, and sell this software and its
+ * documentation for any purpose is hereby granted without fee, provided that
+ * the above copyright notice appear in all copies and that both that
+ * copyright notice and this permission notice appear in supporting
+ * documentation.  No representations are made about the suitability of this
+ * software for any purpose.  It is provided "as is" without express or
+ * implied warranty.
+ */
+
+#pragma once
+
+#include <vector>
+#include "MapObject.h"
+
+//////////////////////////////////////////////////////////////////////////////////////////
+// Union, intersection and difference of two areas, each given as polygons (outer ring and
+// its holes) with great circle edges.
+//
+// Edges of both areas which cross are found in SegmentIndex, and rings are cut there into
+// pieces. Between two cuts a piece is all inside or all outside of the other area, so one
+// point of it is tested: nearest edge of the other area, and the side of it (edges are
+// turned so that inside is on the left), O(log n). Pieces the operation keeps are joined
+// at the cuts into rings; where more of them meet (areas touching in a point), the one
+// turning most to the right is taken, so rings do not touch themselves. Time is
+// O((n + k) log n) for n vertices and k crossings.
+//////////////////////////////////////////////////////////////////////////////////////////
+
+class Overlay
+{
+public:
+	static const int UNION = 0;
+	static const int INTERSECTION = 1;
+	static const int DIFFERENCE = 2;     // A without B.
+
+	// OPERATION of areas A and B: polygons of each must not overlap each other, rings may
+	// go either way and may repeat the first point at the end. Each polygon of OUTPUT is
+	// outer ring (counterclockwise) and its holes (clockwise).
+	static void compute (const int operation, const std::vector<std::vector<std::vector<MapObject> > > & a,
+		const std::vector<std::vector<std::vector<MapObject> > > & b,
+		std::vector<std::vector<std::vector<MapObject> > > & output, const int threads = 1);
+};
@@ -0,0 +1,62 @@
+/* geojson, Copyright (c) 2013-2020 Yuriy Yakimenko
+ *
+ * Permission to use, copy, modify, distribute, and sell this software and its
+ * documentation for any purpose is hereby granted without fee, provided that
+ * the above copyright notice appear in all copies and that both that
+ * copyright notice and this permission notice appear in supporting
+ * documentation.  No representations are made about the suitability of this
+ * software for any purpose.  It is provided "as is" without express or 
+ * implied warranty.
+ */
+
+#pragma once
+
+#include <thread>
+#include <vector>
+
+class Parallel
+{
+public:
+	// 0 or negative means "use all cores".
+	static int threadCount (const int requested)
+	{
+		if (requested > 0) return requested;
+
+		int hw = (int) std::thread::hardware_concurrency();
+
+		return (hw > 0) ? hw : 1;
+	}
+
+	// splits [0, count) into THREADS contiguous parts and calls fn (part, begin, end)
+	// for each of them. Last part runs on the calling thread.
+	template <typename Fn>
+	static void forEachPart (const long count, const int threads, Fn fn)
+	{
+		int parts = threads;
+
+		if (parts > count) parts = (int) count;
+		if (parts < 1) parts = 1;
+
+		std::vector<std::thread> workers;
+
+		for (int part = 0; part < parts; part++)
+		{
+			long begin = count * part / parts;
+			long end = count * (part + 1) / parts;
+
+			if (part == parts - 1)
+			{
+				fn (part, begin, end);
+			}
+			else
+			{
+				workers.emplace_back (fn, part, begin, end);
+			}
+		}
+
+		for (auto & worker : workers)
+		{
+			worker.join();
+		}
+	}
+};
@@ -0,0 +1,566 @@
+/* geojson, Copyright (c) 2013-2020 Yuriy Yakimenko
+ *
+ * Permission to use, copy, modify, distribute, and sell this software and its
+ * documentation for any purpose is hereby granted without fee, provided that
+ * the above copyright notice appear in all copies and that both that
+ * copyright notice and this permission notice appear in supporting
+ * documentation.  No representations are made about the suitability of this
+ * software for any purpose.  It is provided "as is" without express or
+ * implied warranty.
+ */
+
+#include "SegmentIndex.h"
+#include "Parallel.h"
+
+#include <algorithm>
+#include <tuple>
+
+using namespace std;
+
+static inline double dot (const MapObject & a, const MapObject & b)
+{
+	return a.X() * b.X() + a.Y() * b.Y() + a.Z() * b.Z();
+}
+
+static inline double coord (const MapObject & p, const int axis)
+{
+	return (axis == 0) ? p.X() : (axis == 1) ? p.Y() : p.Z();
+}
+
+static inline double distance2 (const MapObject & a, const MapObject & b)
+{
+	double dx = a.X() - b.X(), dy = a.Y() - b.Y(), dz = a.Z() - b.Z();
+
+	return dx * dx + dy * dy + dz * dz;
+}
+
+void SegmentIndex::addPolyline (const int line, const vector<MapObject> & points)
+{
+	int order = 0;
+
+	for (size_t i = 1; i < points.size(); i++)
+	{
+		const MapObject & a = points[i - 1];
+		const MapObject & b = points[i];
+
+		// repeated and (nearly) opposite points have no great circle.
+
+		if (a == b || dot (a, b) < -0.999999)
+		{
+			continue;
+		}
+
+		segments.push_back (Segment (a, b, MapObject::crossProduct (a, b), line, (int) i - 1, order++));
+	}
+
+	if (order > 1 && points.front() == points.back())
+	{
+		segments.back().closing = true;
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+// ENDS has box around ends of each segment (low x, y, z, high x, y, z) and its bulge, so
+// that only ORDER is moved while splitting (segments are reordered once, at the end).
+
+void SegmentIndex::build (vector<int> & order, const vector<double> & ends, const long begin, const long end,
+				const long node)
+{
+	double * box = &boxes[6 * node];
+
+	double bulge = 0;
+
+	for (int axis = 0; axis < 3; axis++)
+	{
+		box[axis] = 2;
+		box[axis + 3] = -2;
+	}
+
+	for (long i = begin; i < end; i++)
+	{
+		const double * e = &ends[7 * order[i]];
+
+		for (int axis = 0; axis < 3; axis++)
+		{
+			box[axis] = min (box[axis], e[axis]);
+			box[axis + 3] = max (box[axis + 3], e[axis + 3]);
+		}
+
+		bulge = max (bulge, e[6]);
+	}
+
+	for (int axis = 0; axis < 3; axis++)
+	{
+		box[axis] -= bulge;
+		box[axis + 3] += bulge;
+	}
+
+	if (end - begin <= LEAF_SIZE)
+	{
+		return;
+	}
+
+	int axis = 0;
+
+	for (int a = 1; a < 3; a++)
+	{
+		if (box[a + 3] - box[a] > box[axis + 3] - box[axis]) axis = a;
+	}
+
+	long middle = (begin + end) / 2;
+
+	// low + high is sum of ends (the same as center).
+
+	const double * e = ends.data();
+
+	nth_element (order.begin() + begin, order.begin() + middle, order.begin() + end,
+		[axis, e] (const int s, const int t)
+	{
+		return e[7 * s + axis] + e[7 * s + axis + 3] < e[7 * t + axis] + e[7 * t + axis + 3];
+	});
+
+	build (order, ends, begin, middle, 2 * node + 1);
+	build (order, ends, middle + 1, end, 2 * node + 2);
+}
+
+static long lastNode (const long begin, const long end, const long node)
+{
+	if (end - begin <= SegmentIndex::LEAF_SIZE)
+	{
+		return node;
+	}
+
+	long middle = (begin + end) / 2;
+
+	return max (node, max (lastNode (begin, middle, 2 * node + 1), lastNode (middle + 1, end, 2 * node + 2)));
+}
+
+void SegmentIndex::build ()
+{
+	boxes.assign (6 * (lastNode (0, (long) segments.size(), 0) + 1), 0);
+
+	if (segments.empty())
+	{
+		return;
+	}
+
+	vector<int> order (segments.size());
+	vector<double> ends (7 * segments.size());
+
+	for (size_t i = 0; i < segments.size(); i++)
+	{
+		const Segment & s = segments[i];
+
+		order[i] = (int) i;
+
+		for (int axis = 0; axis < 3; axis++)
+		{
+			ends[7 * i + axis] = min (coord (s.a, axis), coord (s.b, axis));
+			ends[7 * i + axis + 3] = max (coord (s.a, axis), coord (s.b, axis));
+		}
+
+		// 1 - cos (angle / 2), from cos of the angle between ends.
+
+		ends[7 * i + 6] = 1 - sqrt (max (0.0, (1 + dot (s.a, s.b)) / 2));
+	}
+
+	build (order, ends, 0, (long) segments.size(), 0);
+
+	vector<Segment> sorted;
+
+	sorted.reserve (segments.size());
+
+	for (int i : order)
+	{
+		sorted.push_back (segments[i]);
+	}
+
+	segments.swap (sorted);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+// squared chord from P to segment S, and the closest point of it.
+//////////////////////////////////////////////////////////////////////////////////////////
+
+static double segmentDistance2 (const MapObject & p, const MapObject & a, const MapObject & b,
+				const MapObject & normal, MapObject & closest)
+{
+	double h = dot (p, normal);
+
+	// projection of P onto the plane of great circle.
+
+	double tx = p.X() - h * normal.X();
+	double ty = p.Y() - h * normal.Y();
+	double tz = p.Z() - h * normal.Z();
+
+	double length = sqrt (tx * tx + ty * ty + tz * tz);
+
+	if (length > 1e-12)
+	{
+		MapObject t (tx / length, ty / length, tz / length);
+
+		// T is between ends when turning from A to T and from T to B goes the same way as
+		// from A to B (around the normal).
+
+		double fromA = normal.X() * (a.Y() * t.Z() - a.Z() * t.Y()) + normal.Y() * (a.Z() * t.X() - a.X() * t.Z()) +
+			normal.Z() * (a.X() * t.Y() - a.Y() * t.X());
+		double toB = normal.X() * (t.Y() * b.Z() - t.Z() * b.Y()) + normal.Y() * (t.Z() * b.X() - t.X() * b.Z()) +
+			normal.Z() * (t.X() * b.Y() - t.Y() * b.X());
+
+		// 2 - 2 * cos, written without subtracting nearly equal numbers (LENGTH is the cosine,
+		// H the sine of distance).
+
+		if (fromA >= 0 && toB >= 0)
+		{
+			closest = t;
+			return 2 * h * h / (1 + length);
+		}
+	}
+
+	double da = distance2 (p, a), db = distance2 (p, b);
+
+	closest = (da <= db) ? a : b;
+
+	return min (da, db);
+}
+
+static double boxDistance2 (const MapObject & p, const double * box)
+{
+	double result = 0;
+
+	for (int axis = 0; axis < 3; axis++)
+	{
+		double c = coord (p, axis);
+		double d = (c < box[axis]) ? box[axis] - c : (c > box[axis + 3]) ? c - box[axis + 3] : 0;
+
+		result += d * d;
+	}
+
+	return result;
+}
+
+void SegmentIndex::nearest (const MapObject & p, const long begin, const long end, const long node,
+				const MapObject * skipA, const MapObject * skipB, double & best2, long & best,
+				MapObject & closest) const
+{
+	MapObject candidate (0, 0, 1);
+
+	auto consider = [&] (const long i)
+	{
+		const Segment & s = segments[i];
+
+		if (skipA)
+		{
+			if (!skipB && (s.a == *skipA || s.b == *skipA)) return;
+
+			if (skipB && ((s.a == *skipA && s.b == *skipB) || (s.a == *skipB && s.b == *skipA))) return;
+		}
+
+		double d = segmentDistance2 (p, s.a, s.b, s.normal, candidate);
+
+		if (d < best2)
+		{
+			best2 = d;
+			best = i;
+			closest = candidate;
+		}
+	};
+
+	if (end - begin <= LEAF_SIZE)
+	{
+		for (long i = begin; i < end; i++) consider (i);
+		return;
+	}
+
+	long middle = (begin + end) / 2;
+
+	consider (middle);
+
+	long left = 2 * node + 1, right = 2 * node + 2;
+
+	double leftDistance = boxDistance2 (p, &boxes[6 * left]);
+	double rightDistance = boxDistance2 (p, &boxes[6 * right]);
+
+	if (leftDistance <= rightDistance)
+	{
+		if (leftDistance < best2) nearest (p, begin, middle, left, skipA, skipB, best2, best, closest);
+		if (rightDistance < best2) nearest (p, middle + 1, end, right, skipA, skipB, best2, best, closest);
+	}
+	else
+	{
+		if (rightDistance < best2) nearest (p, middle + 1, end, right, skipA, skipB, best2, best, closest);
+		if (leftDistance < best2) nearest (p, begin, middle, left, skipA, skipB, best2, best, closest);
+	}
+}
+
+bool SegmentIndex::nearest (const MapObject & p, const double maxMiles, Match & match) const
+{
+	return nearest (p, maxMiles, nullptr, nullptr, match);
+}
+
+bool SegmentIndex::nearestOther (const MapObject & p, const double maxMiles, const MapObject & a,
+				const MapObject * b, Match & match) const
+{
+	return nearest (p, maxMiles, &a, b, match);
+}
+
+bool SegmentIndex::nearest (const MapObject & p, const double maxMiles, const MapObject * skipA,
+				const MapObject * skipB, Match & match) const
+{
+	match.segment = -1;
+
+	if (segments.empty())
+	{
+		return false;
+	}
+
+	// squared chord of MAXMILES (a bit more, so segment exactly that far is found).
+
+	double best2 = 5;
+
+	if (maxMiles > 0)
+	{
+		double chord = 2 * sin (min (M_PI, maxMiles / MapObject::EARTH_RADIUS) / 2);
+
+		best2 = chord * chord * (1 + 1e-12) + 1e-18;
+	}
+
+	long best = -1;
+
+	nearest (p, 0, (long) segments.size(), 0, skipA, skipB, best2, best, match.closest);
+
+	if (best < 0)
+	{
+		return false;
+	}
+
+	match.segment = (int) best;
+	match.distanceMiles = 2 * asin (min (1.0, sqrt (max (0.0, best2)) / 2)) * MapObject::EARTH_RADIUS;
+
+	return true;
+}
+
+void SegmentIndex::nearest (const vector<pair<double,double> > & points, const double maxMiles,
+				Match * output, const int threads) const
+{
+	Parallel::forEachPart ((long) points.size(), Parallel::threadCount (threads), [&] (int, long begin, long end)
+	{
+		for (long i = begin; i < end; i++)
+		{
+			nearest (MapObject (TLatLong (points[i].second, points[i].first)), maxMiles, output[i]);
+		}
+	});
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+// segments which cross or touch.
+//////////////////////////////////////////////////////////////////////////////////////////
+
+// C (on the great circle of A and B, NORMAL) is between A and B, not at the ends.
+static bool between (const MapObject & c, const MapObject & a, const MapObject & b, const MapObject & normal)
+{
+	return MapObject::orientation (a, c, normal) > 0 && MapObject::orientation (c, b, normal) > 0;
+}
+
+bool SegmentIndex::intersect (const Segment & s, const Segment & t, const bool same, MapObject & point)
+{
+	bool next = same && s.line == t.line && (abs (s.order - t.order) == 1 || (s.order == 0 && t.closing) ||
+		(t.order == 0 && s.closing));
+
+	// segments next to each other meet in their common end, wrong only when the other ends
+	// are on the same great circle, one going back along the other.
+
+	if (next && (s.b == t.a || s.a == t.b))
+	{
+		const MapObject & u = (s.b == t.a) ? s.a : s.b;
+		const MapObject & w = (s.b == t.a) ? t.b : t.a;
+		const MapObject & v = (s.b == t.a) ? s.b : s.a;
+
+		if (u == w || (MapObject::orientation (u, v, w) == 0 && between (w, s.a, s.b, s.normal)))
+		{
+			point = w;
+			return true;
+		}
+
+		if (MapObject::orientation (u, v, w) == 0 && between (u, t.a, t.b, t.normal))
+		{
+			point = u;
+			return true;
+		}
+
+		return false;
+	}
+
+	if (s.a == t.a || s.a == t.b)
+	{
+		point = s.a;
+		return true;
+	}
+
+	if (s.b == t.a || s.b == t.b)
+	{
+		point = s.b;
+		return true;
+	}
+
+	// ends of each on different sides of the other (most pairs are not).
+
+	int c = MapObject::orientation (s.a, s.b, t.a);
+	int d = MapObject::orientation (s.a, s.b, t.b);
+
+	if (c == d && c != 0)
+	{
+		return false;
+	}
+
+	int a = MapObject::orientation (t.a, t.b, s.a);
+	int b = MapObject::orientation (t.a, t.b, s.b);
+
+	if (a == b && a != 0)
+	{
+		return false;
+	}
+
+	if (a != 0 && b != 0 && c != 0 && d != 0)
+	{
+		// and not where the great circles meet on the other side of the globe.
+
+		if (a != d)
+		{
+			return false;
+		}
+
+		point = MapObject::crossProduct (s.normal, t.normal);
+
+		if (dot (point, s.a) + dot (point, s.b) < 0)
+		{
+			point.invert();
+		}
+
+		return true;
+	}
+
+	// an end is on the other great circle (both when they are the same circle).
+
+	if (c == 0 && between (t.a, s.a, s.b, s.normal)) { point = t.a; return true; }
+	if (d == 0 && between (t.b, s.a, s.b, s.normal)) { point = t.b; return true; }
+	if (a == 0 && between (s.a, t.a, t.b, t.normal)) { point = s.a; return true; }
+	if (b == 0 && between (s.b, t.a, t.b, t.normal)) { point = s.b; return true; }
+
+	return false;
+}
+
+static bool overlap (const double * box, const double * other)
+{
+	for (int axis = 0; axis < 3; axis++)
+	{
+		if (box[axis] > other[axis + 3] || other[axis] > box[axis + 3]) return false;
+	}
+
+	return true;
+}
+
+void SegmentIndex::crossings (const SegmentIndex & other, const long i, const double * box, const long begin,
+				const long end, const long node, vector<Crossing> & output) const
+{
+	bool same = (&other == this);
+
+	// in the same index each pair once, from its lower segment.
+
+	if ((same && end - 1 <= i) || !overlap (box, &other.boxes[6 * node]))
+	{
+		return;
+	}
+
+	MapObject point (0, 0, 1);
+
+	auto consider = [&] (const long j)
+	{
+		if ((!same || j > i) && intersect (segments[i], other.segments[j], same, point))
+		{
+			output.push_back (Crossing ((int) i, (int) j, point));
+		}
+	};
+
+	if (end - begin <= LEAF_SIZE)
+	{
+		for (long j = begin; j < end; j++) consider (j);
+		return;
+	}
+
+	long middle = (begin + end) / 2;
+
+	consider (middle);
+
+	crossings (other, i, box, begin, middle, 2 * node + 1, output);
+	crossings (other, i, box, middle + 1, end, 2 * node + 2, output);
+}
+
+void SegmentIndex::crossings (const SegmentIndex & other, vector<Crossing> & output, const int threads) const
+{
+	int parts = Parallel::threadCount (threads);
+
+	vector <vector<Crossing> > found (parts);
+
+	if (other.segments.empty())
+	{
+		return;
+	}
+
+	Parallel::forEachPart ((long) segments.size(), parts, [&] (int part, long begin, long end)
+	{
+		double box[6];
+
+		for (long i = begin; i < end; i++)
+		{
+			const Segment & s = segments[i];
+
+			// box of the arc, as in build (a bit larger, so that boxes touching in a common
+			// point overlap after rounding).
+
+			double bulge = 1 - sqrt (max (0.0, (1 + dot (s.a, s.b)) / 2)) + 1e-12;
+
+			for (int axis = 0; axis < 3; axis++)
+			{
+				box[axis] = min (coord (s.a, axis), coord (s.b, axis)) - bulge;
+				box[axis + 3] = max (coord (s.a, axis), coord (s.b, axis)) + bulge;
+			}
+
+			crossings (other, i, box, 0, (long) other.segments.size(), 0, found[part]);
+		}
+	});
+
+	for (auto & part : found)
+	{
+		output.insert (output.end(), part.begin(), part.end());
+	}
+}
+
+void SegmentIndex::crossings (vector<Crossing> & output, const int threads) const
+{
+	size_t count = output.size();
+
+	crossings (*this, output, threads);
+
+	for (size_t k = count; k < output.size(); k++)
+	{
+		Crossing & c = output[k];
+
+		const Segment & s = segments[c.first];
+		const Segment & t = segments[c.second];
+
+		if (make_pair (t.line, t.index) < make_pair (s.line, s.index))
+		{
+			swap (c.first, c.second);
+		}
+	}
+
+	sort (output.begin() + count, output.end(), [this] (const Crossing & x, const Crossing & y)
+	{
+		const Segment & a = segments[x.first], & b = segments[x.second];
+		const Segment & c = segments[y.first], & d = segments[y.second];
+
+		return make_tuple (a.line, a.index, b.line, b.index) < make_tuple (c.line, c.index, d.line, d.index);
+	});
+}
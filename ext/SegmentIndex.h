@@ -0,0 +1,123 @@
+/* geojson, Copyright (c) 2013-2020 Yuriy Yakimenko
+ *
+ * Permission to use, copy, modify, distribute, and sell this software and its
+ * documentation for any purpose is hereby granted without fee, provided that
+ * the above copyright notice appear in all copies and that both that
+ * copyright notice and this permission notice appear in supporting
+ * documentation.  No representations are made about the suitability of this
+ * software for any purpose.  It is provided "as is" without express or
+ * implied warranty.
+ */
+
+#pragma once
+
+#include <vector>
+#include "MapObject.h"
+
+//////////////////////////////////////////////////////////////////////////////////////////
+// Segments of polylines (great circle arcs) and the nearest of them to a point, for
+// snapping many GPS fixes to lines at once, and all pairs of segments which intersect.
+//
+// Each segment keeps normal of its great circle, computed once. Point projects onto the
+// circle as its part perpendicular to the normal; when projection is between the ends,
+// cosine of the distance is length of that part, otherwise the nearer end is closest. So
+// no trigonometry and no allocation runs per segment (unlike MapObject::distanceToSegment).
+//
+// Segments are kept like points in KdTree: reordered so that every node is a range split at
+// its middle one (by centers, along axis of largest spread), children in heap order. Each
+// node has 3D box around its segments (arcs bulge out of their chords by at most
+// 1 - cos of half angle, box is grown by that), and subtrees whose box is farther than the
+// nearest segment found so far are skipped.
+//
+// Intersections: for each segment only subtrees whose box overlaps its own box are visited,
+// O(log n + k) for segments short compared to the whole. Crossing is decided by signs of
+// MapObject::orientation (exact, no acos), as in: ends of each segment are on different sides
+// of the other's great circle, and on the same side as needed to not meet at the antipode.
+//////////////////////////////////////////////////////////////////////////////////////////
+
+class SegmentIndex
+{
+public:
+	static const int LEAF_SIZE = 8;
+
+	struct Match
+	{
+		int segment;             // -1 when nothing is near enough.
+		double distanceMiles;
+		MapObject closest;
+
+		Match () : segment(-1), distanceMiles(0), closest(0, 0, 1) { }
+	};
+
+	struct Crossing
+	{
+		int first, second;       // segments, FIRST of lower line (or index in the same line).
+		MapObject point;
+
+		Crossing (const int f, const int s, const MapObject & p) : first(f), second(s), point(p) { }
+	};
+
+private:
+	struct Segment
+	{
+		MapObject a, b, normal;
+		int line, index;
+		int order;               // among segments of the line (repeated points have none).
+		bool closing;            // last segment of closed line, next to the first one.
+
+		Segment (const MapObject & a_, const MapObject & b_, const MapObject & n, const int l, const int i,
+			const int o) : a(a_), b(b_), normal(n), line(l), index(i), order(o), closing(false) { }
+	};
+
+	std::vector<Segment> segments;
+	std::vector<double> boxes;     // low x, y, z and high x, y, z of each node.
+
+	void build (std::vector<int> & order, const std::vector<double> & ends, const long begin, const long end,
+		const long node);
+
+	void nearest (const MapObject & p, const long begin, const long end, const long node,
+		const MapObject * skipA, const MapObject * skipB, double & best2, long & best, MapObject & closest) const;
+
+	bool nearest (const MapObject & p, const double maxMiles, const MapObject * skipA, const MapObject * skipB,
+		Match & match) const;
+
+	static bool intersect (const Segment & s, const Segment & t, const bool same, MapObject & point);
+
+	void crossings (const SegmentIndex & other, const long i, const double * box, const long begin,
+		const long end, const long node, std::vector<Crossing> & output) const;
+
+public:
+	// adds segments between consecutive POINTS of polyline number LINE. Polyline is closed
+	// when its last point is the first one.
+	void addPolyline (const int line, const std::vector<MapObject> & points);
+
+	// prepares index, after all polylines are added.
+	void build ();
+
+	size_t size () const { return segments.size(); }
+
+	// polyline of SEGMENT, and which segment of it it is (from 0).
+	int line (const int segment) const { return segments[segment].line; }
+	int index (const int segment) const { return segments[segment].index; }
+
+	// nearest segment to P not farther than MAXMILES (0 means any distance).
+	bool nearest (const MapObject & p, const double maxMiles, Match & match) const;
+
+	// the same, without segments from A to B (either way), or without all segments which end
+	// in A when B is null.
+	bool nearestOther (const MapObject & p, const double maxMiles, const MapObject & a, const MapObject * b,
+		Match & match) const;
+
+	// the same for each of POINTS <longitude,latitude>, on THREADS threads. OUTPUT must have
+	// room for all of them.
+	void nearest (const std::vector<std::pair<double,double> > & points, const double maxMiles,
+		Match * output, const int threads) const;
+
+	// all pairs of segments which cross or touch, with a common point, sorted by lines and
+	// indexes. Segments next to each other in a line are reported only when one goes back
+	// along the other.
+	void crossings (std::vector<Crossing> & output, const int threads) const;
+
+	// the same between segments of this index (FIRST) and of OTHER (SECOND), in no order.
+	void crossings (const SegmentIndex & other, std::vector<Crossing> & output, const int threads) const;
+};
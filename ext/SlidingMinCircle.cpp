@@ -0,0 +1,354 @@
+/* geojson, Copyright (c) 2013-2020 Yuriy Yakimenko
+ *
+ * Permission to use, copy, modify, distribute, and sell this software and its
+ * documentation for any purpose is hereby granted without fee, provided that
+ * the above copyright notice appear in all copies and that both that
+ * copyright notice and this permission notice appear in supporting
+ * documentation.  No representations are made about the suitability of this
+ * software for any purpose.  It is provided "as is" without express or 
+ * implied warranty.
+ */
+
+#include "SlidingMinCircle.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+SlidingMinCircle::SlidingMinCircle (const long count, const double seconds) :
+	frontCount(0), maxCount(count), maxSeconds(seconds), current (MapObject (0, 0, 1), 0), currentCos(1),
+	supportCount(0), nextSeq(0), recalculated(0), random(1)
+{
+}
+
+static const long BLOCK = 16;
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+bool SlidingMinCircle::contains (const MapObject & pt) const
+{
+	return pt.GetAngleCos (current.center) >= currentCos - 1e-12;
+}
+
+bool SlidingMinCircle::isSupport (const long seq) const
+{
+	for (int i = 0; i < supportCount; i++)
+	{
+		if (support[i] == seq) return true;
+	}
+
+	return false;
+}
+
+// circle around CENTER through support points A, B and C (B and C may be null).
+
+void SlidingMinCircle::setCircle (const MapObject & center, const Fix * a, const Fix * b, const Fix * c)
+{
+	const Fix * fixes[3] = { a, b, c };
+
+	current = Circle (center, 0);
+	currentCos = 1;
+	supportCount = 0;
+
+	for (auto fix : fixes)
+	{
+		if (!fix) continue;
+
+		double angleCos = fix->obj.GetAngleCos (center);
+
+		if (angleCos < currentCos)
+		{
+			currentCos = angleCos;
+			current.radius = center.GetAirDistance (fix->obj);
+		}
+
+		support[supportCount++] = fix->seq;
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+// hull of PTS in the plane touching the sphere at their center (great circles are lines
+// there, so it is the same from any center): monotone chain. Points on hull edges are kept,
+// so that rounding does not drop a real vertex; repeated ones are not. All points are kept
+// when they do not fit into hemisphere around their center.
+//////////////////////////////////////////////////////////////////////////////////////////
+
+void SlidingMinCircle::hull (vector<const Fix *> & pts, vector<Fix> & output)
+{
+	output.clear();
+
+	double cx = 0, cy = 0, cz = 0;
+
+	for (auto fix : pts)
+	{
+		cx += fix->obj.X(); cy += fix->obj.Y(); cz += fix->obj.Z();
+	}
+
+	double n = sqrt (cx * cx + cy * cy + cz * cz);
+
+	vector<pair<double,double> > xy;
+
+	if (n > 0)
+	{
+		MapObject center (cx / n, cy / n, cz / n);
+		MapObject axis = (fabs (center.Z()) < 0.9) ? MapObject (0, 0, 1) : MapObject (1, 0, 0);
+		MapObject u = MapObject::crossProduct (axis, center);
+		MapObject v = MapObject::crossProduct (center, u);
+
+		for (auto fix : pts)
+		{
+			double d = fix->obj.GetAngleCos (center);
+
+			if (d < 1e-6) break;
+
+			xy.push_back (make_pair (fix->obj.GetAngleCos (u) / d, fix->obj.GetAngleCos (v) / d));
+		}
+	}
+
+	if (xy.size() < pts.size())
+	{
+		for (auto fix : pts) output.push_back (*fix);
+		return;
+	}
+
+	vector<size_t> order (pts.size());
+
+	for (size_t i = 0; i < order.size(); i++) order[i] = i;
+
+	sort (order.begin(), order.end(), [&xy] (const size_t a, const size_t b) { return xy[a] < xy[b]; });
+
+	order.erase (unique (order.begin(), order.end(),
+		[&xy] (const size_t a, const size_t b) { return xy[a] == xy[b]; }), order.end());
+
+	auto cross = [&xy] (const size_t o, const size_t a, const size_t b)
+	{
+		return (xy[a].first - xy[o].first) * (xy[b].second - xy[o].second) -
+			(xy[a].second - xy[o].second) * (xy[b].first - xy[o].first);
+	};
+
+	vector<char> onHull (pts.size(), 0);
+	vector<size_t> chain;
+
+	// lower chain, then upper one (same with order reversed).
+
+	for (int pass = 0; pass < 2; pass++)
+	{
+		chain.clear();
+
+		for (size_t i : order)
+		{
+			while (chain.size() > 1 && cross (chain[chain.size() - 2], chain.back(), i) < 0)
+			{
+				chain.pop_back();
+			}
+
+			chain.push_back (i);
+		}
+
+		for (size_t i : chain) onHull[i] = 1;
+
+		reverse (order.begin(), order.end());
+	}
+
+	for (size_t i = 0; i < pts.size(); i++)
+	{
+		if (onHull[i]) output.push_back (*pts[i]);
+	}
+}
+
+// last BLOCK fixes of window make a block: pushed to back stack.
+
+void SlidingMinCircle::addBlock ()
+{
+	vector<const Fix *> pts;
+
+	for (size_t i = window.size() - BLOCK; i < window.size(); i++)
+	{
+		pts.push_back (&window[i]);
+	}
+
+	blocks.push_back (Block ());
+	blocks.back().first = window[window.size() - BLOCK].seq;
+
+	hull (pts, blocks.back().hull);
+
+	pts.clear();
+
+	for (auto & fix : blocks.back().hull) pts.push_back (&fix);
+	for (auto & fix : backHull) pts.push_back (&fix);
+
+	vector<Fix> merged;
+
+	hull (pts, merged);
+
+	backHull.swap (merged);
+}
+
+// oldest block leaves the window: back stack is moved to front one first, when it is empty.
+
+void SlidingMinCircle::removeBlock ()
+{
+	if (frontCount == 0)
+	{
+		frontCount = blocks.size();
+
+		vector<const Fix *> pts;
+		vector<Fix> merged;
+
+		for (size_t i = frontCount - 1; i > 0; i--)
+		{
+			pts.clear();
+
+			for (auto & fix : blocks[i].hull) pts.push_back (&fix);
+			for (auto & fix : blocks[i - 1].hull) pts.push_back (&fix);
+
+			hull (pts, merged);
+
+			blocks[i - 1].hull.swap (merged);
+		}
+
+		backHull.clear();
+	}
+
+	blocks.pop_front();
+	frontCount--;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+// Welzl algorithm over the window (with FIXED on the circle, unless it is null): over hull
+// of whole blocks and all fixes before and after them.
+//////////////////////////////////////////////////////////////////////////////////////////
+
+void SlidingMinCircle::recalculate (const Fix * fixed)
+{
+	recalculated++;
+
+	long first = window.front().seq;
+	long wholeBegin = blocks.empty() ? nextSeq : blocks.front().first;
+	long wholeEnd = blocks.empty() ? nextSeq : blocks.back().first + BLOCK;
+
+	long fixedSeq = fixed ? fixed->seq : -1;
+
+	vector<const Fix *> pts;
+
+	for (long seq = first; seq < wholeBegin; seq++)
+	{
+		if (seq != fixedSeq) pts.push_back (&window[seq - first]);
+	}
+
+	if (frontCount > 0)
+	{
+		for (auto & fix : blocks.front().hull)
+		{
+			if (fix.seq != fixedSeq) pts.push_back (&fix);
+		}
+	}
+
+	for (auto & fix : backHull)
+	{
+		if (fix.seq != fixedSeq) pts.push_back (&fix);
+	}
+
+	for (long seq = wholeEnd; seq < nextSeq; seq++)
+	{
+		if (seq != fixedSeq) pts.push_back (&window[seq - first]);
+	}
+
+	if (pts.empty())
+	{
+		setCircle (fixed->obj, fixed, nullptr, nullptr);
+		return;
+	}
+
+	shuffle (pts.begin(), pts.end(), random);
+
+	if (fixed)
+	{
+		circleWith (pts, pts.size(), *fixed);
+		return;
+	}
+
+	setCircle (pts[0]->obj, pts[0], nullptr, nullptr);
+
+	for (size_t i = 1; i < pts.size(); i++)
+	{
+		if (!contains (pts[i]->obj))
+		{
+			circleWith (pts, i, *pts[i]);
+		}
+	}
+}
+
+// smallest circle of first COUNT points with Q on it.
+
+void SlidingMinCircle::circleWith (vector<const Fix *> & pts, const size_t count, const Fix & q)
+{
+	setCircle (q.obj, &q, nullptr, nullptr);
+
+	for (size_t j = 0; j < count; j++)
+	{
+		if (!contains (pts[j]->obj))
+		{
+			circleWith (pts, j, q, *pts[j]);
+		}
+	}
+}
+
+// smallest circle of first COUNT points with Q1 and Q2 on it.
+
+void SlidingMinCircle::circleWith (vector<const Fix *> & pts, const size_t count, const Fix & q1, const Fix & q2)
+{
+	setCircle (MapObject::midpoint (q1.obj, q2.obj), &q1, &q2, nullptr);
+
+	for (size_t k = 0; k < count; k++)
+	{
+		if (!contains (pts[k]->obj))
+		{
+			const Fix & p = *pts[k];
+
+			setCircle (GeoUtils::getEquidistantPoint (q1.obj, q2.obj, p.obj), &q1, &q2, &p);
+		}
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+void SlidingMinCircle::add (const MapObject & pt, const double time)
+{
+	window.emplace_back (pt, time, nextSeq++);
+
+	bool lostSupport = false;
+
+	while (window.size() > 1 &&
+		((maxCount > 0 && (long) window.size() > maxCount) ||
+		 (maxSeconds > 0 && window.front().time <= time - maxSeconds)))
+	{
+		if (isSupport (window.front().seq)) lostSupport = true;
+
+		window.pop_front();
+	}
+
+	while (!blocks.empty() && blocks.front().first < window.front().seq)
+	{
+		removeBlock();
+	}
+
+	if (nextSeq % BLOCK == 0 && (long) window.size() >= BLOCK)
+	{
+		addBlock();
+	}
+
+	if (window.size() == 1)
+	{
+		setCircle (pt, &window.back(), nullptr, nullptr);
+	}
+	else if (lostSupport)
+	{
+		recalculate (nullptr);
+	}
+	else if (!contains (pt))
+	{
+		recalculate (&window.back());
+	}
+}
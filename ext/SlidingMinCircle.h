@@ -0,0 +1,107 @@
+/* geojson, Copyright (c) 2013-2020 Yuriy Yakimenko
+ *
+ * Permission to use, copy, modify, distribute, and sell this software and its
+ * documentation for any purpose is hereby granted without fee, provided that
+ * the above copyright notice appear in all copies and that both that
+ * copyright notice and this permission notice appear in supporting
+ * documentation.  No representations are made about the suitability of this
+ * software for any purpose.  It is provided "as is" without express or 
+ * implied warranty.
+ */
+
+#pragma once
+
+#include <deque>
+#include <random>
+#include <vector>
+#include "MapObject.h"
+#include "GeoUtils.h"
+
+//////////////////////////////////////////////////////////////////////////////////////////
+// Minimum enclosing circle of the last fixes of one vehicle: last COUNT of them, or those
+// not older than SECONDS than the newest one.
+//
+// Circle is defined by two or three support points. While they stay in the window and new
+// fixes fall inside, nothing is recalculated. New fix outside of circle must be on the new
+// circle, so Welzl algorithm runs with it fixed; lost support point means Welzl run without
+// it. For points in random order either happens with probability about 3/N per fix, but a
+// moving vehicle leaves its circle on almost every fix.
+//
+// So Welzl does not run over the whole window, only over fixes which can be on the circle:
+// vertices of convex hull. Fixes are grouped in blocks of 16 (by arrival), and blocks which
+// are whole in the window make a queue of two stacks. Newer blocks are pushed to the back
+// stack, which keeps hull of all of them. When the oldest block leaves and the front stack
+// is empty, back stack is moved to it, and every block there gets hull of itself and all
+// newer blocks of the front stack. Hull of all whole blocks is then in two hulls: of the
+// oldest block (front stack) and of the back stack. Welzl runs over these and fixes of the
+// partial blocks at both ends, O(h) for hulls of h vertices (small for tracks), and each
+// block is merged into hulls twice, so update is O(h log h) amortized instead of O(N).
+//////////////////////////////////////////////////////////////////////////////////////////
+
+class SlidingMinCircle
+{
+private:
+	struct Fix
+	{
+		MapObject obj;
+		double time;
+		long seq;
+
+		Fix (const MapObject & o, const double t, const long s) : obj(o), time(t), seq(s) { }
+	};
+
+	// hull vertices of fixes FIRST to FIRST + BLOCK - 1 (in front stack, of them and of all
+	// newer blocks of the stack).
+	struct Block
+	{
+		long first;
+		std::vector<Fix> hull;
+	};
+
+	std::deque<Fix> window;
+	std::deque<Block> blocks;   // whole blocks in window, oldest first.
+	size_t frontCount;          // blocks in front stack (first of them).
+	std::vector<Fix> backHull;  // hull of blocks in back stack.
+
+	long maxCount;
+	double maxSeconds;
+
+	Circle current;
+	double currentCos;   // cosine of radius angle, for containment test.
+	long support[3];     // seq of support points.
+	int supportCount;
+
+	long nextSeq;
+	long recalculated;
+
+	std::mt19937 random;
+
+	bool contains (const MapObject & pt) const;
+	bool isSupport (const long seq) const;
+
+	void setCircle (const MapObject & center, const Fix * a, const Fix * b, const Fix * c);
+
+	static void hull (std::vector<const Fix *> & pts, std::vector<Fix> & output);
+
+	void addBlock ();
+	void removeBlock ();
+
+	void recalculate (const Fix * fixed);
+	void circleWith (std::vector<const Fix *> & pts, const size_t count, const Fix & q);
+	void circleWith (std::vector<const Fix *> & pts, const size_t count, const Fix & q1, const Fix & q2);
+
+public:
+	// COUNT or SECONDS (the other one is 0) sets the window.
+	SlidingMinCircle (const long count, const double seconds = 0);
+
+	// TIME (in seconds) must not decrease, it is only used for time window.
+	void add (const MapObject & pt, const double time = 0);
+
+	// circle of fixes in window (radius in miles).
+	const Circle & circle () const { return current; }
+
+	size_t size () const { return window.size(); }
+
+	// number of times Welzl algorithm had to run.
+	long recalculatedCount () const { return recalculated; }
+};
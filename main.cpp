@@ -12,8 +12,24 @@
 #include <vector>
 #include "ext/GeoUtils.h"
 #include "ext/LatLong.h"
-
+#include "ext/CoordinateStream.h"
+#include "ext/DynamicCoverage.h"
+#include "ext/Parallel.h"
+#include "ext/SlidingMinCircle.h"
+#include "ext/Delaunay.h"
+#include "ext/KdTree.h"
+#include "ext/IndexFile.h"
+#include "ext/ConvexPolygon.h"
+#include "ext/GeofenceIndex.h"
+#include "ext/SegmentIndex.h"
+#include "ext/Corridor.h"
+#include "ext/GeoJsonReader.h"
+#include "ext/Overlay.h"
+
+#include <algorithm>
 #include <chrono>
+#include <thread>
+#include <unordered_map>
 
 using namespace std;
 
@@ -56,6 +72,38 @@ bool getCoordinatesFromFile(const char *filename, vector<pair<double, double>> &
 	return true;
 }
 
+/////////////////////////////////////////////////////////////////////////////////////
+// same, with optional third column: radius in km around the point (0 when missing).
+/////////////////////////////////////////////////////////////////////////////////////
+bool getCoordinatesFromFile(const char *filename, vector<pair<double, double>> & data,
+				vector<double> & radiiKM)
+{
+	FILE * input = fopen (filename, "r+t");
+
+	if (!input)
+		return false;
+
+	char buffer[256];
+
+	while (fgets (buffer, 256, input))
+	{
+		if (buffer[0] == '#') continue;
+
+		double longitude = 0, latitude = 0, radius = 0;
+
+		int ret = sscanf (buffer, "%lf,%lf,%lf", &longitude, &latitude, &radius);
+
+		if (ret >= 2 && (longitude != 0 || latitude != 0))
+		{
+			data.push_back(make_pair(longitude, latitude));
+			radiiKM.push_back ((ret == 3 && radius > 0) ? radius : 0);
+		}
+	}
+
+	fclose (input);
+	return true;
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////
 
 bool createOutput (const char *filename, vector<pair<double, double>> & data)
@@ -91,230 +139,3182 @@ bool createOutput (const char *filename, vector<pair<double, double>> & data)
 	return true;
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////
+// feature collection: one polygon per entry of POLYGONS, with PROPERTIES (json object
+// members, for example "\"radius_km\" : 50") of the same index.
 //////////////////////////////////////////////////////////////////////////////////////////
 
-int function_Area_And_MinCircle (char * argv[], int which)
+bool createCollectionOutput (const char *filename, vector<vector<pair<double, double>>> & polygons,
+                             vector<string> & properties)
 {
-	vector <pair<double,double> > input;
-	vector <pair<double,double> > output;
-
-	int vertCount = atoi (argv[3]);
+	FILE * output = fopen (filename, "w+t");
 
-	if (vertCount < 3)
+	if (!output)
 	{
-		printf ("Invalid vertex count. Must be integer greater than 2\n");
-		return -1;
+		fprintf (stderr, "Cannot open %s for writing\n", filename);
+		return false;
 	}
 
-	double radiusKM = -1;
-	
-	if (which == 0)
+	fprintf (output, "{ \"type\" : \"FeatureCollection\", \n");
+	fprintf (output, "\"features\" : [ \n");
+
+	for (size_t i=0; i < polygons.size(); i++)
 	{
-		radiusKM = atof (argv[4]);
+		if (i > 0) fprintf (output, ",\n");
+
+		fprintf (output, "{ \"type\" : \"Feature\", \"properties\" : { %s }, \n",
+			i < properties.size() ? properties[i].c_str() : "");
 
-		if (radiusKM <= 0)
+		fprintf (output, "\"geometry\" : { \"type\" : \"Polygon\", \"coordinates\" : [ \n");
+
+		fprintf (output, "[ \n");
+
+		bool first = true;
+		for (auto & pair : polygons[i])
 		{
-			printf ("Invalid radius\n");
-			return -1;
+			if (!first) fprintf(output, ",\n");
+			first = false;
+
+			fprintf (output, "[%.5lf, %.5lf]", pair.first, pair.second);
 		}
-	}
 
-	if (!getCoordinatesFromFile (argv[2], input))
-	{
-		fprintf (stderr, "Cannot open %s\n", argv[2]);
-		return -1;
+		fprintf (output, "\n ]] } }");
 	}
 
-	int ret = false;
+	fprintf (output, "\n]\n}");
 
-	char * outFile = nullptr;
+	fclose (output);
 
-	double radiusMiles = radiusKM * 1000.0 / MapObject::MILE_2_METERS;
+	return true;
+}
 
-	printf ("Input: %ld coordinates\n", input.size());
+//////////////////////////////////////////////////////////////////////////////////////////
+// multipolygon: each entry of POLYGONS is outer ring followed by its holes.
+//////////////////////////////////////////////////////////////////////////////////////////
 
-	if (input.size() == 0)
+bool createMultiPolygonOutput (const char *filename, vector<vector<vector<pair<double, double>>>> & polygons)
+{
+	FILE * output = fopen (filename, "w+t");
+
+	if (!output)
 	{
-		fprintf (stderr, "No valid coordinates found in %s\n", argv[2]);
-		return -1;
+		fprintf (stderr, "Cannot open %s for writing\n", filename);
+		return false;
 	}
-    else if (input.size() == 1)
-	{
-		TLatLong coord (input.front().second, input.front().first);
 
-		ret = GeoUtils::getPointsAroundCoordinate (coord, radiusMiles, vertCount, output);
-	}
-	else if (input.size() > 1)
+	fprintf (output, "{ \"type\" : \"MultiPolygon\", \n");
+	fprintf (output, "\"coordinates\" : [ \n");
+
+	for (size_t i=0; i < polygons.size(); i++)
 	{
-		std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+		if (i > 0) fprintf (output, ",\n");
+
+		fprintf (output, "[ ");
 
-		if (which == 0)
+		for (size_t r=0; r < polygons[i].size(); r++)
 		{
-			outFile = strdup ("area.geojson");
+			if (r > 0) fprintf (output, ",\n");
 
-			ret = GeoUtils::getConvexHull(input, output, radiusMiles, vertCount);
+			fprintf (output, "[ \n");
 
-			auto end = std::chrono::high_resolution_clock::now();
-        	auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);        
+			bool first = true;
+			for (auto & pair : polygons[i][r])
+			{
+				if (!first) fprintf(output, ",\n");
+				first = false;
 
+				fprintf (output, "[%.5lf, %.5lf]", pair.first, pair.second);
+			}
 
-			printf ("area completed in %ld ms\n", duration.count());
+			fprintf (output, "\n ]");
 		}
-		else 
-		{
-			outFile = strdup ("mincircle.geojson");
 
-			double outRadiusMiles;
-			TLatLong coord = GeoUtils::mincircle (input, outRadiusMiles);
+		fprintf (output, " ]");
+	}
+
+	fprintf (output, "\n]\n}");
 
-			printf ("MinCircle (%lf %lf) Radius: %lf miles\n", coord.Latitude(), coord.Longitude(), outRadiusMiles );
+	fclose (output);
 
-			ret = GeoUtils::getPointsAroundCoordinate (coord, outRadiusMiles, vertCount, output);
+	return true;
+}
 
-			auto end = std::chrono::high_resolution_clock::now();
-        	auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);        
+//////////////////////////////////////////////////////////////////////////////////////////
+// writes coordinates in the format getCoordinatesFromFile reads, with as many digits as
+// needed to read exactly the same values back.
+//////////////////////////////////////////////////////////////////////////////////////////
 
-			printf ("mincircle completed in %ld ms\n", duration.count());
-		}
+static void printExact (FILE * output, const double value)
+{
+	char buffer[32];
+
+	snprintf (buffer, sizeof(buffer), "%.15g", value);
+
+	if (strtod (buffer, nullptr) != value)
+	{
+		snprintf (buffer, sizeof(buffer), "%.17g", value);
 	}
 
-	if (ret)
+	fputs (buffer, output);
+}
+
+bool createCoordinatesFile (const char *filename, vector<pair<double, double>> & data)
+{
+	FILE * output = fopen (filename, "w+t");
+
+	if (!output)
 	{
-		if (createOutput (outFile, output))
-		{
-			printf ("Successfully created %s with %ld coordinates\n", outFile, output.size());
-		}
+		fprintf (stderr, "Cannot open %s for writing\n", filename);
+		return false;
 	}
 
-	free (outFile);
+	fprintf (output, "#longitude,latitude\n");
 
-	return 0;
+	for (auto & pair : data)
+	{
+		printExact (output, pair.first);
+		fputc (',', output);
+		printExact (output, pair.second);
+		fputc ('\n', output);
+	}
+
+	fclose (output);
+
+	return true;
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////
+// removes "--name value" pair from argument list. Returns value or nullptr when option
+// is not present.
 //////////////////////////////////////////////////////////////////////////////////////////
 
-int function_Equidistant (char * argv[])
+const char * takeOption (int & argc, char * argv[], const char * name)
 {
-	vector <pair<double,double> > input;
-	vector <pair<double,double> > output;
+	for (int i=1; i < argc - 1; i++)
+	{
+		if (strcmp (argv[i], name) == 0)
+		{
+			const char * value = argv[i + 1];
 
-	int vertCount = atoi (argv[3]);
+			for (int j = i; j + 2 <= argc; j++)
+			{
+				argv[j] = argv[j + 2];
+			}
 
-	if (vertCount < 3)
-	{
-		printf ("Invalid vertex count. Must be integer greater than 2\n");
-		return -1;
-	}
+			argc -= 2;
 
-	if (!getCoordinatesFromFile (argv[2], input))
-	{
-		fprintf (stderr, "Cannot open %s\n", argv[2]);
-		return -1;
+			return value;
+		}
 	}
 
-	if (input.size() < 3)
+	return nullptr;
+}
+
+// same for options without value.
+
+bool takeFlag (int & argc, char * argv[], const char * name)
+{
+	for (int i=1; i < argc; i++)
 	{
-		fprintf (stderr, "Fewer than 3 coordinates in %s\n", argv[2]);
-		return -1;
+		if (strcmp (argv[i], name) == 0)
+		{
+			for (int j = i; j + 1 <= argc; j++)
+			{
+				argv[j] = argv[j + 1];
+			}
+
+			argc--;
+
+			return true;
+		}
 	}
 
-	TLatLong pt1 (input[0].second, input[0].first);
-	TLatLong pt2 (input[1].second, input[1].first);
-	TLatLong pt3 (input[2].second, input[2].first);
+	return false;
+}
 
-	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+//////////////////////////////////////////////////////////////////////////////////////////
+// vertex counts and radii for area: one value or comma separated list of values,
+// for example 12,24 and 5,10,25,50.
+//////////////////////////////////////////////////////////////////////////////////////////
 
-    TLatLong pt = GeoUtils::getEquidistantPoint (pt1, pt2, pt3).GetLatLong();
+static bool parseVertexCounts (const char * arg, vector<int> & vertCounts)
+{
+	const char * ptr = arg;
 
-	auto end = std::chrono::high_resolution_clock::now();
-        	auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);        
+	while (*ptr)
+	{
+		char * end;
+		long value = strtol (ptr, &end, 10);
 
-	printf ("eqdist completed in %ld ms\n", duration.count());
+		if (end == ptr || value < 3 || (*end != ',' && *end != 0))
+		{
+			printf ("Invalid vertex count. Must be integer greater than 2\n");
+			return false;
+		}
 
-    printf ("EQD %lf %lf\n", pt.Latitude(), pt.Longitude());
+		vertCounts.push_back ((int) value);
+		ptr = (*end == ',') ? end + 1 : end;
+	}
 
-	printf ("%lf %lf %lf\n", TLatLong::AirDistance (pt, pt1),
-				TLatLong::AirDistance(pt, pt2), TLatLong::AirDistance(pt, pt3));
+	return !vertCounts.empty();
+}
 
-	double distMiles = TLatLong::AirDistance (pt, pt1);
-	int ret = GeoUtils::getPointsAroundCoordinate (pt, distMiles, vertCount, output);
+static bool parseRadii (const char * arg, vector<double> & radiiKM)
+{
+	const char * ptr = arg;
 
-	if (ret)
+	while (*ptr)
 	{
-		const char outFile[] = "circle.geojson";
-		if (createOutput (outFile, output))
+		char * end;
+		double value = strtod (ptr, &end);
+
+		if (end == ptr || value <= 0 || (*end != ',' && *end != 0))
 		{
-			printf ("Successfully created %s with %ld coordinates\n", outFile, output.size());
+			printf ("Invalid radius\n");
+			return false;
 		}
+
+		radiiKM.push_back (value);
+		ptr = (*end == ',') ? end + 1 : end;
 	}
 
-	return 0;
+	return !radiiKM.empty();
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////
-//
-//  Syntax:
-//
-//  (A) ./geojson area input.csv 12 50 
-//
-//  where input.csv is CSV file with longitude,latitude on each line.
-//  outputs output.geojson which can be visualized for example on www.geojson.io or similar sites.
-//  50 is distance in kilometers. The resulting output polygon will cover all coordinates and area
-//  around them within specified distance.
-//  12 is number of vertices to create around each input coordinate. The greater, the "rounder"
-//  will be output, at the expense of performance.
-//
-//  (B) ./geojson eqdist input.csv 12
-//
-//  (C) ./geojson mincircle input.csv 12
-//
-///////////////////////////////////////////////////////////////////////////////////////////
+// "--metrics": area and perimeter of every area polygon are added to its properties, and with
+// "--metrics-points file" also how many points of that file are inside of it.
+//////////////////////////////////////////////////////////////////////////////////////////
 
-int main(int argc, char *argv[] )
+struct AreaMetrics
 {
-	vector <pair<double,double> > input;
-	vector <pair<double,double> > output;
+	bool enabled;
+	const char * points;
+	int threads;
+	long blockSize;
 
-	int function = -1;
+	AreaMetrics () : enabled(false), points(nullptr), threads(1), blockSize(1 << 20) { }
+};
 
+static bool writeAreaPolygons (vector<vector<pair<double,double> > > & polygons,
+                        vector<string> & properties, const char * name,
+                        const std::chrono::high_resolution_clock::time_point & start,
+                        const AreaMetrics & metrics);
 
-	if (argc > 1)
+//////////////////////////////////////////////////////////////////////////////////////////
+// buffers HULL (from GeoUtils::getHullVertices, or single point) for every combination of
+// vertex count and radius and writes area.geojson: a polygon when there is one combination,
+// feature collection otherwise. The hull itself does not depend on them and is found once.
+//////////////////////////////////////////////////////////////////////////////////////////
+
+static bool writeAreas (const vector<pair<double,double> > & hull, const vector<int> & vertCounts,
+                        const vector<double> & radiiKM, const char * name,
+                        const std::chrono::high_resolution_clock::time_point & start,
+                        const AreaMetrics & metrics)
+{
+	vector<vector<pair<double,double> > > polygons;
+	vector<string> properties;
+
+	for (double radiusKM : radiiKM)
 	{
-		if (strcmp (argv[1], "area") == 0)
+		double radiusMiles = radiusKM * 1000.0 / MapObject::MILE_2_METERS;
+
+		for (int vertCount : vertCounts)
 		{
-			function = 0;
+			vector <pair<double,double> > output;
+
+			bool ret = false;
+
+			if (hull.size() == 1)
+			{
+				TLatLong coord (hull.front().second, hull.front().first);
+
+				ret = GeoUtils::getPointsAroundCoordinate (coord, radiusMiles, vertCount, output);
+			}
+			else if (hull.size() > 1)
+			{
+				ret = GeoUtils::bufferHull (hull, output, radiusMiles, vertCount);
+			}
+
+			if (!ret)
+			{
+				return false;
+			}
+
+			char buffer[80];
+			snprintf (buffer, sizeof(buffer), "\"radius_km\" : %g, \"vertices\" : %d", radiusKM, vertCount);
+
+			polygons.push_back (output);
+			properties.push_back (buffer);
 		}
-		else if (strcmp (argv[1], "mincircle") == 0)
+	}
+
+	return writeAreaPolygons (polygons, properties, name, start, metrics);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+// same for input with radius of each point (0 when missing: RADIIKM is used for them).
+// Hull of circles depends on the radius, so it is found for every combination.
+//////////////////////////////////////////////////////////////////////////////////////////
+
+static bool writeAreas (const vector<pair<double,double> > & input, const vector<double> & pointRadiiKM,
+                        const vector<int> & vertCounts, const vector<double> & radiiKM,
+                        const char * name, const std::chrono::high_resolution_clock::time_point & start,
+                        const AreaMetrics & metrics)
+{
+	vector<vector<pair<double,double> > > polygons;
+	vector<string> properties;
+
+	for (double radiusKM : radiiKM)
+	{
+		vector<double> radiiMiles;
+
+		for (double pointRadiusKM : pointRadiiKM)
 		{
-			function = 1;
-		} 
-		else if (strcmp (argv[1], "eqdist") == 0)
+			radiiMiles.push_back ((pointRadiusKM > 0 ? pointRadiusKM : radiusKM) * 1000.0 / MapObject::MILE_2_METERS);
+		}
+
+		for (int vertCount : vertCounts)
 		{
-			function = 2;
+			vector <pair<double,double> > output;
+
+			if (!GeoUtils::getConvexHull (input, radiiMiles, output, vertCount))
+			{
+				return false;
+			}
+
+			char buffer[80];
+			snprintf (buffer, sizeof(buffer), "\"radius_km\" : %g, \"vertices\" : %d", radiusKM, vertCount);
+
+			polygons.push_back (output);
+			properties.push_back (buffer);
 		}
 	}
 
-	if (function < 0)
-	{
-		printf ("expected arguments: area | mincircle | eqdist\n" );
-		return EXIT_SUCCESS;
-	}
+	return writeAreaPolygons (polygons, properties, name, start, metrics);
+}
 
-	if (function == 0 && argc < 5)
+//////////////////////////////////////////////////////////////////////////////////////////
+// adds metrics to PROPERTIES of POLYGONS, before they are written. Area is spherical excess
+// (not area of the polygon projected to a plane), points file is read in blocks, and each
+// block tested against every polygon (area polygons are convex, see ConvexPolygon).
+//////////////////////////////////////////////////////////////////////////////////////////
+
+static bool addAreaMetrics (const vector<vector<pair<double,double> > > & polygons,
+                        vector<string> & properties, const AreaMetrics & metrics)
+{
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+
+	vector<vector<MapObject> > rings (polygons.size());
+
+	for (size_t i = 0; i < polygons.size(); i++)
 	{
-		printf ("Arguments: input (csv file), vertices count (greater than 2), radius in km\n");
-		printf ("For example:\n");
-		printf ("%s area input.csv 12 50\n", argv[0]);
-		return EXIT_SUCCESS;
+		for (auto & pt : polygons[i])
+		{
+			rings[i].push_back (MapObject (TLatLong (pt.second, pt.first)));
+		}
 	}
 
-	if (function == 1 && argc < 4)
+	vector<long> inside (polygons.size(), 0);
+	long count = 0;
+
+	if (metrics.points)
 	{
-		printf ("Arguments: input (csv file), vertices count (greater than 2)\n");
-		printf ("For example:\n");
-		printf ("%s mincircle input.csv 12\n", argv[0]);
-		return EXIT_SUCCESS;
-	}
+		vector<ConvexPolygon> convex (polygons.size());
+
+		for (size_t i = 0; i < rings.size(); i++)
+		{
+			if (!convex[i].build (rings[i]))
+			{
+				fprintf (stderr, "Cannot count points in polygon %ld: it is not convex\n", (long) i);
+				return false;
+			}
+		}
+
+		CoordinateStream stream;
+
+		if (!stream.open (metrics.points))
+		{
+			fprintf (stderr, "Cannot open %s\n", metrics.points);
+			return false;
+		}
+
+		vector <pair<double,double> > block;
+		vector <char> flags;
+
+		block.reserve (metrics.blockSize);
+
+		while (stream.readBlock (block, metrics.blockSize))
+		{
+			for (size_t i = 0; i < convex.size(); i++)
+			{
+				convex[i].contains (block, flags, metrics.threads);
+
+				inside[i] += std::count (flags.begin(), flags.end(), 1);
+			}
+
+			count += block.size();
+
+			block.clear();
+		}
+	}
+
+	properties.resize (polygons.size());
+
+	for (size_t i = 0; i < rings.size(); i++)
+	{
+		double areaKM2 = fabs (GeoUtils::sphericalArea (rings[i])) * MapObject::MILE_2_METERS * MapObject::MILE_2_METERS / 1e6;
+		double perimeterKM = GeoUtils::ringLength (rings[i]) * MapObject::MILE_2_METERS / 1000.0;
+
+		char buffer[160];
+		int length = snprintf (buffer, sizeof(buffer), "%s\"area_km2\" : %.3lf, \"perimeter_km\" : %.3lf",
+			properties[i].empty() ? "" : ", ", areaKM2, perimeterKM);
+
+		printf ("Polygon %ld: %.3lf km2, perimeter %.3lf km", (long) i, areaKM2, perimeterKM);
+
+		if (metrics.points)
+		{
+			snprintf (buffer + length, sizeof(buffer) - length, ", \"points_inside\" : %ld, \"coverage\" : %.6lf",
+				inside[i], count > 0 ? (double) inside[i] / count : 0.0);
+
+			printf (", %ld of %ld points inside", inside[i], count);
+		}
+
+		printf ("\n");
+
+		properties[i] += buffer;
+	}
+
+	auto end = std::chrono::high_resolution_clock::now();
+
+	printf ("metrics completed in %ld ms\n",
+		(long) std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count());
+
+	return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+// writes area.geojson: polygon when there is one (and no metrics, which need properties),
+// feature collection otherwise.
+//////////////////////////////////////////////////////////////////////////////////////////
+
+static bool writeAreaPolygons (vector<vector<pair<double,double> > > & polygons,
+                        vector<string> & properties, const char * name,
+                        const std::chrono::high_resolution_clock::time_point & start,
+                        const AreaMetrics & metrics)
+{
+	auto end = std::chrono::high_resolution_clock::now();
+	auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
+
+	printf ("%s completed in %ld ms\n", name, duration.count());
+
+	if (metrics.enabled && !addAreaMetrics (polygons, properties, metrics))
+	{
+		return false;
+	}
+
+	const char outFile[] = "area.geojson";
+
+	if (polygons.size() == 1 && !metrics.enabled)
+	{
+		if (createOutput (outFile, polygons.front()))
+		{
+			printf ("Successfully created %s with %ld coordinates\n", outFile, polygons.front().size());
+		}
+	}
+	else if (createCollectionOutput (outFile, polygons, properties))
+	{
+		printf ("Successfully created %s with %ld polygons\n", outFile, polygons.size());
+	}
+
+	return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+int function_Area_And_MinCircle (char * argv[], int which, int threads, const Deadline & deadline,
+                                 const AreaMetrics & metrics)
+{
+	vector <pair<double,double> > input;
+	vector <pair<double,double> > output;
+	vector <int> vertCounts;
+	vector <double> radiiKM;
+	vector <double> pointRadiiKM;
+
+	if (!parseVertexCounts (argv[3], vertCounts))
+	{
+		return -1;
+	}
+
+	int vertCount = vertCounts.front();
+
+	if (which == 0 && !parseRadii (argv[4], radiiKM))
+	{
+		return -1;
+	}
+
+	if (!getCoordinatesFromFile (argv[2], input, pointRadiiKM))
+	{
+		fprintf (stderr, "Cannot open %s\n", argv[2]);
+		return -1;
+	}
+
+	int ret = false;
+
+	char * outFile = nullptr;
+
+	printf ("Input: %ld coordinates\n", input.size());
+
+	if (input.size() == 0)
+	{
+		fprintf (stderr, "No valid coordinates found in %s\n", argv[2]);
+		return -1;
+	}
+
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+
+	if (which == 0)
+	{
+		vector <pair<double,double> > hull;
+
+		double errorMiles = 0;
+
+		if (*max_element (pointRadiiKM.begin(), pointRadiiKM.end()) > 0)
+		{
+			return writeAreas (input, pointRadiiKM, vertCounts, radiiKM, "area", start, metrics) ? 0 : -1;
+		}
+
+		if (input.size() == 1)
+		{
+			hull = input;
+		}
+		else if (!GeoUtils::getHullVertices (input, hull, deadline, errorMiles, threads))
+		{
+			return 0;
+		}
+
+		if (deadline.isActive())
+		{
+			printf ("Area may extend up to %lf km beyond exact area\n", errorMiles * MapObject::MILE_2_METERS / 1000.0);
+		}
+
+		return writeAreas (hull, vertCounts, radiiKM, "area", start, metrics) ? 0 : -1;
+	}
+	else if (*max_element (pointRadiiKM.begin(), pointRadiiKM.end()) > 0)
+	{
+		// third column: min circle of circles around the points.
+
+		outFile = strdup ("mincircle.geojson");
+
+		vector <Circle> circles;
+
+		for (size_t i = 0; i < input.size(); i++)
+		{
+			circles.push_back (Circle (input[i].second, input[i].first, pointRadiiKM[i] * 1000.0 / MapObject::MILE_2_METERS));
+		}
+
+		Circle circle = GeoUtils::mincircle (circles);
+		TLatLong coord = circle.center.GetLatLong();
+
+		printf ("MinCircle of circles (%lf %lf) Radius: %lf miles\n", coord.Latitude(), coord.Longitude(), circle.radius);
+
+		ret = GeoUtils::getPointsAroundCoordinate (coord, circle.radius, vertCount, output);
+
+		auto end = std::chrono::high_resolution_clock::now();
+		auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
+
+		printf ("mincircle completed in %ld ms\n", duration.count());
+	}
+	else if (input.size() == 1)
+	{
+		TLatLong coord (input.front().second, input.front().first);
+
+		ret = GeoUtils::getPointsAroundCoordinate (coord, -1, vertCount, output);
+	}
+	else if (input.size() > 1)
+	{
+		outFile = strdup ("mincircle.geojson");
+
+		double outRadiusMiles, errorMiles;
+		TLatLong coord = GeoUtils::mincircle (input, outRadiusMiles, deadline, errorMiles);
+
+		printf ("MinCircle (%lf %lf) Radius: %lf miles\n", coord.Latitude(), coord.Longitude(), outRadiusMiles );
+
+		if (deadline.isActive())
+		{
+			printf ("Radius may be up to %lf miles larger than minimal\n", errorMiles);
+		}
+
+		ret = GeoUtils::getPointsAroundCoordinate (coord, outRadiusMiles, vertCount, output);
+
+		auto end = std::chrono::high_resolution_clock::now();
+		auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
+
+		printf ("mincircle completed in %ld ms\n", duration.count());
+	}
+
+	if (ret && outFile)
+	{
+		if (createOutput (outFile, output))
+		{
+			printf ("Successfully created %s with %ld coordinates\n", outFile, output.size());
+		}
+	}
+
+	free (outFile);
+
+	return 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+// area for input which does not fit into memory (or comes from standard input, "-"): it is
+// read in blocks of BLOCKSIZE coordinates and only hull of what was read so far is kept.
+//////////////////////////////////////////////////////////////////////////////////////////
+
+int function_AreaStream (char * argv[], int threads, long blockSize, const AreaMetrics & metrics)
+{
+	vector <pair<double,double> > hull;
+	vector <pair<double,double> > block;
+	vector <int> vertCounts;
+	vector <double> radiiKM;
+
+	if (!parseVertexCounts (argv[3], vertCounts) || !parseRadii (argv[4], radiiKM))
+	{
+		return -1;
+	}
+
+	CoordinateStream stream;
+
+	if (!stream.open (argv[2]))
+	{
+		fprintf (stderr, "Cannot open %s\n", argv[2]);
+		return -1;
+	}
+
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+
+	long count = 0;
+
+	block.reserve (blockSize);
+
+	while (stream.readBlock (block, blockSize))
+	{
+		count += block.size();
+
+		if (!GeoUtils::addToHull (hull, block, threads))
+		{
+			fprintf (stderr, "Cannot find hull of %s\n", argv[2]);
+			return -1;
+		}
+
+		block.clear();
+	}
+
+	printf ("Input: %ld coordinates\n", count);
+
+	if (count == 0)
+	{
+		fprintf (stderr, "No valid coordinates found in %s\n", argv[2]);
+		return -1;
+	}
+
+	return writeAreas (hull, vertCounts, radiiKM, "area", start, metrics) ? 0 : -1;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+// outputs only vertices of the hull of one input file (shard). Result can be passed to
+// hull-merge together with hulls of other shards, or to area.
+//////////////////////////////////////////////////////////////////////////////////////////
+
+int function_Hull (int argc, char * argv[], int threads)
+{
+	vector <pair<double,double> > input;
+	vector <pair<double,double> > hull;
+
+	if (!getCoordinatesFromFile (argv[2], input))
+	{
+		fprintf (stderr, "Cannot open %s\n", argv[2]);
+		return -1;
+	}
+
+	printf ("Input: %ld coordinates\n", input.size());
+
+	if (input.size() == 0)
+	{
+		fprintf (stderr, "No valid coordinates found in %s\n", argv[2]);
+		return -1;
+	}
+	else if (input.size() <= 2)
+	{
+		hull = input;
+	}
+	else if (!GeoUtils::getHullVertices (input, hull, threads))
+	{
+		fprintf (stderr, "Cannot find hull of %s\n", argv[2]);
+		return -1;
+	}
+
+	const char * outFile = (argc > 3) ? argv[3] : "hull.csv";
+
+	if (createCoordinatesFile (outFile, hull))
+	{
+		printf ("Successfully created %s with %ld coordinates\n", outFile, hull.size());
+	}
+
+	return 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+// reads hulls of several shards (made by function_Hull) and creates area of all of them.
+//////////////////////////////////////////////////////////////////////////////////////////
+
+int function_HullMerge (int argc, char * argv[], int threads, const AreaMetrics & metrics)
+{
+	vector <pair<double,double> > input;
+	vector <pair<double,double> > hull;
+	vector <int> vertCounts;
+	vector <double> radiiKM;
+
+	if (!parseVertexCounts (argv[2], vertCounts) || !parseRadii (argv[3], radiiKM))
+	{
+		return -1;
+	}
+
+	for (int i = 4; i < argc; i++)
+	{
+		if (!getCoordinatesFromFile (argv[i], input))
+		{
+			fprintf (stderr, "Cannot open %s\n", argv[i]);
+			return -1;
+		}
+	}
+
+	printf ("Input: %ld coordinates from %d files\n", input.size(), argc - 4);
+
+	if (input.size() == 0)
+	{
+		fprintf (stderr, "No valid coordinates found\n");
+		return -1;
+	}
+
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+
+	if (input.size() == 1)
+	{
+		hull = input;
+	}
+	else if (!GeoUtils::getHullVertices (input, hull, threads))
+	{
+		return 0;
+	}
+
+	return writeAreas (hull, vertCounts, radiiKM, "hull-merge", start, metrics) ? 0 : -1;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+// area which follows changes of input points. CHANGES file (or "-" for standard input) has
+// lines "+longitude,latitude" to add point, "-longitude,latitude" to remove it and "=" to
+// write area.geojson for current points. It is also written at the end.
+//////////////////////////////////////////////////////////////////////////////////////////
+
+static bool writeCoverage (DynamicCoverage & coverage, const double radiusMiles, const int vertCount)
+{
+	vector <pair<double,double> > output;
+
+	if (!coverage.polygon (radiusMiles, vertCount, output))
+	{
+		fprintf (stderr, "No area for %ld points\n", coverage.size());
+		return false;
+	}
+
+	const char outFile[] = "area.geojson";
+
+	if (!createOutput (outFile, output))
+	{
+		return false;
+	}
+
+	printf ("Updated %s: %ld points, %ld hull vertices, %d recalculated\n", outFile,
+		coverage.size(), coverage.hullSize(), coverage.recalculatedCount());
+
+	return true;
+}
+
+int function_Coverage (char * argv[])
+{
+	vector <pair<double,double> > input;
+
+	int vertCount = atoi (argv[3]);
+
+	if (vertCount < 3)
+	{
+		printf ("Invalid vertex count. Must be integer greater than 2\n");
+		return -1;
+	}
+
+	double radiusKM = atof (argv[4]);
+
+	if (radiusKM <= 0)
+	{
+		printf ("Invalid radius\n");
+		return -1;
+	}
+
+	double radiusMiles = radiusKM * 1000.0 / MapObject::MILE_2_METERS;
+
+	if (!getCoordinatesFromFile (argv[2], input))
+	{
+		fprintf (stderr, "Cannot open %s\n", argv[2]);
+		return -1;
+	}
+
+	CoordinateStream changes;
+
+	if (!changes.open (argv[5]))
+	{
+		fprintf (stderr, "Cannot open %s\n", argv[5]);
+		return -1;
+	}
+
+	DynamicCoverage coverage;
+
+	coverage.build (input);
+
+	printf ("Input: %ld coordinates\n", input.size());
+
+	writeCoverage (coverage, radiusMiles, vertCount);
+
+	const char * line;
+	size_t length;
+	long count = 0;
+
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+
+	while (changes.nextLine (line, length))
+	{
+		double longitude, latitude;
+
+		if (line[0] == '=')
+		{
+			writeCoverage (coverage, radiusMiles, vertCount);
+		}
+		else if ((line[0] == '+' || line[0] == '-') && sscanf (line + 1, "%lf,%lf", &longitude, &latitude) == 2)
+		{
+			if (line[0] == '+')
+			{
+				coverage.insert (make_pair (longitude, latitude));
+			}
+			else if (!coverage.erase (make_pair (longitude, latitude)))
+			{
+				fprintf (stderr, "Not found: %s\n", line + 1);
+			}
+
+			count++;
+		}
+	}
+
+	auto end = std::chrono::high_resolution_clock::now();
+	auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
+
+	printf ("%ld changes completed in %ld ms\n", count, duration.count());
+
+	return writeCoverage (coverage, radiusMiles, vertCount) ? 0 : -1;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+int function_Equidistant (char * argv[])
+{
+	vector <pair<double,double> > input;
+	vector <pair<double,double> > output;
+
+	int vertCount = atoi (argv[3]);
+
+	if (vertCount < 3)
+	{
+		printf ("Invalid vertex count. Must be integer greater than 2\n");
+		return -1;
+	}
+
+	if (!getCoordinatesFromFile (argv[2], input))
+	{
+		fprintf (stderr, "Cannot open %s\n", argv[2]);
+		return -1;
+	}
+
+	if (input.size() < 3)
+	{
+		fprintf (stderr, "Fewer than 3 coordinates in %s\n", argv[2]);
+		return -1;
+	}
+
+	TLatLong pt1 (input[0].second, input[0].first);
+	TLatLong pt2 (input[1].second, input[1].first);
+	TLatLong pt3 (input[2].second, input[2].first);
+
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+
+    TLatLong pt = GeoUtils::getEquidistantPoint (pt1, pt2, pt3).GetLatLong();
+
+	auto end = std::chrono::high_resolution_clock::now();
+        	auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);        
+
+	printf ("eqdist completed in %ld ms\n", duration.count());
+
+    printf ("EQD %lf %lf\n", pt.Latitude(), pt.Longitude());
+
+	printf ("%lf %lf %lf\n", TLatLong::AirDistance (pt, pt1),
+				TLatLong::AirDistance(pt, pt2), TLatLong::AirDistance(pt, pt3));
+
+	double distMiles = TLatLong::AirDistance (pt, pt1);
+	int ret = GeoUtils::getPointsAroundCoordinate (pt, distMiles, vertCount, output);
+
+	if (ret)
+	{
+		const char outFile[] = "circle.geojson";
+		if (createOutput (outFile, output))
+		{
+			printf ("Successfully created %s with %ld coordinates\n", outFile, output.size());
+		}
+	}
+
+	return 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+// track: min circle of each vehicle's last fixes, after every fix. Input lines are
+// id,longitude,latitude[,time in seconds], window is count of fixes ("100") or
+// seconds ("600s", time column is then required). Output has line for every input
+// fix: id,longitude,latitude,radius in km of circle center. Vehicles are split
+// between threads.
+//////////////////////////////////////////////////////////////////////////////////////////
+
+struct TrackFix
+{
+	int vehicle;
+	double longitude, latitude, time;
+};
+
+int function_Track (int argc, char * argv[], int threads)
+{
+	char * end;
+	double window = strtod (argv[3], &end);
+
+	bool timeWindow = (*end == 's');
+
+	if (window <= 0 || (*end != 0 && !(timeWindow && end[1] == 0)) || (!timeWindow && window != (long) window))
+	{
+		printf ("Invalid window. Must be count of fixes, or seconds followed by s\n");
+		return -1;
+	}
+
+	FILE * input = fopen (argv[2], "rt");
+
+	if (!input)
+	{
+		fprintf (stderr, "Cannot open %s\n", argv[2]);
+		return -1;
+	}
+
+	vector <TrackFix> fixes;
+	vector <string> ids;
+	unordered_map <string, int> vehicles;
+
+	char buffer[256];
+	long line = 0;
+
+	while (fgets (buffer, sizeof(buffer), input))
+	{
+		line++;
+
+		if (buffer[0] == '#' || buffer[0] == '\n' || buffer[0] == '\r') continue;
+
+		char id[64];
+		TrackFix fix;
+		fix.time = 0;
+
+		int ret = sscanf (buffer, "%63[^,],%lf,%lf,%lf", id, &fix.longitude, &fix.latitude, &fix.time);
+
+		if (ret < 3 || (timeWindow && ret < 4))
+		{
+			fprintf (stderr, "Invalid line %ld in %s\n", line, argv[2]);
+			fclose (input);
+			return -1;
+		}
+
+		auto it = vehicles.find (id);
+
+		if (it == vehicles.end())
+		{
+			it = vehicles.insert (make_pair (string (id), (int) ids.size())).first;
+			ids.push_back (id);
+		}
+
+		fix.vehicle = it->second;
+
+		fixes.push_back (fix);
+	}
+
+	fclose (input);
+
+	printf ("Input: %ld fixes of %ld vehicles\n", fixes.size(), ids.size());
+
+	if (fixes.empty())
+	{
+		fprintf (stderr, "No valid fixes found in %s\n", argv[2]);
+		return -1;
+	}
+
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+
+	// fixes of each vehicle, in input order.
+
+	vector <vector<long> > fixesOf (ids.size());
+
+	for (size_t i = 0; i < fixes.size(); i++)
+	{
+		fixesOf[fixes[i].vehicle].push_back (i);
+	}
+
+	vector <pair<double,double> > centers (fixes.size());
+	vector <double> radii (fixes.size());
+	vector <long> recalculated (ids.size());
+
+	int parts = Parallel::threadCount (threads);
+
+	Parallel::forEachPart ((long) ids.size(), parts, [&] (int, long begin, long end)
+	{
+		for (long vehicle = begin; vehicle < end; vehicle++)
+		{
+			SlidingMinCircle circle (timeWindow ? 0 : (long) window, timeWindow ? window : 0);
+
+			for (long i : fixesOf[vehicle])
+			{
+				circle.add (MapObject (TLatLong (fixes[i].latitude, fixes[i].longitude)), fixes[i].time);
+
+				TLatLong center = circle.circle().center.GetLatLong();
+
+				centers[i] = make_pair (center.Longitude(), center.Latitude());
+				radii[i] = circle.circle().radius;
+			}
+
+			recalculated[vehicle] = circle.recalculatedCount();
+		}
+	});
+
+	auto finish = std::chrono::high_resolution_clock::now();
+	auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(finish - start);
+
+	long total = 0;
+
+	for (long count : recalculated) total += count;
+
+	printf ("track completed in %ld ms, circle recalculated %ld times\n", (long) duration.count(), total);
+
+	const char * outFile = (argc > 4) ? argv[4] : "track.csv";
+
+	FILE * output = fopen (outFile, "w+t");
+
+	if (!output)
+	{
+		fprintf (stderr, "Cannot open %s for writing\n", outFile);
+		return -1;
+	}
+
+	fprintf (output, "#id,longitude,latitude,radius_km\n");
+
+	for (size_t i = 0; i < fixes.size(); i++)
+	{
+		fprintf (output, "%s,%.6lf,%.6lf,%.4lf\n", ids[fixes[i].vehicle].c_str(), centers[i].first,
+			centers[i].second, radii[i] * MapObject::MILE_2_METERS / 1000.0);
+	}
+
+	fclose (output);
+
+	printf ("Successfully created %s with %ld circles\n", outFile, fixes.size());
+
+	return 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+// run: several operations on one input, like "area:50:12,mincircle:64,eqdist:12"
+// (area:radius km:vertices, mincircle:vertices, eqdist:vertices). Input is read and
+// converted to unit vectors once, then operations run on their own threads. Each one
+// writes the same file as its own subcommand would.
+//////////////////////////////////////////////////////////////////////////////////////////
+
+struct RunOperation
+{
+	int which; // 0 - area, 1 - mincircle, 2 - eqdist.
+	double radiusKM;
+	int vertCount;
+	bool ok;
+	char message[256];
+	vector <pair<double,double> > output;
+};
+
+static bool parseOperations (const char * arg, vector<RunOperation> & operations)
+{
+	string list (arg);
+	size_t begin = 0;
+
+	while (begin <= list.size())
+	{
+		size_t end = list.find (',', begin);
+		if (end == string::npos) end = list.size();
+
+		string item = list.substr (begin, end - begin);
+		begin = end + 1;
+
+		RunOperation op;
+		op.radiusKM = 0;
+		op.vertCount = 0;
+		op.ok = false;
+		op.message[0] = 0;
+
+		char name[16];
+		int consumed = 0;
+
+		if (sscanf (item.c_str(), "%15[a-z]%n", name, &consumed) != 1)
+		{
+			printf ("Invalid operation %s\n", item.c_str());
+			return false;
+		}
+
+		const char * params = item.c_str() + consumed;
+
+		if (strcmp (name, "area") == 0)
+		{
+			op.which = 0;
+			consumed = 0;
+			if (sscanf (params, ":%lf:%d%n", &op.radiusKM, &op.vertCount, &consumed) != 2 || params[consumed])
+			{
+				printf ("Invalid operation %s, expected area:radius:vertices\n", item.c_str());
+				return false;
+			}
+		}
+		else if (strcmp (name, "mincircle") == 0 || strcmp (name, "eqdist") == 0)
+		{
+			op.which = (name[0] == 'm') ? 1 : 2;
+			consumed = 0;
+			if (sscanf (params, ":%d%n", &op.vertCount, &consumed) != 1 || params[consumed])
+			{
+				printf ("Invalid operation %s, expected %s:vertices\n", item.c_str(), name);
+				return false;
+			}
+		}
+		else
+		{
+			printf ("Unknown operation %s\n", name);
+			return false;
+		}
+
+		if (op.vertCount < 3)
+		{
+			printf ("Invalid vertex count. Must be integer greater than 2\n");
+			return false;
+		}
+
+		if (op.which == 0 && op.radiusKM <= 0)
+		{
+			printf ("Invalid radius\n");
+			return false;
+		}
+
+		for (auto & other : operations)
+		{
+			if (other.which == op.which)
+			{
+				printf ("Operation %s is given more than once\n", name);
+				return false;
+			}
+		}
+
+		operations.push_back (op);
+	}
+
+	return true;
+}
+
+static void runOperation (RunOperation & op, const vector<pair<double,double> > & input,
+                          const vector<MapObject> & objects, int threads)
+{
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+
+	const char * name = "area";
+
+	if (op.which == 0)
+	{
+		double radiusMiles = op.radiusKM * 1000.0 / MapObject::MILE_2_METERS;
+
+		vector <pair<double,double> > hull;
+		vector <long> indexes;
+
+		if (input.size() == 1)
+		{
+			hull = input;
+		}
+		else if (GeoUtils::getHullIndexes (objects, indexes, threads))
+		{
+			for (long index : indexes)
+			{
+				hull.push_back (input[index]);
+			}
+		}
+		else if (!GeoUtils::getHullVertices (input, hull, threads))
+		{
+			return;
+		}
+
+		if (hull.size() == 1)
+		{
+			TLatLong coord (hull.front().second, hull.front().first);
+
+			op.ok = GeoUtils::getPointsAroundCoordinate (coord, radiusMiles, op.vertCount, op.output);
+		}
+		else
+		{
+			op.ok = GeoUtils::bufferHull (hull, op.output, radiusMiles, op.vertCount);
+		}
+	}
+	else if (op.which == 1)
+	{
+		name = "mincircle";
+
+		if (objects.size() == 1)
+		{
+			return;
+		}
+
+		double outRadiusMiles;
+		TLatLong coord = GeoUtils::mincircle (objects, outRadiusMiles);
+
+		snprintf (op.message, sizeof(op.message), "MinCircle (%lf %lf) Radius: %lf miles\n",
+			coord.Latitude(), coord.Longitude(), outRadiusMiles);
+
+		op.ok = GeoUtils::getPointsAroundCoordinate (coord, outRadiusMiles, op.vertCount, op.output);
+	}
+	else
+	{
+		name = "eqdist";
+
+		if (objects.size() < 3)
+		{
+			snprintf (op.message, sizeof(op.message), "Fewer than 3 coordinates for eqdist\n");
+			return;
+		}
+
+		MapObject center = GeoUtils::getEquidistantPoint (objects[0], objects[1], objects[2]);
+		TLatLong pt = center.GetLatLong();
+
+		snprintf (op.message, sizeof(op.message), "EQD %lf %lf\n%lf %lf %lf\n",
+			pt.Latitude(), pt.Longitude(), center.GetAirDistance (objects[0]),
+			center.GetAirDistance (objects[1]), center.GetAirDistance (objects[2]));
+
+		double distMiles = center.GetAirDistance (objects[0]);
+
+		op.ok = GeoUtils::getPointsAroundCoordinate (pt, distMiles, op.vertCount, op.output);
+	}
+
+	auto end = std::chrono::high_resolution_clock::now();
+	auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
+
+	size_t length = strlen (op.message);
+
+	snprintf (op.message + length, sizeof(op.message) - length, "%s completed in %ld ms\n",
+		name, (long) duration.count());
+}
+
+int function_Run (char * argv[], int threads)
+{
+	vector <pair<double,double> > input;
+	vector <RunOperation> operations;
+
+	if (!parseOperations (argv[3], operations))
+	{
+		return -1;
+	}
+
+	if (!getCoordinatesFromFile (argv[2], input))
+	{
+		fprintf (stderr, "Cannot open %s\n", argv[2]);
+		return -1;
+	}
+
+	printf ("Input: %ld coordinates\n", input.size());
+
+	if (input.size() == 0)
+	{
+		fprintf (stderr, "No valid coordinates found in %s\n", argv[2]);
+		return -1;
+	}
+
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+
+	// unit vectors are shared by all operations.
+
+	vector <MapObject> objects (input.size(), MapObject (0, 0, 0));
+
+	Parallel::forEachPart ((long) input.size(), Parallel::threadCount (threads), [&] (int, long begin, long end)
+	{
+		for (long i = begin; i < end; i++)
+		{
+			objects[i] = MapObject (TLatLong (input[i].second, input[i].first));
+		}
+	});
+
+	vector <std::thread> workers;
+
+	for (size_t i = 1; i < operations.size(); i++)
+	{
+		workers.push_back (std::thread (runOperation, std::ref (operations[i]),
+			std::cref (input), std::cref (objects), threads));
+	}
+
+	runOperation (operations[0], input, objects, threads);
+
+	for (auto & worker : workers)
+	{
+		worker.join();
+	}
+
+	auto end = std::chrono::high_resolution_clock::now();
+	auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
+
+	const char * outFiles[] = { "area.geojson", "mincircle.geojson", "circle.geojson" };
+
+	for (auto & op : operations)
+	{
+		printf ("%s", op.message);
+
+		const char * outFile = outFiles[op.which];
+
+		if (op.ok && createOutput (outFile, op.output))
+		{
+			printf ("Successfully created %s with %ld coordinates\n", outFile, op.output.size());
+		}
+	}
+
+	printf ("run completed in %ld ms\n", (long) duration.count());
+
+	return 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+// same polygon as area creates for INPUT, as unit vectors. For radius 0 it is the hull.
+//////////////////////////////////////////////////////////////////////////////////////////
+
+static bool getAreaPolygon (const vector<pair<double,double> > & input, const double radiusMiles,
+                            const int vertCount, vector<MapObject> & polygon)
+{
+	vector <pair<double,double> > hull, output;
+
+	bool ret = false;
+
+	if (input.size() == 1)
+	{
+		TLatLong coord (input.front().second, input.front().first);
+
+		ret = GeoUtils::getPointsAroundCoordinate (coord, radiusMiles, vertCount, output);
+	}
+	else if (GeoUtils::getHullVertices (input, hull))
+	{
+		if (radiusMiles > 0)
+		{
+			ret = GeoUtils::bufferHull (hull, output, radiusMiles, vertCount);
+		}
+		else
+		{
+			output = hull;
+			ret = hull.size() > 2;
+		}
+	}
+
+	polygon.clear();
+
+	for (auto & pt : output)
+	{
+		polygon.push_back (MapObject (TLatLong (pt.second, pt.first)));
+	}
+
+	return ret;
+}
+
+static void addPolygon (const vector<MapObject> & polygon, vector<vector<pair<double,double> > > & polygons)
+{
+	polygons.push_back (vector<pair<double,double> > ());
+
+	for (auto & obj : polygon)
+	{
+		TLatLong ll = obj.GetLatLong();
+
+		polygons.back().push_back (make_pair (ll.Longitude(), ll.Latitude()));
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+// delaunay: Delaunay triangles of input points (delaunay.geojson) and their Voronoi cells
+// (voronoi.geojson), cut by the same polygon as area creates. Property "index" is line
+// number of the point in input (counting valid lines from 0).
+//////////////////////////////////////////////////////////////////////////////////////////
+
+int function_Delaunay (char * argv[])
+{
+	vector <pair<double,double> > input;
+	vector <double> pointRadiiKM;
+
+	int vertCount = atoi (argv[3]);
+
+	if (vertCount < 3)
+	{
+		printf ("Invalid vertex count. Must be integer greater than 2\n");
+		return -1;
+	}
+
+	double radiusMiles = atof (argv[4]) * 1000.0 / MapObject::MILE_2_METERS;
+
+	if (radiusMiles <= 0)
+	{
+		printf ("Invalid radius\n");
+		return -1;
+	}
+
+
+	if (!getCoordinatesFromFile (argv[2], input, pointRadiiKM))
+	{
+		fprintf (stderr, "Cannot open %s\n", argv[2]);
+		return -1;
+	}
+
+	printf ("Input: %ld coordinates\n", input.size());
+
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+
+	SphericalDelaunay delaunay;
+
+	if (!delaunay.build (input))
+	{
+		fprintf (stderr, "Need 4 or more different coordinates, not all on one circle\n");
+		return -1;
+	}
+
+	vector <vector<int> > triangles;
+
+	delaunay.triangles (triangles);
+
+	auto end = std::chrono::high_resolution_clock::now();
+	auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
+
+	printf ("delaunay completed in %ld ms: %ld triangles\n", (long) duration.count(), triangles.size());
+
+	if (delaunay.skippedCount() > 0)
+	{
+		printf ("%ld points coinciding with others after projection were skipped\n", delaunay.skippedCount());
+	}
+
+	vector <vector<pair<double,double> > > polygons;
+	vector <string> properties;
+
+	for (auto & t : triangles)
+	{
+		vector <MapObject> triangle;
+		char buffer[80];
+
+		for (int i : t) triangle.push_back (delaunay.point (i));
+
+		snprintf (buffer, sizeof(buffer), "\"index\" : [%d, %d, %d]", delaunay.inputIndex (t[0]),
+			delaunay.inputIndex (t[1]), delaunay.inputIndex (t[2]));
+
+		addPolygon (triangle, polygons);
+		properties.push_back (buffer);
+	}
+
+	const char outFile[] = "delaunay.geojson";
+
+	if (createCollectionOutput (outFile, polygons, properties))
+	{
+		printf ("Successfully created %s with %ld polygons\n", outFile, polygons.size());
+	}
+
+	// points all over the globe have no area polygon, cells are then not cut.
+
+	vector <MapObject> area;
+
+	getAreaPolygon (input, radiusMiles, vertCount, area);
+
+	polygons.clear();
+	properties.clear();
+
+	for (int i = 0; i < (int) delaunay.size(); i++)
+	{
+		vector <MapObject> cell, clipped;
+		char buffer[40];
+
+		if (!delaunay.voronoiCell (i, cell))
+		{
+			continue;
+		}
+
+		// cell within radius from its point is inside of area.
+
+		bool inside = true;
+
+		for (auto & corner : cell)
+		{
+			if (corner.GetAirDistance (delaunay.point (i)) > radiusMiles) inside = false;
+		}
+
+		if (inside || area.empty())
+		{
+			clipped = cell;
+		}
+		else
+		{
+			SphericalDelaunay::clip (cell, area, clipped);
+		}
+
+		if (clipped.size() < 3)
+		{
+			continue;
+		}
+
+		snprintf (buffer, sizeof(buffer), "\"index\" : %d", delaunay.inputIndex (i));
+
+		addPolygon (clipped, polygons);
+		properties.push_back (buffer);
+	}
+
+	const char cellFile[] = "voronoi.geojson";
+
+	if (createCollectionOutput (cellFile, polygons, properties))
+	{
+		printf ("Successfully created %s with %ld polygons\n", cellFile, polygons.size());
+	}
+
+	return 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+// gap: largest circle with center inside of the hull of input (or area around it, when
+// radius is given) and no input point inside. Written to gap.geojson.
+//////////////////////////////////////////////////////////////////////////////////////////
+
+int function_Gap (int argc, char * argv[])
+{
+	vector <pair<double,double> > input;
+	vector <pair<double,double> > output;
+	vector <double> pointRadiiKM;
+
+	int vertCount = atoi (argv[3]);
+
+	if (vertCount < 3)
+	{
+		printf ("Invalid vertex count. Must be integer greater than 2\n");
+		return -1;
+	}
+
+	double radiusMiles = (argc > 4) ? atof (argv[4]) * 1000.0 / MapObject::MILE_2_METERS : 0;
+
+	if (!getCoordinatesFromFile (argv[2], input, pointRadiiKM))
+	{
+		fprintf (stderr, "Cannot open %s\n", argv[2]);
+		return -1;
+	}
+
+	printf ("Input: %ld coordinates\n", input.size());
+
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+
+	SphericalDelaunay delaunay;
+
+	if (!delaunay.build (input))
+	{
+		fprintf (stderr, "Need 4 or more different coordinates, not all on one circle\n");
+		return -1;
+	}
+
+	vector <MapObject> region;
+
+	getAreaPolygon (input, radiusMiles, vertCount, region);
+
+	MapObject center (0, 0, 1);
+	double angle = 0;
+
+	// points all over the globe have no hull, and the whole sphere is searched. Hull of points
+	// on one line has no area, only area around them can be searched.
+
+	if (!delaunay.largestEmptyCircle (region, center, angle))
+	{
+		fprintf (stderr, (radiusMiles > 0) ? "No empty circle found\n" :
+			"No empty circle found in hull of input (points on one line need radius)\n");
+		return -1;
+	}
+
+	auto end = std::chrono::high_resolution_clock::now();
+	auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
+
+	printf ("gap completed in %ld ms\n", (long) duration.count());
+
+	TLatLong coord = center.GetLatLong();
+	double gapMiles = angle * MapObject::EARTH_RADIUS;
+
+	printf ("Gap (%lf %lf) Radius: %lf miles (%lf km)\n", coord.Latitude(), coord.Longitude(),
+		gapMiles, gapMiles * MapObject::MILE_2_METERS / 1000.0);
+
+	if (GeoUtils::getPointsAroundCoordinate (coord, gapMiles, vertCount, output))
+	{
+		const char outFile[] = "gap.geojson";
+
+		if (createOutput (outFile, output))
+		{
+			printf ("Successfully created %s with %ld coordinates\n", outFile, output.size());
+		}
+	}
+
+	return 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+// concave: alpha shape of points around input coordinates (the same as area uses), so
+// about the area within radius of points, where gaps narrower than 2 * alpha are filled
+// and wider ones are not. Alpha (km) must be larger than radius. Written to concave.geojson.
+//////////////////////////////////////////////////////////////////////////////////////////
+
+int function_Concave (char * argv[])
+{
+	vector <pair<double,double> > input;
+	vector <pair<double,double> > rings;
+	vector <double> pointRadiiKM;
+
+	int vertCount = atoi (argv[3]);
+
+	if (vertCount < 3)
+	{
+		printf ("Invalid vertex count. Must be integer greater than 2\n");
+		return -1;
+	}
+
+	double radiusMiles = atof (argv[4]) * 1000.0 / MapObject::MILE_2_METERS;
+	double alphaMiles = atof (argv[5]) * 1000.0 / MapObject::MILE_2_METERS;
+
+	// points around each coordinate are on circle of the true radius, their triangles must stay.
+
+	double trueRadius = MapObject::getTrueRadius (radiusMiles, vertCount);
+
+	if (radiusMiles <= 0 || alphaMiles <= trueRadius)
+	{
+		fprintf (stderr, "Alpha must be larger than radius (%lf km)\n", trueRadius * MapObject::MILE_2_METERS / 1000.0);
+		return -1;
+	}
+
+	if (!getCoordinatesFromFile (argv[2], input, pointRadiiKM))
+	{
+		fprintf (stderr, "Cannot open %s\n", argv[2]);
+		return -1;
+	}
+
+	printf ("Input: %ld coordinates\n", input.size());
+
+	if (input.size() == 0)
+	{
+		fprintf (stderr, "No valid coordinates found in %s\n", argv[2]);
+		return -1;
+	}
+
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+
+	for (auto & pt : input)
+	{
+		GeoUtils::getPointsAroundCoordinate (TLatLong (pt.second, pt.first), radiusMiles, vertCount, rings);
+	}
+
+	SphericalDelaunay delaunay;
+
+	if (!delaunay.build (rings))
+	{
+		return -1;
+	}
+
+	vector <vector<vector<int> > > shape;
+
+	delaunay.alphaShape (alphaMiles / MapObject::EARTH_RADIUS, shape);
+
+	vector <vector<vector<pair<double,double> > > > polygons;
+
+	for (auto & polygon : shape)
+	{
+		polygons.push_back (vector<vector<pair<double,double> > > ());
+
+		for (auto & ring : polygon)
+		{
+			polygons.back().push_back (vector<pair<double,double> > ());
+
+			for (int i : ring)
+			{
+				polygons.back().back().push_back (rings[delaunay.inputIndex (i)]);
+			}
+		}
+	}
+
+	auto end = std::chrono::high_resolution_clock::now();
+	auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
+
+	printf ("concave completed in %ld ms: %ld polygons\n", (long) duration.count(), polygons.size());
+
+	const char outFile[] = "concave.geojson";
+
+	if (createMultiPolygonOutput (outFile, polygons))
+	{
+		printf ("Successfully created %s\n", outFile);
+	}
+
+	return 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+// union: area within radius of input points (union of circles around them, not their
+// hull). Written to union.geojson as multipolygon.
+//////////////////////////////////////////////////////////////////////////////////////////
+
+int function_Union (char * argv[])
+{
+	vector <pair<double,double> > input;
+	vector <double> pointRadiiKM;
+
+	int vertCount = atoi (argv[3]);
+
+	if (vertCount < 3)
+	{
+		printf ("Invalid vertex count. Must be integer greater than 2\n");
+		return -1;
+	}
+
+	double radiusMiles = atof (argv[4]) * 1000.0 / MapObject::MILE_2_METERS;
+
+	if (radiusMiles <= 0)
+	{
+		fprintf (stderr, "Radius must be greater than 0\n");
+		return -1;
+	}
+
+	if (!getCoordinatesFromFile (argv[2], input, pointRadiiKM))
+	{
+		fprintf (stderr, "Cannot open %s\n", argv[2]);
+		return -1;
+	}
+
+	printf ("Input: %ld coordinates\n", input.size());
+
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+
+	SphericalDelaunay delaunay;
+
+	// fewer than 4 points, or points on one circle, are not triangulated, but union of their
+	// circles is still found.
+
+	delaunay.build (input);
+
+	if (delaunay.size() == 0)
+	{
+		fprintf (stderr, "No coordinates in %s\n", argv[2]);
+		return -1;
+	}
+
+	vector <vector<vector<MapObject> > > shape;
+
+	delaunay.circlesUnion (radiusMiles / MapObject::EARTH_RADIUS, vertCount, shape);
+
+	vector <vector<vector<pair<double,double> > > > polygons;
+
+	for (auto & polygon : shape)
+	{
+		polygons.push_back (vector<vector<pair<double,double> > > ());
+
+		for (auto & ring : polygon)
+		{
+			addPolygon (ring, polygons.back());
+		}
+	}
+
+	auto end = std::chrono::high_resolution_clock::now();
+	auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
+
+	printf ("union completed in %ld ms: %ld polygons\n", (long) duration.count(), polygons.size());
+
+	const char outFile[] = "union.geojson";
+
+	if (createMultiPolygonOutput (outFile, polygons))
+	{
+		printf ("Successfully created %s\n", outFile);
+	}
+
+	return 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+// knn / within: for each line of query file, K nearest input points or those within
+// radius (km), from KdTree. Queries are split between threads. Output lines are
+// query,index,longitude,latitude,distance_km (query and index count valid lines from 0).
+//////////////////////////////////////////////////////////////////////////////////////////
+
+static bool writeQueryResults (const char * outFile, const pair<double,double> * input,
+                               const vector<vector<KdTree::Result> > & results)
+{
+	FILE * output = fopen (outFile, "w+t");
+
+	if (!output)
+	{
+		fprintf (stderr, "Cannot open %s for writing\n", outFile);
+		return false;
+	}
+
+	fprintf (output, "#query,index,longitude,latitude,distance_km\n");
+
+	long total = 0;
+
+	for (size_t q = 0; q < results.size(); q++)
+	{
+		for (auto & r : results[q])
+		{
+			fprintf (output, "%ld,%d,%.6lf,%.6lf,%.4lf\n", (long) q, r.second, input[r.second].first,
+				input[r.second].second, r.first * MapObject::MILE_2_METERS / 1000.0);
+		}
+
+		total += (long) results[q].size();
+	}
+
+	fclose (output);
+
+	printf ("Successfully created %s with %ld results\n", outFile, total);
+
+	return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+// index of input.csv saved for knn and within (see IndexFile).
+//////////////////////////////////////////////////////////////////////////////////////////
+
+int function_BuildIndex (int argc, char * argv[])
+{
+	vector <pair<double,double> > input;
+	vector <double> radiiKM;
+
+	if (!getCoordinatesFromFile (argv[2], input, radiiKM))
+	{
+		fprintf (stderr, "Cannot open %s\n", argv[2]);
+		return -1;
+	}
+
+	printf ("Input: %ld coordinates\n", input.size());
+
+	const char * outFile = (argc > 3) ? argv[3] : "index.idx";
+
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+
+	if (!IndexFile::write (outFile, input))
+	{
+		fprintf (stderr, "Cannot write %s\n", outFile);
+		return -1;
+	}
+
+	auto end = std::chrono::high_resolution_clock::now();
+
+	printf ("build-index completed in %ld ms\n",
+		(long) std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count());
+
+	printf ("Successfully created %s\n", outFile);
+
+	return 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+// tree of points in FILE: CSV file is read (into INPUT) and tree is built, file made by
+// build-index is mapped and used as is. Returns nullptr when file cannot be used.
+//////////////////////////////////////////////////////////////////////////////////////////
+
+static const KdTree * openIndex (const char * file, IndexFile & indexFile, KdTree & builtTree,
+                                 vector<pair<double,double> > & input)
+{
+	if (IndexFile::isIndexFile (file))
+	{
+		if (!indexFile.open (file))
+		{
+			fprintf (stderr, "Cannot use index %s (made on other machine or damaged)\n", file);
+			return nullptr;
+		}
+
+		return &indexFile.index();
+	}
+
+	vector <double> radiiKM;
+
+	if (!getCoordinatesFromFile (file, input, radiiKM))
+	{
+		fprintf (stderr, "Cannot open %s\n", file);
+		return nullptr;
+	}
+
+	builtTree.build (input);
+
+	return &builtTree;
+}
+
+int function_Query (int argc, char * argv[], int which, int threads)
+{
+	vector <pair<double,double> > input, queries;
+	vector <double> queryRadiiKM;
+
+	// which: 0 - knn, 1 - within.
+
+	int k = atoi (argv[4]);
+	double radiusMiles = atof (argv[4]) * 1000.0 / MapObject::MILE_2_METERS;
+
+	if ((which == 0 && k <= 0) || (which == 1 && radiusMiles <= 0))
+	{
+		printf ((which == 0) ? "Invalid count of neighbors\n" : "Invalid radius\n");
+		return -1;
+	}
+
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+
+	IndexFile indexFile;
+	KdTree builtTree;
+
+	const KdTree * tree = openIndex (argv[2], indexFile, builtTree, input);
+
+	if (!tree)
+	{
+		return -1;
+	}
+
+	auto built = std::chrono::high_resolution_clock::now();
+
+	if (!getCoordinatesFromFile (argv[3], queries, queryRadiiKM))
+	{
+		fprintf (stderr, "Cannot open %s\n", argv[3]);
+		return -1;
+	}
+
+	printf ("Input: %ld coordinates, %ld queries\n", tree->size(), (long) queries.size());
+
+	auto queried = std::chrono::high_resolution_clock::now();
+
+	vector <vector<KdTree::Result> > results (queries.size());
+
+	Parallel::forEachPart ((long) queries.size(), Parallel::threadCount (threads), [&] (int, long begin, long end)
+	{
+		for (long q = begin; q < end; q++)
+		{
+			MapObject obj (TLatLong (queries[q].second, queries[q].first));
+
+			if (which == 0)
+			{
+				tree->nearest (obj, k, results[q]);
+			}
+			else
+			{
+				tree->within (obj, radiusMiles, results[q]);
+			}
+		}
+	});
+
+	auto end = std::chrono::high_resolution_clock::now();
+
+	printf ("index ready in %ld ms, queries completed in %ld ms\n",
+		(long) std::chrono::duration_cast<std::chrono::milliseconds>(built - start).count(),
+		(long) std::chrono::duration_cast<std::chrono::milliseconds>(end - queried).count());
+
+	const char * outFile = (argc > 5) ? argv[5] : (which == 0) ? "knn.csv" : "within.csv";
+
+	return writeQueryResults (outFile, input.empty() ? indexFile.coordinateArray() : input.data(), results) ? 0 : -1;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+// points of input (CSV or index file) within radius of each query. Queries are read in
+// blocks (file of any size, or "-" for standard input), each block is searched in
+// parallel and written before next one is read. Output has line "query,count" for every
+// query, or "query,index" for every pair found (input indexes of a query ascending).
+//////////////////////////////////////////////////////////////////////////////////////////
+
+int function_Join (int argc, char * argv[], int threads, long blockSize)
+{
+	vector <pair<double,double> > input, block;
+
+	double radiusMiles = atof (argv[4]) * 1000.0 / MapObject::MILE_2_METERS;
+
+	if (radiusMiles <= 0)
+	{
+		printf ("Invalid radius\n");
+		return -1;
+	}
+
+	const char * mode = (argc > 5) ? argv[5] : "count";
+
+	bool pairs = (strcmp (mode, "pairs") == 0);
+
+	if (!pairs && strcmp (mode, "count") != 0)
+	{
+		printf ("Invalid output kind %s (expected count or pairs)\n", mode);
+		return -1;
+	}
+
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+
+	IndexFile indexFile;
+	KdTree builtTree;
+
+	const KdTree * tree = openIndex (argv[2], indexFile, builtTree, input);
+
+	if (!tree)
+	{
+		return -1;
+	}
+
+	auto built = std::chrono::high_resolution_clock::now();
+
+	CoordinateStream stream;
+
+	if (!stream.open (argv[3]))
+	{
+		fprintf (stderr, "Cannot open %s\n", argv[3]);
+		return -1;
+	}
+
+	const char * outFile = (argc > 6) ? argv[6] : "join.csv";
+
+	FILE * output = fopen (outFile, "w+t");
+
+	if (!output)
+	{
+		fprintf (stderr, "Cannot open %s for writing\n", outFile);
+		return -1;
+	}
+
+	fprintf (output, pairs ? "#query,index\n" : "#query,count\n");
+
+	int threadCount = Parallel::threadCount (threads);
+
+	long queryCount = 0, total = 0;
+
+	vector <long> counts;
+	vector <vector<int> > found;
+
+	block.reserve (blockSize);
+
+	while (stream.readBlock (block, blockSize))
+	{
+		long size = (long) block.size();
+
+		counts.assign (size, 0);
+
+		if (pairs)
+		{
+			found.resize (size);
+		}
+
+		Parallel::forEachPart (size, threadCount, [&] (int, long begin, long end)
+		{
+			for (long q = begin; q < end; q++)
+			{
+				MapObject obj (TLatLong (block[q].second, block[q].first));
+
+				if (pairs)
+				{
+					tree->indexesWithin (obj, radiusMiles, found[q]);
+					sort (found[q].begin(), found[q].end());
+					counts[q] = (long) found[q].size();
+				}
+				else
+				{
+					counts[q] = tree->countWithin (obj, radiusMiles);
+				}
+			}
+		});
+
+		for (long q = 0; q < size; q++)
+		{
+			if (pairs)
+			{
+				for (int index : found[q])
+				{
+					fprintf (output, "%ld,%d\n", queryCount + q, index);
+				}
+			}
+			else
+			{
+				fprintf (output, "%ld,%ld\n", queryCount + q, counts[q]);
+			}
+
+			total += counts[q];
+		}
+
+		queryCount += size;
+
+		block.clear();
+	}
+
+	fclose (output);
+
+	auto end = std::chrono::high_resolution_clock::now();
+
+	printf ("Input: %ld coordinates, %ld queries\n", tree->size(), queryCount);
+
+	printf ("index ready in %ld ms, join completed in %ld ms\n",
+		(long) std::chrono::duration_cast<std::chrono::milliseconds>(built - start).count(),
+		(long) std::chrono::duration_cast<std::chrono::milliseconds>(end - built).count());
+
+	printf ("Successfully created %s with %ld pairs\n", outFile, total);
+
+	return 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+// points of second file inside of area of input (polygon from area, or hull when radius
+// is 0). Points are read in blocks, so file may be of any size (or "-"), and those inside
+// are written to output in input format.
+//////////////////////////////////////////////////////////////////////////////////////////
+
+int function_Contains (int argc, char * argv[], int threads, long blockSize)
+{
+	vector <pair<double,double> > input, block;
+	vector <double> radiiKM;
+	vector <MapObject> area;
+
+	int vertCount = atoi (argv[3]);
+	double radiusMiles = atof (argv[4]) * 1000.0 / MapObject::MILE_2_METERS;
+
+	if (vertCount < 3 || radiusMiles < 0)
+	{
+		printf ("Invalid vertex count or radius\n");
+		return -1;
+	}
+
+	if (!getCoordinatesFromFile (argv[2], input, radiiKM))
+	{
+		fprintf (stderr, "Cannot open %s\n", argv[2]);
+		return -1;
+	}
+
+	printf ("Input: %ld coordinates\n", input.size());
+
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+
+	ConvexPolygon polygon;
+
+	if (!getAreaPolygon (input, radiusMiles, vertCount, area) || !polygon.build (area))
+	{
+		fprintf (stderr, "Cannot create area of %s\n", argv[2]);
+		return -1;
+	}
+
+	CoordinateStream stream;
+
+	if (!stream.open (argv[5]))
+	{
+		fprintf (stderr, "Cannot open %s\n", argv[5]);
+		return -1;
+	}
+
+	const char * outFile = (argc > 6) ? argv[6] : "contains.csv";
+
+	FILE * output = fopen (outFile, "w+t");
+
+	if (!output)
+	{
+		fprintf (stderr, "Cannot open %s for writing\n", outFile);
+		return -1;
+	}
+
+	long count = 0, insideCount = 0;
+
+	vector <char> inside;
+
+	block.reserve (blockSize);
+
+	while (stream.readBlock (block, blockSize))
+	{
+		polygon.contains (block, inside, threads);
+
+		for (size_t i = 0; i < block.size(); i++)
+		{
+			if (!inside[i]) continue;
+
+			fprintf (output, "%.6lf,%.6lf\n", block[i].first, block[i].second);
+			insideCount++;
+		}
+
+		count += block.size();
+
+		block.clear();
+	}
+
+	fclose (output);
+
+	auto end = std::chrono::high_resolution_clock::now();
+
+	printf ("Points: %ld, inside of area (%ld vertices): %ld\n", count, (long) polygon.size(), insideCount);
+
+	printf ("contains completed in %ld ms\n",
+		(long) std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count());
+
+	printf ("Successfully created %s\n", outFile);
+
+	return 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+// fences file has lines "name,longitude,latitude,radius_km" (circle) and
+// "name,longitude,latitude" (vertex of convex polygon, consecutive lines with the same name).
+//////////////////////////////////////////////////////////////////////////////////////////
+
+static bool readGeofences (const char * filename, GeofenceIndex & index)
+{
+	FILE * input = fopen (filename, "rt");
+
+	if (!input)
+	{
+		fprintf (stderr, "Cannot open %s\n", filename);
+		return false;
+	}
+
+	char buffer[256];
+	long line = 0;
+
+	string polygonName;
+	vector <MapObject> polygon;
+
+	auto addPolygon = [&] () -> bool
+	{
+		if (polygon.empty()) return true;
+
+		if (index.addPolygon (polygonName, polygon) < 0)
+		{
+			fprintf (stderr, "Fence %s in %s is not convex polygon\n", polygonName.c_str(), filename);
+			return false;
+		}
+
+		polygon.clear();
+		return true;
+	};
+
+	bool ok = true;
+
+	while (ok && fgets (buffer, sizeof(buffer), input))
+	{
+		line++;
+
+		if (buffer[0] == '#' || buffer[0] == '\n' || buffer[0] == '\r') continue;
+
+		char name[64];
+		double longitude, latitude, radiusKM;
+
+		int ret = sscanf (buffer, "%63[^,],%lf,%lf,%lf", name, &longitude, &latitude, &radiusKM);
+
+		if (ret < 3)
+		{
+			fprintf (stderr, "Invalid line %ld in %s\n", line, filename);
+			ok = false;
+		}
+		else if (ret == 4)
+		{
+			ok = addPolygon();
+
+			index.addCircle (name, TLatLong (latitude, longitude), radiusKM * 1000.0 / MapObject::MILE_2_METERS);
+		}
+		else
+		{
+			if (polygonName != name)
+			{
+				ok = addPolygon();
+				polygonName = name;
+			}
+
+			polygon.push_back (MapObject (TLatLong (latitude, longitude)));
+		}
+	}
+
+	fclose (input);
+
+	return ok && addPolygon();
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+// positions "id,longitude,latitude" (like for track) are checked one by one against
+// fences, and line "position,id,fence,enter" or "...,exit" is written whenever set of
+// fences containing the vehicle changes. With "-" as input (live stream) output is
+// flushed right after each change.
+//////////////////////////////////////////////////////////////////////////////////////////
+
+int function_Geofence (int argc, char * argv[])
+{
+	GeofenceIndex index;
+
+	if (!readGeofences (argv[2], index))
+	{
+		return -1;
+	}
+
+	CoordinateStream stream;
+
+	if (!stream.open (argv[3]))
+	{
+		fprintf (stderr, "Cannot open %s\n", argv[3]);
+		return -1;
+	}
+
+	const char * outFile = (argc > 4) ? argv[4] : "events.csv";
+
+	FILE * output = (strcmp (outFile, "-") == 0) ? stdout : fopen (outFile, "w+t");
+
+	if (!output)
+	{
+		fprintf (stderr, "Cannot open %s for writing\n", outFile);
+		return -1;
+	}
+
+	bool live = (strcmp (argv[3], "-") == 0);
+
+	fprintf (output, "#position,id,fence,event\n");
+
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+
+	unordered_map <string, int> vehicles;
+	vector <string> ids;
+	vector <vector<int> > insideOf;     // fences containing each vehicle, ascending.
+	vector <int> found;
+
+	const char * line;
+	size_t length;
+	long positions = 0, invalid = 0, events = 0;
+
+	while (stream.nextLine (line, length))
+	{
+		if (line[0] == '#' || length == 0) continue;
+
+		char id[64];
+		double longitude, latitude;
+
+		if (sscanf (line, "%63[^,],%lf,%lf", id, &longitude, &latitude) != 3)
+		{
+			invalid++;
+			continue;
+		}
+
+		auto it = vehicles.find (id);
+
+		if (it == vehicles.end())
+		{
+			it = vehicles.insert (make_pair (string (id), (int) ids.size())).first;
+			ids.push_back (id);
+			insideOf.push_back (vector<int> ());
+		}
+
+		index.find (longitude, latitude, found);
+
+		vector<int> & before = insideOf[it->second];
+
+		if (found != before)
+		{
+			for (int fence : before)
+			{
+				if (binary_search (found.begin(), found.end(), fence)) continue;
+
+				fprintf (output, "%ld,%s,%s,exit\n", positions, id, index.name (fence).c_str());
+				events++;
+			}
+
+			for (int fence : found)
+			{
+				if (binary_search (before.begin(), before.end(), fence)) continue;
+
+				fprintf (output, "%ld,%s,%s,enter\n", positions, id, index.name (fence).c_str());
+				events++;
+			}
+
+			before.swap (found);
+
+			if (live) fflush (output);
+		}
+
+		positions++;
+	}
+
+	if (output != stdout)
+	{
+		fclose (output);
+	}
+
+	auto end = std::chrono::high_resolution_clock::now();
+	long ms = (long) std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
+
+	fprintf (stderr, "Input: %ld fences, %ld positions of %ld vehicles (%ld invalid lines)\n",
+		(long) index.size(), positions, (long) ids.size(), invalid);
+
+	fprintf (stderr, "geofence completed in %ld ms, %ld events\n", ms, events);
+
+	if (output != stdout)
+	{
+		printf ("Successfully created %s\n", outFile);
+	}
+
+	return 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+// polylines file has lines "name,longitude,latitude", consecutive lines with the same name
+// are points of one polyline.
+//////////////////////////////////////////////////////////////////////////////////////////
+
+static bool readPolylines (const char * filename, vector<string> & names, vector<vector<MapObject> > & polylines)
+{
+	FILE * input = fopen (filename, "rt");
+
+	if (!input)
+	{
+		fprintf (stderr, "Cannot open %s\n", filename);
+		return false;
+	}
+
+	char buffer[256];
+	long line = 0;
+
+	while (fgets (buffer, sizeof(buffer), input))
+	{
+		line++;
+
+		if (buffer[0] == '#' || buffer[0] == '\n' || buffer[0] == '\r') continue;
+
+		char name[64];
+		double longitude, latitude;
+
+		if (sscanf (buffer, "%63[^,],%lf,%lf", name, &longitude, &latitude) != 3)
+		{
+			fprintf (stderr, "Invalid line %ld in %s\n", line, filename);
+			fclose (input);
+			return false;
+		}
+
+		if (names.empty() || names.back() != name)
+		{
+			names.push_back (name);
+			polylines.push_back (vector<MapObject> ());
+		}
+
+		polylines.back().push_back (MapObject (TLatLong (latitude, longitude)));
+	}
+
+	fclose (input);
+
+	return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+// each fix (read in blocks, file of any size or "-") is snapped to the nearest segment of
+// polylines, when it is not farther than given distance (0 means any). Output has line
+// "fix,line,segment,longitude,latitude,distance_km" for every fix snapped, with the
+// closest point of the segment.
+//////////////////////////////////////////////////////////////////////////////////////////
+
+int function_Snap (int argc, char * argv[], int threads, long blockSize)
+{
+	vector <string> names;
+	vector <vector<MapObject> > polylines;
+	vector <pair<double,double> > block;
+
+	double maxMiles = atof (argv[4]) * 1000.0 / MapObject::MILE_2_METERS;
+
+	if (maxMiles < 0)
+	{
+		printf ("Invalid distance\n");
+		return -1;
+	}
+
+	SegmentIndex index;
+
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+
+	if (!readPolylines (argv[2], names, polylines))
+	{
+		return -1;
+	}
+
+	for (size_t line = 0; line < polylines.size(); line++)
+	{
+		index.addPolyline ((int) line, polylines[line]);
+	}
+
+	index.build();
+
+	auto built = std::chrono::high_resolution_clock::now();
+
+	CoordinateStream stream;
+
+	if (!stream.open (argv[3]))
+	{
+		fprintf (stderr, "Cannot open %s\n", argv[3]);
+		return -1;
+	}
+
+	const char * outFile = (argc > 5) ? argv[5] : "snap.csv";
+
+	FILE * output = fopen (outFile, "w+t");
+
+	if (!output)
+	{
+		fprintf (stderr, "Cannot open %s for writing\n", outFile);
+		return -1;
+	}
+
+	fprintf (output, "#fix,line,segment,longitude,latitude,distance_km\n");
+
+	vector <SegmentIndex::Match> matches (blockSize);
+
+	long count = 0, snapped = 0;
+
+	block.reserve (blockSize);
+
+	while (stream.readBlock (block, blockSize))
+	{
+		index.nearest (block, maxMiles, matches.data(), threads);
+
+		for (size_t i = 0; i < block.size(); i++)
+		{
+			const SegmentIndex::Match & m = matches[i];
+
+			if (m.segment < 0) continue;
+
+			TLatLong ll = m.closest.GetLatLong();
+
+			fprintf (output, "%ld,%s,%d,%.6lf,%.6lf,%.4lf\n", count + (long) i, names[index.line (m.segment)].c_str(),
+				index.index (m.segment), ll.Longitude(), ll.Latitude(), m.distanceMiles * MapObject::MILE_2_METERS / 1000.0);
+
+			snapped++;
+		}
+
+		count += block.size();
+
+		block.clear();
+	}
+
+	fclose (output);
+
+	auto end = std::chrono::high_resolution_clock::now();
+
+	printf ("Input: %ld polylines, %ld segments, %ld fixes\n", (long) names.size(), (long) index.size(), count);
+
+	printf ("index built in %ld ms, snap completed in %ld ms\n",
+		(long) std::chrono::duration_cast<std::chrono::milliseconds>(built - start).count(),
+		(long) std::chrono::duration_cast<std::chrono::milliseconds>(end - built).count());
+
+	printf ("Successfully created %s with %ld of %ld fixes snapped\n", outFile, snapped, count);
+
+	return 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+// area within given distance (km) of polylines, like bus routes: one polygon for every
+// group of routes which touch, with holes where routes go around a block.
+//////////////////////////////////////////////////////////////////////////////////////////
+
+int function_Corridor (int argc, char * argv[], int threads)
+{
+	vector <string> names;
+	vector <vector<MapObject> > polylines;
+
+	int vertCount = atoi (argv[3]);
+
+	if (vertCount < 3)
+	{
+		printf ("Invalid vertex count. Must be integer greater than 2\n");
+		return -1;
+	}
+
+	double radiusMiles = atof (argv[4]) * 1000.0 / MapObject::MILE_2_METERS;
+
+	if (radiusMiles <= 0)
+	{
+		fprintf (stderr, "Radius must be greater than 0\n");
+		return -1;
+	}
+
+	if (!readPolylines (argv[2], names, polylines))
+	{
+		return -1;
+	}
+
+	long vertices = 0;
+
+	for (auto & line : polylines) vertices += (long) line.size();
+
+	printf ("Input: %ld polylines, %ld vertices\n", (long) polylines.size(), vertices);
+
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+
+	vector <vector<vector<MapObject> > > shape;
+
+	if (!Corridor::build (polylines, radiusMiles / MapObject::EARTH_RADIUS, vertCount, shape, threads))
+	{
+		fprintf (stderr, "Need polyline of 2 or more different points, and radius less than quarter of the globe\n");
+		return -1;
+	}
+
+	vector <vector<vector<pair<double,double> > > > polygons;
+
+	for (auto & polygon : shape)
+	{
+		polygons.push_back (vector<vector<pair<double,double> > > ());
+
+		for (auto & ring : polygon)
+		{
+			addPolygon (ring, polygons.back());
+		}
+	}
+
+	auto end = std::chrono::high_resolution_clock::now();
+	auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
+
+	printf ("corridor completed in %ld ms: %ld polygons\n", (long) duration.count(), polygons.size());
+
+	const char * outFile = (argc > 5) ? argv[5] : "corridor.geojson";
+
+	if (createMultiPolygonOutput (outFile, polygons))
+	{
+		printf ("Successfully created %s\n", outFile);
+	}
+
+	return 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+// checks polygons of GeoJSON file: rings must have 3 or more different positions (and be
+// closed, which is only counted), and must not cross or touch each other (or themselves)
+// within the same geometry. Output has line
+// "polygon,ring,segment,polygon,ring,segment,longitude,latitude" for every such pair of
+// segments, polygons numbered in order of the file (from 0, MultiPolygon has several).
+//////////////////////////////////////////////////////////////////////////////////////////
+
+int function_Validate (int argc, char * argv[], int threads)
+{
+	vector <vector<vector<pair<double,double> > > > polygons;
+	vector <long> geometries;
+
+	if (!GeoJsonReader::readPolygons (argv[2], polygons, geometries))
+	{
+		return -1;
+	}
+
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+
+	SegmentIndex index;
+
+	vector <pair<long,long> > rings;     // polygon and ring of each line of index.
+
+	long shortRings = 0, openRings = 0;
+
+	for (size_t p = 0; p < polygons.size(); p++)
+	{
+		for (size_t r = 0; r < polygons[p].size(); r++)
+		{
+			const vector<pair<double,double> > & ring = polygons[p][r];
+
+			vector <MapObject> points;
+
+			for (auto & pt : ring)
+			{
+				points.push_back (MapObject (TLatLong (pt.second, pt.first)));
+			}
+
+			// rings written here (and by many other tools) do not repeat the first position,
+			// they are checked as closed.
+
+			if (!ring.empty() && ring.front() != ring.back())
+			{
+				points.push_back (points.front());
+				openRings++;
+			}
+
+			if (points.size() < 4)
+			{
+				printf ("Polygon %ld, ring %ld: less than 4 positions\n", (long) p, (long) r);
+				shortRings++;
+			}
+
+			index.addPolyline ((int) rings.size(), points);
+
+			rings.push_back (make_pair ((long) p, (long) r));
+		}
+	}
+
+	index.build();
+
+	vector <SegmentIndex::Crossing> crossings;
+
+	index.crossings (crossings, threads);
+
+	auto end = std::chrono::high_resolution_clock::now();
+	auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
+
+	printf ("Input: %ld polygons, %ld rings, %ld segments\n", (long) polygons.size(), (long) rings.size(),
+		(long) index.size());
+
+	const char * outFile = (argc > 3) ? argv[3] : "validate.csv";
+
+	FILE * output = fopen (outFile, "w+t");
+
+	if (!output)
+	{
+		fprintf (stderr, "Cannot open %s for writing\n", outFile);
+		return -1;
+	}
+
+	fprintf (output, "#polygon,ring,segment,polygon,ring,segment,longitude,latitude\n");
+
+	long count = 0;
+
+	for (auto & c : crossings)
+	{
+		const pair<long,long> & a = rings[index.line (c.first)];
+		const pair<long,long> & b = rings[index.line (c.second)];
+
+		// different features may overlap.
+
+		if (geometries[a.first] != geometries[b.first]) continue;
+
+		TLatLong ll = c.point.GetLatLong();
+
+		fprintf (output, "%ld,%ld,%d,%ld,%ld,%d,%.6lf,%.6lf\n", a.first, a.second, index.index (c.first),
+			b.first, b.second, index.index (c.second), ll.Longitude(), ll.Latitude());
+
+		count++;
+	}
+
+	fclose (output);
+
+	printf ("validate completed in %ld ms: %ld intersections, %ld short rings, %ld rings not closed\n",
+		(long) duration.count(), count, shortRings, openRings);
+
+	printf ("Successfully created %s\n", outFile);
+
+	return 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+// polygons of GeoJSON file (all geometries together) as rings of points.
+//////////////////////////////////////////////////////////////////////////////////////////
+
+static bool readArea (const char * filename, vector<vector<vector<MapObject> > > & area)
+{
+	vector <vector<vector<pair<double,double> > > > polygons;
+	vector <long> geometries;
+
+	if (!GeoJsonReader::readPolygons (filename, polygons, geometries))
+	{
+		return false;
+	}
+
+	for (auto & polygon : polygons)
+	{
+		area.push_back (vector<vector<MapObject> > ());
+
+		for (auto & ring : polygon)
+		{
+			area.back().push_back (vector<MapObject> ());
+
+			for (auto & pt : ring)
+			{
+				area.back().back().push_back (MapObject (TLatLong (pt.second, pt.first)));
+			}
+		}
+	}
+
+	return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+// union, intersection or difference of areas in two GeoJSON files, for example coverage
+// of two networks. Polygons within each file must not overlap. Written as multipolygon.
+//////////////////////////////////////////////////////////////////////////////////////////
+
+int function_Overlay (int argc, char * argv[], int threads)
+{
+	int operation;
+
+	if (strcmp (argv[2], "union") == 0)
+	{
+		operation = Overlay::UNION;
+	}
+	else if (strcmp (argv[2], "intersection") == 0)
+	{
+		operation = Overlay::INTERSECTION;
+	}
+	else if (strcmp (argv[2], "difference") == 0)
+	{
+		operation = Overlay::DIFFERENCE;
+	}
+	else
+	{
+		printf ("Invalid operation. Must be union, intersection or difference\n");
+		return -1;
+	}
+
+	vector <vector<vector<MapObject> > > a, b;
+
+	if (!readArea (argv[3], a) || !readArea (argv[4], b))
+	{
+		return -1;
+	}
+
+	long vertices = 0;
+
+	for (auto & polygon : a) for (auto & ring : polygon) vertices += (long) ring.size();
+	for (auto & polygon : b) for (auto & ring : polygon) vertices += (long) ring.size();
+
+	printf ("Input: %ld and %ld polygons, %ld vertices\n", (long) a.size(), (long) b.size(), vertices);
+
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+
+	vector <vector<vector<MapObject> > > shape;
+
+	Overlay::compute (operation, a, b, shape, threads);
+
+	vector <vector<vector<pair<double,double> > > > polygons;
+
+	for (auto & polygon : shape)
+	{
+		polygons.push_back (vector<vector<pair<double,double> > > ());
+
+		for (auto & ring : polygon)
+		{
+			addPolygon (ring, polygons.back());
+		}
+	}
+
+	auto end = std::chrono::high_resolution_clock::now();
+	auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
+
+	printf ("%s completed in %ld ms: %ld polygons\n", argv[2], (long) duration.count(), polygons.size());
+
+	const char * outFile = (argc > 5) ? argv[5] : "overlay.geojson";
+
+	if (createMultiPolygonOutput (outFile, polygons))
+	{
+		printf ("Successfully created %s\n", outFile);
+	}
+
+	return 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//
+//  Syntax:
+//
+//  (A) ./geojson area input.csv 12 50 
+//
+//  where input.csv is CSV file with longitude,latitude on each line.
+//  outputs output.geojson which can be visualized for example on www.geojson.io or similar sites.
+//  50 is distance in kilometers. The resulting output polygon will cover all coordinates and area
+//  around them within specified distance.
+//  12 is number of vertices to create around each input coordinate. The greater, the "rounder"
+//  will be output, at the expense of performance.
+//
+//  Vertex count and radius can be lists, like "12,24" and "5,10,25,50": hull is found once,
+//  and area.geojson is then feature collection with polygon for every combination.
+//
+//  Add "--threads N" to find the hull on N threads (0 means all cores).
+//  Add "--stream" for input larger than memory (or "-" as input for standard input),
+//  it is then read in blocks of 1M coordinates, or as set with "--block N".
+//
+//  Add "--deadline-ms N" to get result in about N milliseconds (counted from start): when hull
+//  is not found by then, area around coarse polygon which contains all points is created, and
+//  how far it may go beyond the exact area is printed. Mincircle then also returns the circle
+//  it has so far, enlarged to cover all points. Not used with "--stream".
+//
+//  when input has third column (radius in km around the point), area covers circle of that
+//  radius around each point; 50 is then used only for points without it.
+//
+//  Add "--metrics" to add area (km2) and perimeter (km) of each polygon to its properties
+//  (area.geojson is then always feature collection), and "--metrics-points points.csv" to
+//  also count points of points.csv inside of it. Same for hull-merge.
+//
+//  (B) ./geojson eqdist input.csv 12
+//
+//  (C) ./geojson mincircle input.csv 12
+//
+//  when input has third column (radius in km around the point), it is min circle
+//  containing all these circles.
+//
+//  (D) ./geojson hull shard.csv shard-hull.csv
+//      ./geojson hull-merge 12 50 shard1-hull.csv shard2-hull.csv ...
+//
+//  hull outputs only vertices of the hull of its input (in input format), hull-merge
+//  reads such files and writes area.geojson with the same polygon as area would create for all
+//  shards together (it may start at a different vertex).
+//
+//  (E) ./geojson coverage input.csv 12 50 changes.txt
+//
+//  area which is kept up to date while points are added ("+lon,lat" lines in changes.txt)
+//  and removed ("-lon,lat"). Line "=" writes area.geojson for current points.
+//
+//  (F) ./geojson run input.csv area:50:12,mincircle:64,eqdist:12
+//
+//  several of the above in one pass over input, running at the same time.
+//
+//  (G) ./geojson track fixes.csv 100 [track.csv]
+//      ./geojson track fixes.csv 600s
+//
+//  min circle of every vehicle's last 100 fixes (or last 600 seconds), after each fix.
+//
+//  (H) ./geojson delaunay input.csv 12 50
+//
+//  Delaunay triangles of input points (delaunay.geojson) and Voronoi cells around them
+//  (voronoi.geojson), cells cut by area polygon (12 vertices, 50 km) of the points.
+//
+//  (I) ./geojson gap input.csv 12 [50]
+//
+//  largest circle centered inside of the hull of points (or their area, with radius) which
+//  has no point inside: best place for a new station. Written to gap.geojson.
+//
+//  (J) ./geojson concave input.csv 12 50 100
+//
+//  like area (12 vertices, 50 km), but not convex: gaps between points wider than 2 * 100 km
+//  stay out of it. Written to concave.geojson as multipolygon.
+//
+//  (K) ./geojson union input.csv 12 50
+//
+//  area within 50 km of points (union of circles, with holes), 12 vertices per full circle.
+//  Written to union.geojson as multipolygon.
+//
+//  (L) ./geojson knn input.csv cities.txt 3 [knn.csv]
+//      ./geojson within input.csv cities.txt 10 [within.csv]
+//
+//  for each point in cities.txt, 3 nearest points of input.csv, or all within 10 km.
+//
+//  (M) ./geojson build-index input.csv [index.idx]
+//
+//  kd-tree of input.csv saved to index.idx, which knn and within then take instead of
+//  input.csv: it is mapped into memory and used without reading or building anything.
+//
+//  (N) ./geojson join input.csv cities.txt 10 [count | pairs] [join.csv]
+//
+//  for each point in cities.txt, how many points of input.csv (or index file) are within
+//  10 km, or all such pairs. cities.txt is read in blocks, so it may be of any size.
+//
+//  (O) ./geojson contains input.csv 12 50 points.csv [contains.csv]
+//
+//  points of points.csv which are inside of area of input.csv (12 vertices, 50 km; 0 km
+//  for the hull itself). points.csv is read in blocks, so it may be of any size.
+//
+//  (P) ./geojson geofence fences.csv positions.csv [events.csv]
+//
+//  enter and exit events of vehicles (positions "id,longitude,latitude", or - for live
+//  stream) for fences: circles "name,longitude,latitude,radius_km" and convex polygons
+//  (lines "name,longitude,latitude" with the same name).
+//
+//  (Q) ./geojson snap lines.csv fixes.csv 0.5 [snap.csv]
+//
+//  each fix snapped to the nearest segment of polylines (lines "name,longitude,latitude"
+//  with the same name), if it is within 0.5 km (0 for any distance).
+//
+//  (R) ./geojson corridor routes.csv 36 0.5 [corridor.geojson]
+//
+//  area within 0.5 km of polylines (lines "name,longitude,latitude" with the same name),
+//  36 vertices around each full circle. Routes which come close are merged, loops leave
+//  holes.
+//
+//  (S) ./geojson validate polygons.geojson [validate.csv]
+//
+//  rings of Polygon and MultiPolygon geometries which are too short, or cross or touch
+//  each other (listed with the point, each pair of segments once).
+//
+//  (T) ./geojson overlay intersection a.geojson b.geojson [overlay.geojson]
+//
+//  union, intersection or difference (a without b) of areas in two GeoJSON files, for
+//  example outputs of area for two networks.
+//
+///////////////////////////////////////////////////////////////////////////////////////////
+
+int main(int argc, char *argv[] )
+{
+	vector <pair<double,double> > input;
+	vector <pair<double,double> > output;
+
+	int function = -1;
+
+	int threads = 1;
+
+	const char * option = takeOption (argc, argv, "--threads");
+
+	if (option)
+	{
+		threads = atoi (option);
+
+		if (threads < 0)
+		{
+			printf ("Invalid thread count\n");
+			return EXIT_FAILURE;
+		}
+	}
+
+	bool stream = takeFlag (argc, argv, "--stream");
+
+	Deadline deadline;
+
+	option = takeOption (argc, argv, "--deadline-ms");
+
+	if (option)
+	{
+		long milliseconds = atol (option);
+
+		if (milliseconds <= 0)
+		{
+			printf ("Invalid deadline\n");
+			return EXIT_FAILURE;
+		}
+
+		deadline = Deadline (milliseconds);
+	}
+
+	long blockSize = 1 << 20;
+
+	option = takeOption (argc, argv, "--block");
+
+	if (option)
+	{
+		blockSize = atol (option);
+		stream = true;
+
+		if (blockSize <= 0)
+		{
+			printf ("Invalid block size\n");
+			return EXIT_FAILURE;
+		}
+	}
+
+	AreaMetrics metrics;
+
+	metrics.enabled = takeFlag (argc, argv, "--metrics");
+	metrics.points = takeOption (argc, argv, "--metrics-points");
+	metrics.threads = threads;
+	metrics.blockSize = blockSize;
+
+	if (metrics.points)
+	{
+		metrics.enabled = true;
+	}
+
+	if (argc > 1)
+	{
+		if (strcmp (argv[1], "area") == 0)
+		{
+			function = 0;
+		}
+		else if (strcmp (argv[1], "mincircle") == 0)
+		{
+			function = 1;
+		} 
+		else if (strcmp (argv[1], "eqdist") == 0)
+		{
+			function = 2;
+		}
+		else if (strcmp (argv[1], "hull") == 0)
+		{
+			function = 3;
+		}
+		else if (strcmp (argv[1], "hull-merge") == 0)
+		{
+			function = 4;
+		}
+		else if (strcmp (argv[1], "coverage") == 0)
+		{
+			function = 5;
+		}
+		else if (strcmp (argv[1], "run") == 0)
+		{
+			function = 6;
+		}
+		else if (strcmp (argv[1], "track") == 0)
+		{
+			function = 7;
+		}
+		else if (strcmp (argv[1], "delaunay") == 0)
+		{
+			function = 8;
+		}
+		else if (strcmp (argv[1], "gap") == 0)
+		{
+			function = 9;
+		}
+		else if (strcmp (argv[1], "concave") == 0)
+		{
+			function = 10;
+		}
+		else if (strcmp (argv[1], "union") == 0)
+		{
+			function = 11;
+		}
+		else if (strcmp (argv[1], "knn") == 0)
+		{
+			function = 12;
+		}
+		else if (strcmp (argv[1], "within") == 0)
+		{
+			function = 13;
+		}
+		else if (strcmp (argv[1], "build-index") == 0)
+		{
+			function = 14;
+		}
+		else if (strcmp (argv[1], "join") == 0)
+		{
+			function = 15;
+		}
+		else if (strcmp (argv[1], "contains") == 0)
+		{
+			function = 16;
+		}
+		else if (strcmp (argv[1], "geofence") == 0)
+		{
+			function = 17;
+		}
+		else if (strcmp (argv[1], "snap") == 0)
+		{
+			function = 18;
+		}
+		else if (strcmp (argv[1], "corridor") == 0)
+		{
+			function = 19;
+		}
+		else if (strcmp (argv[1], "validate") == 0)
+		{
+			function = 20;
+		}
+		else if (strcmp (argv[1], "overlay") == 0)
+		{
+			function = 21;
+		}
+	}
+
+	if (function < 0)
+	{
+		printf ("expected arguments: area | mincircle | eqdist | hull | hull-merge | coverage | run | track | delaunay | gap | concave | union | knn | within | build-index | join | contains | geofence | snap | corridor | validate | overlay\n" );
+		return EXIT_SUCCESS;
+	}
+
+	if (function == 0 && argc < 5)
+	{
+		printf ("Arguments: input (csv file), vertices count (greater than 2), radius in km\n");
+		printf ("For example:\n");
+		printf ("%s area input.csv 12 50\n", argv[0]);
+		return EXIT_SUCCESS;
+	}
+
+	if (function == 1 && argc < 4)
+	{
+		printf ("Arguments: input (csv file), vertices count (greater than 2)\n");
+		printf ("For example:\n");
+		printf ("%s mincircle input.csv 12\n", argv[0]);
+		return EXIT_SUCCESS;
+	}
 
 	if (function == 2 && argc < 4)
 	{
@@ -324,10 +3324,167 @@ int main(int argc, char *argv[] )
 		return EXIT_SUCCESS;
 	}
 
+	if (function == 3 && argc < 3)
+	{
+		printf ("Arguments: input (csv file), output (csv file, hull.csv by default)\n");
+		printf ("For example:\n");
+		printf ("%s hull shard1.csv shard1-hull.csv\n", argv[0]);
+		return EXIT_SUCCESS;
+	}
+
+	if (function == 4 && argc < 5)
+	{
+		printf ("Arguments: vertices count (greater than 2), radius in km, hull files (made by hull)\n");
+		printf ("For example:\n");
+		printf ("%s hull-merge 12 50 shard1-hull.csv shard2-hull.csv\n", argv[0]);
+		return EXIT_SUCCESS;
+	}
+
+	if (function == 5 && argc < 6)
+	{
+		printf ("Arguments: input (csv file), vertices count (greater than 2), radius in km, changes (file or -)\n");
+		printf ("For example:\n");
+		printf ("%s coverage input.csv 12 50 changes.txt\n", argv[0]);
+		return EXIT_SUCCESS;
+	}
+
+	if (function == 6 && argc < 4)
+	{
+		printf ("Arguments: input (csv file), operations (area:radius km:vertices, mincircle:vertices, eqdist:vertices)\n");
+		printf ("For example:\n");
+		printf ("%s run input.csv area:50:12,mincircle:64\n", argv[0]);
+		return EXIT_SUCCESS;
+	}
+
+	if (function == 7 && argc < 4)
+	{
+		printf ("Arguments: input (csv file with id,longitude,latitude[,time]), window (fixes count, or seconds like 600s), output (csv file, track.csv by default)\n");
+		printf ("For example:\n");
+		printf ("%s track fixes.csv 100\n", argv[0]);
+		return EXIT_SUCCESS;
+	}
+
+	if (function == 8 && argc < 5)
+	{
+		printf ("Arguments: input (csv file), vertices count (greater than 2), radius in km (to cut Voronoi cells)\n");
+		printf ("For example:\n");
+		printf ("%s delaunay input.csv 12 50\n", argv[0]);
+		return EXIT_SUCCESS;
+	}
+
+	if (function == 9 && argc < 4)
+	{
+		printf ("Arguments: input (csv file), vertices count (greater than 2), radius in km around hull (0 by default)\n");
+		printf ("For example:\n");
+		printf ("%s gap input.csv 36\n", argv[0]);
+		return EXIT_SUCCESS;
+	}
+
+	if (function == 10 && argc < 6)
+	{
+		printf ("Arguments: input (csv file), vertices count (greater than 2), radius in km, alpha in km (larger than radius)\n");
+		printf ("For example:\n");
+		printf ("%s concave input.csv 12 10 15\n", argv[0]);
+		return EXIT_SUCCESS;
+	}
+
+	if (function == 11 && argc < 5)
+	{
+		printf ("Arguments: input (csv file), vertices count (greater than 2), radius in km\n");
+		printf ("For example:\n");
+		printf ("%s union input.csv 36 5\n", argv[0]);
+		return EXIT_SUCCESS;
+	}
+
+	if (function == 12 && argc < 5)
+	{
+		printf ("Arguments: input (csv or index file), queries (csv file), count of neighbors, output (csv file, knn.csv by default)\n");
+		printf ("For example:\n");
+		printf ("%s knn input.csv cities.txt 3\n", argv[0]);
+		return EXIT_SUCCESS;
+	}
+
+	if (function == 13 && argc < 5)
+	{
+		printf ("Arguments: input (csv or index file), queries (csv file), radius in km, output (csv file, within.csv by default)\n");
+		printf ("For example:\n");
+		printf ("%s within input.csv cities.txt 10\n", argv[0]);
+		return EXIT_SUCCESS;
+	}
+
+	if (function == 14 && argc < 3)
+	{
+		printf ("Arguments: input (csv file), output (index file, index.idx by default)\n");
+		printf ("For example:\n");
+		printf ("%s build-index input.csv input.idx\n", argv[0]);
+		return EXIT_SUCCESS;
+	}
+
+	if (function == 15 && argc < 5)
+	{
+		printf ("Arguments: input (csv or index file), queries (csv file or -), radius in km, output kind (count or pairs, count by default), output (csv file, join.csv by default)\n");
+		printf ("For example:\n");
+		printf ("%s join input.csv cities.txt 10 count\n", argv[0]);
+		return EXIT_SUCCESS;
+	}
+
+	if (function == 16 && argc < 6)
+	{
+		printf ("Arguments: input (csv file), vertices count (greater than 2), radius in km (0 for hull), points (csv file or -), output (csv file, contains.csv by default)\n");
+		printf ("For example:\n");
+		printf ("%s contains input.csv 12 50 riders.csv\n", argv[0]);
+		return EXIT_SUCCESS;
+	}
+
+	if (function == 17 && argc < 4)
+	{
+		printf ("Arguments: fences (csv file), positions (csv file with id,longitude,latitude, or -), output (csv file or -, events.csv by default)\n");
+		printf ("For example:\n");
+		printf ("%s geofence fences.csv positions.csv events.csv\n", argv[0]);
+		return EXIT_SUCCESS;
+	}
+
+	if (function == 18 && argc < 5)
+	{
+		printf ("Arguments: polylines (csv file with name,longitude,latitude), fixes (csv file or -), max distance in km (0 for any), output (csv file, snap.csv by default)\n");
+		printf ("For example:\n");
+		printf ("%s snap rails.csv fixes.csv 0.5\n", argv[0]);
+		return EXIT_SUCCESS;
+	}
+
+	if (function == 19 && argc < 5)
+	{
+		printf ("Arguments: polylines (csv file with name,longitude,latitude), vertex count, radius in km, output (geojson file, corridor.geojson by default)\n");
+		printf ("For example:\n");
+		printf ("%s corridor routes.csv 36 0.5\n", argv[0]);
+		return EXIT_SUCCESS;
+	}
+
+	if (function == 20 && argc < 3)
+	{
+		printf ("Arguments: polygons (geojson file), output (csv file, validate.csv by default)\n");
+		printf ("For example:\n");
+		printf ("%s validate corridor.geojson\n", argv[0]);
+		return EXIT_SUCCESS;
+	}
+
+	if (function == 21 && argc < 5)
+	{
+		printf ("Arguments: operation (union, intersection or difference), two areas (geojson files), output (geojson file, overlay.geojson by default)\n");
+		printf ("For example:\n");
+		printf ("%s overlay difference planned.geojson existing.geojson\n", argv[0]);
+		return EXIT_SUCCESS;
+	}
+
+
+	if (function == 0 && (stream || strcmp (argv[2], "-") == 0))
+	{
+		return function_AreaStream (argv, threads, blockSize, metrics) < 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+	}
 
 	if (function == 0 || function == 1)
 	{
-		return function_Area_And_MinCircle (argv, function) < 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+		return function_Area_And_MinCircle (argv, function, threads, deadline, metrics) < 0 ? EXIT_FAILURE : EXIT_SUCCESS;
 	}
 
 	else if (function == 2)
@@ -335,5 +3492,95 @@ int main(int argc, char *argv[] )
 		return function_Equidistant (argv) < 0 ? EXIT_FAILURE : EXIT_SUCCESS;
 	}
 
+	else if (function == 3)
+	{
+		return function_Hull (argc, argv, threads) < 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+	}
+
+	else if (function == 4)
+	{
+		return function_HullMerge (argc, argv, threads, metrics) < 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+	}
+
+	else if (function == 5)
+	{
+		return function_Coverage (argv) < 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+	}
+
+	else if (function == 6)
+	{
+		return function_Run (argv, threads) < 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+	}
+
+	else if (function == 7)
+	{
+		return function_Track (argc, argv, threads) < 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+	}
+
+	else if (function == 8)
+	{
+		return function_Delaunay (argv) < 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+	}
+
+	else if (function == 9)
+	{
+		return function_Gap (argc, argv) < 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+	}
+
+	else if (function == 10)
+	{
+		return function_Concave (argv) < 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+	}
+
+	else if (function == 11)
+	{
+		return function_Union (argv) < 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+	}
+
+	else if (function == 12 || function == 13)
+	{
+		return function_Query (argc, argv, function - 12, threads) < 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+	}
+
+	else if (function == 14)
+	{
+		return function_BuildIndex (argc, argv) < 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+	}
+
+	else if (function == 15)
+	{
+		return function_Join (argc, argv, threads, blockSize) < 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+	}
+
+	else if (function == 16)
+	{
+		return function_Contains (argc, argv, threads, blockSize) < 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+	}
+
+	else if (function == 17)
+	{
+		return function_Geofence (argc, argv) < 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+	}
+
+	else if (function == 18)
+	{
+		return function_Snap (argc, argv, threads, blockSize) < 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+	}
+
+	else if (function == 19)
+	{
+		return function_Corridor (argc, argv, threads) < 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+	}
+
+	else if (function == 20)
+	{
+		return function_Validate (argc, argv, threads) < 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+	}
+
+	else if (function == 21)
+	{
+		return function_Overlay (argc, argv, threads) < 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+	}
+
 	return EXIT_SUCCESS;
 }